@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <string.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "visage_graphics_c.h"
+
+// Replays a command stream saved with VisageCanvas_saveCommands on a windowless canvas and reports
+// how long recording and submitting the frame takes.
+// Usage: ReplayTool <commands file> [iterations]
+
+typedef struct {
+    void* data;
+    size_t size;
+} MappedFile;
+
+static int map_file(const char* path, MappedFile* file) {
+#ifdef _WIN32
+    FILE* handle = fopen(path, "rb");
+    if (handle == NULL)
+        return 0;
+
+    fseek(handle, 0, SEEK_END);
+    long size = ftell(handle);
+    fseek(handle, 0, SEEK_SET);
+
+    file->data = size > 0 ? malloc((size_t)size) : NULL;
+    file->size = (size_t)size;
+    int read = file->data != NULL && fread(file->data, 1, file->size, handle) == file->size;
+    fclose(handle);
+
+    if (!read) {
+        free(file->data);
+        return 0;
+    }
+    return 1;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    file->size = (size_t)info.st_size;
+    file->data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return file->data != MAP_FAILED;
+#endif
+}
+
+static void unmap_file(MappedFile* file) {
+#ifdef _WIN32
+    free(file->data);
+#else
+    munmap(file->data, file->size);
+#endif
+}
+
+static double now_ms(void) {
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <commands file> [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    int iterations = argc > 2 ? atoi(argv[2]) : 100;
+    if (iterations < 1)
+        iterations = 1;
+
+    MappedFile file;
+    if (!map_file(argv[1], &file)) {
+        printf("Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    int32_t width = 0;
+    int32_t height = 0;
+    float dpi_scale = 1.0f;
+    if (!VisageCommandStream_dimensions(file.data, file.size, &width, &height, &dpi_scale) || width <= 0 || height <= 0) {
+        printf("%s is not a command stream\n", argv[1]);
+        unmap_file(&file);
+        return 1;
+    }
+
+    VisageRenderer_checkInitialization(NULL, NULL);
+    if (!VisageRenderer_initialized()) {
+        printf("Failed to initialize renderer\n");
+        unmap_file(&file);
+        return 1;
+    }
+
+    VisageCanvas* canvas = VisageCanvas_new();
+    VisageCanvas_setWindowless(canvas, width, height);
+    VisageCanvas_setDpiScale(canvas, dpi_scale);
+    // Every iteration replays the same frame, which would otherwise only be submitted once.
+    VisageCanvas_setIdleFrameElision(canvas, false);
+    // Submit times are only measured when frames are replayed and submitted on this thread.
+    VisageCanvas_setAsyncSubmit(canvas, false);
+
+    double replay_total = 0.0;
+    double replay_min = 0.0;
+    double replay_max = 0.0;
+    double submit_total = 0.0;
+    double submit_min = 0.0;
+    double submit_max = 0.0;
+    int result = 0;
+
+    for (int i = 0; i < iterations; ++i) {
+        VisageCanvas_clearDrawnShapes(canvas);
+
+        double start = now_ms();
+        if (!VisageCanvas_replayMapped(canvas, file.data, file.size)) {
+            printf("Failed to replay %s\n", argv[1]);
+            result = 1;
+            break;
+        }
+        double replayed = now_ms();
+        VisageCanvas_submit(canvas, 0);
+        double submitted = now_ms();
+
+        double replay_time = replayed - start;
+        double submit_time = submitted - replayed;
+        replay_total += replay_time;
+        submit_total += submit_time;
+        replay_min = i == 0 || replay_time < replay_min ? replay_time : replay_min;
+        replay_max = replay_time > replay_max ? replay_time : replay_max;
+        submit_min = i == 0 || submit_time < submit_min ? submit_time : submit_min;
+        submit_max = submit_time > submit_max ? submit_time : submit_max;
+    }
+
+    if (result == 0) {
+        printf("%s: %dx%d @ %.2fx, %d iterations\n", argv[1], width, height, dpi_scale, iterations);
+        printf("replay: avg %.3f ms, min %.3f ms, max %.3f ms\n", replay_total / iterations, replay_min, replay_max);
+        printf("submit: avg %.3f ms, min %.3f ms, max %.3f ms\n", submit_total / iterations, submit_min, submit_max);
+    }
+
+    VisageCanvas_destroy(canvas);
+    unmap_file(&file);
+    return result;
+}
@@ -0,0 +1,132 @@
+#include "visage_graphics_c.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+
+// Set to 0 along with the library's when VISAGE_GRAPHICS_C_FRAME_STATS is turned off.
+#ifndef VISAGE_C_FRAME_STATS
+#define VISAGE_C_FRAME_STATS 1
+#endif
+
+namespace {
+    VisageFrameStats frame_stats(VisageCanvas* canvas) {
+        VisageFrameStats stats;
+        VisageCanvas_getFrameStats(canvas, &stats);
+        return stats;
+    }
+}
+
+#if VISAGE_C_FRAME_STATS
+
+TEST_CASE("Gradients are uploaded once across consecutive frames", "[frame_stats]") {
+    VisageCanvas* canvas = VisageCanvas_new();
+    VisageCanvas_setAsyncSubmit(canvas, false);
+    VisageBrush* brush = VisageBrush_new();
+    VisageBrush_horizontalFromTwo(brush, VisageColor_fromARGB(0xff000000), VisageColor_fromARGB(0xffffffff));
+
+    VisageCanvas_setBrush(canvas, brush);
+    uint64_t once = frame_stats(canvas).gradient_upload_bytes;
+    REQUIRE(once > 0);
+    VisageCanvas_setBrush(canvas, brush);
+    REQUIRE(frame_stats(canvas).gradient_upload_bytes == once);
+
+    // Still resident from the frame before.
+    VisageCanvas_clearDrawnShapes(canvas);
+    VisageCanvas_setBrush(canvas, brush);
+    REQUIRE(frame_stats(canvas).gradient_upload_bytes == 0);
+
+    // Unused for a whole frame.
+    VisageCanvas_clearDrawnShapes(canvas);
+    VisageCanvas_clearDrawnShapes(canvas);
+    VisageCanvas_setBrush(canvas, brush);
+    REQUIRE(frame_stats(canvas).gradient_upload_bytes == once);
+
+    VisageBrush_delete(brush);
+    VisageCanvas_destroy(canvas);
+}
+
+TEST_CASE("Glyphs are uploaded the first time they are drawn", "[frame_stats]") {
+    VisageCanvas* canvas = VisageCanvas_new();
+    VisageCanvas_setAsyncSubmit(canvas, false);
+    VisageFont* font = VisageFont_LatoRegular(23.0f, 1.0f);
+    VisageText* text = VisageText_new(font);
+    VisageText_setText(text, "frame");
+
+    VisageCanvas_text(canvas, text, 0.0f, 0.0f, 100.0f, 30.0f, 0);
+    uint64_t first = frame_stats(canvas).glyph_upload_bytes;
+    REQUIRE(first > 0);
+    VisageCanvas_text(canvas, text, 0.0f, 30.0f, 100.0f, 30.0f, 0);
+    REQUIRE(frame_stats(canvas).glyph_upload_bytes == first);
+
+    VisageText_setText(text, "frames");
+    VisageCanvas_text(canvas, text, 0.0f, 60.0f, 100.0f, 30.0f, 0);
+    REQUIRE(frame_stats(canvas).glyph_upload_bytes == first + first / 5);
+    REQUIRE(frame_stats(canvas).text_glyphs == 16);
+
+    VisageText_delete(text);
+    VisageFont_delete(font);
+    VisageCanvas_destroy(canvas);
+}
+
+TEST_CASE("Draw calls count what is handed to visage", "[frame_stats]") {
+    VisageCanvas* canvas = VisageCanvas_new();
+    VisageCanvas_setAsyncSubmit(canvas, false);
+
+    VisageCanvas_setColor(canvas, VisageColor_fromARGB(0xffff0000));
+    VisageCanvas_fill(canvas, 0.0f, 0.0f, 10.0f, 10.0f);
+    VisageCanvas_circle(canvas, 0.0f, 0.0f, 10.0f);
+    VisageCanvas_setPosition(canvas, 5.0f, 5.0f);
+    VisageCanvas_rectangle(canvas, 0.0f, 0.0f, 10.0f, 10.0f);
+
+    VisageFrameStats stats = frame_stats(canvas);
+    REQUIRE(stats.draw_calls == 3);
+    REQUIRE(stats.commands[VisageShapeCommandSetColor] == 1);
+    REQUIRE(stats.commands[VisageShapeCommandSetPosition] == 1);
+
+    VisageCanvas_clearDrawnShapes(canvas);
+    REQUIRE(frame_stats(canvas).draw_calls == 0);
+    VisageCanvas_destroy(canvas);
+}
+
+TEST_CASE("Frame time only counts time inside draw calls", "[frame_stats]") {
+    VisageCanvas* canvas = VisageCanvas_new();
+    VisageCanvas_setAsyncSubmit(canvas, false);
+
+    for (int i = 0; i < 100; ++i)
+        VisageCanvas_fill(canvas, 0.0f, 0.0f, 10.0f, 10.0f);
+    double recorded = frame_stats(canvas).frame_seconds;
+    REQUIRE(recorded > 0.0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    VisageCanvas_fill(canvas, 0.0f, 0.0f, 10.0f, 10.0f);
+    double after_sleep = frame_stats(canvas).frame_seconds;
+    REQUIRE(after_sleep > recorded);
+    REQUIRE(after_sleep < 0.05);
+
+    VisageCanvas_submit(canvas, 0);
+    REQUIRE(frame_stats(canvas).frame_seconds == after_sleep);
+    VisageCanvas_clearDrawnShapes(canvas);
+    REQUIRE(frame_stats(canvas).frame_seconds == 0.0);
+    VisageCanvas_destroy(canvas);
+}
+
+#else
+
+TEST_CASE("Frame stats compiled out are all zero", "[frame_stats]") {
+    VisageCanvas* canvas = VisageCanvas_new();
+    VisageCanvas_setAsyncSubmit(canvas, false);
+    VisageCanvas_fill(canvas, 0.0f, 0.0f, 10.0f, 10.0f);
+    VisageCanvas_submit(canvas, 0);
+
+    VisageFrameStats stats = frame_stats(canvas);
+    REQUIRE(stats.commands[VisageShapeCommandFill] == 0);
+    REQUIRE(stats.draw_calls == 0);
+    REQUIRE(stats.batches == 0);
+    REQUIRE(stats.frame_seconds == 0.0);
+    REQUIRE(stats.submit_seconds == 0.0);
+    REQUIRE(stats.peak_frame_bytes == 0);
+    VisageCanvas_destroy(canvas);
+}
+
+#endif
@@ -0,0 +1,55 @@
+#include "visage_graphics_c.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace {
+    constexpr int kWidth = 200;
+    constexpr int kHeight = 100;
+
+    VisageImageStats draw(VisageCanvas* canvas, VisageImage* image) {
+        VisageCanvas_image(canvas, image, 0.0f, 0.0f);
+        VisageCanvas_submit(canvas, 0);
+        VisageCanvas_clearDrawnShapes(canvas);
+
+        VisageImageStats stats;
+        VisageImage_getStats(image, &stats);
+        return stats;
+    }
+}
+
+TEST_CASE("Images convert only the changed pixels of each tile", "[image]") {
+    std::vector<uint32_t> pixels(kWidth * kHeight, 0xff204080);
+    VisageCanvas* canvas = VisageCanvas_new();
+    VisageCanvas_setAsyncSubmit(canvas, false);
+    VisageImage* image = VisageImage_new(pixels.data(), VisageImageFormatARGB8, kWidth, kHeight, 0);
+
+    VisageImageStats stats = draw(canvas, image);
+    REQUIRE(stats.tiles == 2);
+    REQUIRE(stats.tile_uploads == 2);
+    REQUIRE(stats.uploaded_pixels == kWidth * kHeight);
+
+    stats = draw(canvas, image);
+    REQUIRE(stats.tile_uploads == 2);
+    REQUIRE(stats.uploaded_pixels == kWidth * kHeight);
+
+    VisageImage_updateColumn(image, 150);
+    stats = draw(canvas, image);
+    REQUIRE(stats.tile_uploads == 3);
+    REQUIRE(stats.uploaded_pixels == kWidth * kHeight + kHeight);
+
+    VisageImage_updateRect(image, 120, 10, 20, 10);
+    VisageImage_updateRect(image, 4, 50, 2, 2);
+    stats = draw(canvas, image);
+    REQUIRE(stats.tile_uploads == 5);
+    REQUIRE(stats.uploaded_pixels == kWidth * kHeight + kHeight + 124 * 42 + 12 * 10);
+
+    VisageImage_updateRect(image, -10, -10, 5, 5);
+    VisageImage_updateRect(image, kWidth, 0, 10, 10);
+    stats = draw(canvas, image);
+    REQUIRE(stats.tile_uploads == 5);
+
+    VisageImage_delete(image);
+    VisageCanvas_destroy(canvas);
+}
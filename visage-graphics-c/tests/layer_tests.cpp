@@ -0,0 +1,69 @@
+#include "visage_graphics_c.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+    // Draws `layer` with whatever `draw` issues into it, on a canvas or a recording context, and
+    // returns how many times the cache rasterized it. The cache is shared, so only the difference is
+    // looked at.
+    template <typename Draw>
+    uint64_t rasterizations(Draw draw, bool in_context = false) {
+        VisageCanvas* parent = VisageCanvas_new();
+        VisageCanvas_setAsyncSubmit(parent, false);
+        VisageCanvas* canvas = in_context ? VisageCanvas_newRecordingContext(parent, 0) : parent;
+        VisageLayer* layer = VisageLayer_new(64.0f, 64.0f);
+        VisageFont* font = VisageFont_LatoRegular(12.0f, 1.0f);
+        VisageText* text = VisageText_new(font);
+        VisageText_setText(text, "label");
+
+        VisageCanvas_beginLayer(canvas, layer);
+        draw(canvas, text);
+        VisageCanvas_endRecording(canvas);
+
+        VisageLayerCacheStats before;
+        VisageLayerCache_getStats(&before);
+        VisageCanvas_drawLayer(canvas, layer, 0.0f, 0.0f);
+        VisageCanvas_drawLayer(canvas, layer, 10.0f, 10.0f);
+        VisageLayerCacheStats after;
+        VisageLayerCache_getStats(&after);
+
+        VisageText_delete(text);
+        VisageFont_delete(font);
+        VisageLayer_delete(layer);
+        if (in_context)
+            VisageCanvas_destroy(canvas);
+        VisageCanvas_destroy(parent);
+        return after.rasterizations - before.rasterizations;
+    }
+}
+
+TEST_CASE("Layers with text on top are rasterized once", "[layer]") {
+    REQUIRE(rasterizations([](VisageCanvas* canvas, VisageText* text) {
+        VisageCanvas_fill(canvas, 0.0f, 0.0f, 64.0f, 64.0f);
+        VisageCanvas_text(canvas, text, 0.0f, 0.0f, 64.0f, 16.0f, 0);
+    }) == 1);
+}
+
+TEST_CASE("Layers that draw over text are replayed", "[layer]") {
+    REQUIRE(rasterizations([](VisageCanvas* canvas, VisageText* text) {
+        VisageCanvas_text(canvas, text, 0.0f, 0.0f, 64.0f, 16.0f, 0);
+        VisageCanvas_fill(canvas, 0.0f, 0.0f, 64.0f, 64.0f);
+    }) == 0);
+}
+
+TEST_CASE("Layers with arcs or directional triangles are rasterized", "[layer]") {
+    REQUIRE(rasterizations([](VisageCanvas* canvas, VisageText*) {
+        VisageCanvas_fill(canvas, 0.0f, 0.0f, 64.0f, 64.0f);
+        VisageCanvas_arc(canvas, 0.0f, 0.0f, 64.0f, 4.0f, 0.0f, 1.0f, true);
+        VisageCanvas_flatArcShadow(canvas, 0.0f, 0.0f, 64.0f, 4.0f, 0.0f, 1.0f, 2.0f);
+    }) == 1);
+    REQUIRE(rasterizations([](VisageCanvas* canvas, VisageText*) {
+        VisageCanvas_triangleUp(canvas, 0.0f, 0.0f, 16.0f);
+    }) == 1);
+}
+
+TEST_CASE("Recording contexts draw layers", "[layer]") {
+    REQUIRE(rasterizations([](VisageCanvas* canvas, VisageText*) {
+        VisageCanvas_fill(canvas, 0.0f, 0.0f, 64.0f, 64.0f);
+    }, true) == 1);
+}
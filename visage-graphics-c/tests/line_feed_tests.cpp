@@ -0,0 +1,120 @@
+#include "visage_graphics_c.h"
+
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Samples are consecutive integers and the value range is as tall as the line, so every laid
+    // out y is exactly `kHeight - sample`. Floats hold integers exactly up to 2^24.
+    constexpr float kHeight = 16777216.0f;
+}
+
+TEST_CASE("Line feed pads until a full window is pushed", "[line_feed]") {
+    VisageLineFeed* feed = VisageLineFeed_new(8, 32);
+    VisageLineFeed_setValueRange(feed, 0.0f, kHeight);
+
+    float samples[] = { 1.0f, 2.0f, 3.0f };
+    REQUIRE(VisageLineFeed_push(feed, samples, 3) == 3);
+    VisageLine* line = VisageLineFeed_consume(feed, 7.0f, kHeight);
+    REQUIRE(VisageLine_getNumPoints(line) == 8);
+
+    const float* x = VisageLine_xValues(line);
+    const float* y = VisageLine_yValues(line);
+    for (int i = 0; i < 8; ++i)
+        REQUIRE(x[i] == static_cast<float>(i));
+    for (int i = 0; i < 5; ++i)
+        REQUIRE(y[i] == kHeight);
+    for (int i = 0; i < 3; ++i)
+        REQUIRE(y[5 + i] == kHeight - samples[i]);
+
+    VisageLineFeedStats stats;
+    VisageLineFeed_getStats(feed, &stats);
+    REQUIRE(stats.capacity == 32);
+    REQUIRE(stats.pushed == 3);
+    REQUIRE(stats.pending == 0);
+    VisageLineFeed_delete(feed);
+}
+
+TEST_CASE("Line feed drops what doesn't fit", "[line_feed]") {
+    VisageLineFeed* feed = VisageLineFeed_new(4, 16);
+    std::vector<float> samples(40, 0.5f);
+
+    REQUIRE(VisageLineFeed_push(feed, samples.data(), 40) == 16);
+    VisageLineFeed_consume(feed, 10.0f, 10.0f);
+    // The newest window stays in the ring.
+    REQUIRE(VisageLineFeed_push(feed, samples.data(), 40) == 12);
+
+    VisageLineFeedStats stats;
+    VisageLineFeed_getStats(feed, &stats);
+    REQUIRE(stats.pushed == 28);
+    REQUIRE(stats.dropped == 52);
+    REQUIRE(stats.overruns == 2);
+    REQUIRE(stats.pending == 12);
+    VisageLineFeed_delete(feed);
+}
+
+TEST_CASE("Line feed producer and consumer run concurrently", "[line_feed]") {
+    constexpr int kWindow = 256;
+    constexpr int kTotal = 1000000;
+    VisageLineFeed* feed = VisageLineFeed_new(kWindow, 1024);
+    VisageLineFeed_setValueRange(feed, 0.0f, kHeight);
+
+    std::atomic<bool> done { false };
+    // Pushes consecutive values in uneven blocks, retrying whatever didn't fit, so the ring always
+    // holds an unbroken sequence.
+    std::thread producer([feed, &done] {
+        float block[97];
+        int next = 1;
+        int block_size = 1;
+        while (next <= kTotal) {
+            int count = std::min(block_size, kTotal - next + 1);
+            for (int i = 0; i < count; ++i)
+                block[i] = static_cast<float>(next + i);
+            int written = VisageLineFeed_push(feed, block, count);
+            if (written == 0)
+                std::this_thread::yield();
+            next += written;
+            block_size = block_size % 97 + 1;
+        }
+        done = true;
+    });
+
+    float last_newest = 0.0f;
+    int windows = 0;
+    int torn_windows = 0;
+    bool finished = false;
+    while (!finished) {
+        finished = done;
+        VisageLine* line = VisageLineFeed_consume(feed, 100.0f, kHeight);
+        const float* y = VisageLine_yValues(line);
+
+        int first = 0;
+        while (first < kWindow && y[first] == kHeight)
+            ++first;
+        bool torn = false;
+        for (int i = first + 1; i < kWindow; ++i)
+            torn = torn || kHeight - y[i] != kHeight - y[i - 1] + 1.0f;
+
+        if (first < kWindow) {
+            float newest = kHeight - y[kWindow - 1];
+            torn = torn || newest < last_newest;
+            last_newest = newest;
+        }
+        torn_windows += torn ? 1 : 0;
+        ++windows;
+    }
+    producer.join();
+
+    REQUIRE(torn_windows == 0);
+
+    REQUIRE(last_newest == static_cast<float>(kTotal));
+    VisageLineFeedStats stats;
+    VisageLineFeed_getStats(feed, &stats);
+    REQUIRE(stats.pushed == kTotal);
+    REQUIRE(stats.pending == 0);
+    REQUIRE(windows > 1);
+    VisageLineFeed_delete(feed);
+}
@@ -0,0 +1,94 @@
+#include "visage_graphics_c.h"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+    // Integer samples with a value range as tall as the line make every laid out y exactly
+    // `kHeight - sample`.
+    constexpr float kHeight = 1000.0f;
+
+    std::vector<float> random_samples(int count, unsigned seed) {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<int> distribution(0, static_cast<int>(kHeight));
+        std::vector<float> samples(count);
+        for (float& sample : samples)
+            sample = static_cast<float>(distribution(random));
+        return samples;
+    }
+
+    VisageLinePyramid* make_pyramid(const std::vector<float>& samples) {
+        VisageLinePyramid* pyramid = VisageLinePyramid_new();
+        VisageLinePyramid_setSamples(pyramid, samples.data(), static_cast<int32_t>(samples.size()));
+        VisageLinePyramid_setValueRange(pyramid, 0.0f, kHeight);
+        return pyramid;
+    }
+
+    // Checks a layout against the minimum and maximum of every column computed from the samples.
+    void check_columns(VisageLinePyramid* pyramid, const std::vector<float>& samples, int start, int count, int columns) {
+        VisageLine* line = VisageLinePyramid_layout(pyramid, start, count, static_cast<float>(columns), kHeight, 1.0f);
+        REQUIRE(line != nullptr);
+        REQUIRE(VisageLine_getNumPoints(line) == 2 * columns);
+
+        const float* y = VisageLine_yValues(line);
+        double samples_per_column = static_cast<double>(count) / columns;
+        for (int column = 0; column < columns; ++column) {
+            size_t begin = start + static_cast<size_t>(column * samples_per_column);
+            size_t end = std::max(begin + 1, start + static_cast<size_t>((column + 1) * samples_per_column));
+            float min = *std::min_element(samples.begin() + begin, samples.begin() + end);
+            float max = *std::max_element(samples.begin() + begin, samples.begin() + end);
+
+            float low = std::max(y[2 * column], y[2 * column + 1]);
+            float high = std::min(y[2 * column], y[2 * column + 1]);
+            REQUIRE(low == kHeight - min);
+            REQUIRE(high == kHeight - max);
+        }
+    }
+}
+
+TEST_CASE("Line pyramid columns match the samples", "[line_pyramid]") {
+    for (int num_samples : { 10000, 10007, 65536, 99999 }) {
+        std::vector<float> samples = random_samples(num_samples, num_samples);
+        VisageLinePyramid* pyramid = make_pyramid(samples);
+
+        check_columns(pyramid, samples, 0, num_samples, 100);
+        check_columns(pyramid, samples, 13, num_samples - 13, 137);
+        check_columns(pyramid, samples, num_samples / 3, num_samples / 2, 61);
+        VisageLinePyramid_delete(pyramid);
+    }
+}
+
+TEST_CASE("Line pyramid updates refresh the covering blocks", "[line_pyramid]") {
+    std::vector<float> samples = random_samples(50000, 1);
+    VisageLinePyramid* pyramid = make_pyramid(samples);
+
+    std::vector<float> update = random_samples(777, 2);
+    VisageLinePyramid_updateSamples(pyramid, 12345, update.data(), static_cast<int32_t>(update.size()));
+    std::copy(update.begin(), update.end(), samples.begin() + 12345);
+    check_columns(pyramid, samples, 0, static_cast<int>(samples.size()), 200);
+
+    // Clipped to the end.
+    VisageLinePyramid_updateSamples(pyramid, 49900, update.data(), static_cast<int32_t>(update.size()));
+    std::copy(update.begin(), update.begin() + 100, samples.begin() + 49900);
+    REQUIRE(VisageLinePyramid_numSamples(pyramid) == 50000);
+    check_columns(pyramid, samples, 0, static_cast<int>(samples.size()), 200);
+    VisageLinePyramid_delete(pyramid);
+}
+
+TEST_CASE("Line pyramid lays out few samples directly", "[line_pyramid]") {
+    std::vector<float> samples = random_samples(150, 3);
+    VisageLinePyramid* pyramid = make_pyramid(samples);
+
+    VisageLine* line = VisageLinePyramid_layout(pyramid, 10, 120, 100.0f, kHeight, 1.0f);
+    REQUIRE(line != nullptr);
+    REQUIRE(VisageLine_getNumPoints(line) == 120);
+    const float* y = VisageLine_yValues(line);
+    for (int i = 0; i < 120; ++i)
+        REQUIRE(y[i] == kHeight - samples[10 + i]);
+
+    REQUIRE(VisageLinePyramid_layout(pyramid, 150, 10, 100.0f, kHeight, 1.0f) == nullptr);
+    REQUIRE(VisageLinePyramid_layout(pyramid, 0, 10, 0.0f, kHeight, 1.0f) == nullptr);
+    VisageLinePyramid_delete(pyramid);
+}
@@ -0,0 +1,67 @@
+#include "visage_graphics_c.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("Line series y values are one block, series after series", "[line_series]") {
+    VisageLineSeries* series = VisageLineSeries_new(3, 16);
+    REQUIRE(VisageLineSeries_getNumSeries(series) == 3);
+    REQUIRE(VisageLineSeries_getNumPoints(series) == 16);
+
+    float* y = VisageLineSeries_yValues(series);
+    REQUIRE(y != nullptr);
+    for (int i = 0; i < 3; ++i)
+        REQUIRE(VisageLineSeries_seriesValues(series, i) == y + i * 16);
+    REQUIRE(VisageLineSeries_seriesValues(series, 3) == nullptr);
+    REQUIRE(VisageLineSeries_xValues(series) != nullptr);
+    VisageLineSeries_delete(series);
+}
+
+TEST_CASE("Resizing a line series resets its values", "[line_series]") {
+    VisageLineSeries* series = VisageLineSeries_new(2, 4);
+    float* x = VisageLineSeries_xValues(series);
+    float* y = VisageLineSeries_yValues(series);
+    for (int i = 0; i < 4; ++i)
+        x[i] = static_cast<float>(i);
+    for (int i = 0; i < 8; ++i)
+        y[i] = 1.0f;
+
+    VisageLineSeries_setNumPoints(series, 6);
+    x = VisageLineSeries_xValues(series);
+    y = VisageLineSeries_yValues(series);
+    for (int i = 0; i < 6; ++i)
+        REQUIRE(x[i] == 0.0f);
+    for (int i = 0; i < 12; ++i)
+        REQUIRE(y[i] == 0.0f);
+
+    VisageLineSeries_setNumPoints(series, 0);
+    REQUIRE(VisageLineSeries_xValues(series) == nullptr);
+    REQUIRE(VisageLineSeries_yValues(series) == nullptr);
+    VisageLineSeries_delete(series);
+}
+
+TEST_CASE("Line series without series have no values", "[line_series]") {
+    VisageLineSeries* series = VisageLineSeries_new(0, 8);
+    REQUIRE(VisageLineSeries_xValues(series) == nullptr);
+    REQUIRE(VisageLineSeries_yValues(series) == nullptr);
+    VisageLineSeries_delete(series);
+}
+
+TEST_CASE("Recorded line series outlive the series", "[line_series]") {
+    VisageCanvas* canvas = VisageCanvas_new();
+    VisageCanvas_setAsyncSubmit(canvas, false);
+    VisageDisplayList* list = VisageDisplayList_new();
+    VisageLineSeries* series = VisageLineSeries_new(2, 8);
+
+    VisageCanvas_lineSeries(canvas, series, 0.0f, 0.0f, 64.0f, 32.0f, 1.0f);
+    VisageCanvas_beginRecording(canvas, list);
+    VisageCanvas_lineSeries(canvas, series, 0.0f, 0.0f, 64.0f, 32.0f, 1.0f);
+    VisageCanvas_endRecording(canvas);
+    VisageCanvas_submit(canvas, 0);
+    VisageCanvas_clearDrawnShapes(canvas);
+    VisageLineSeries_delete(series);
+
+    VisageCanvas_drawDisplayList(canvas, list, 0.0f, 0.0f);
+    VisageCanvas_submit(canvas, 0);
+    VisageDisplayList_delete(list);
+    VisageCanvas_destroy(canvas);
+}
@@ -0,0 +1,91 @@
+#include "visage_graphics_c.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <vector>
+
+namespace {
+    // A power of two keeps `sample * kScale` exact, so the vector and scalar paths round the same.
+    constexpr float kScale = 1.0f / 32768.0f;
+    constexpr float kOffset = 0.5f;
+
+    template <typename T>
+    std::vector<char> interleaved(int count, int channels) {
+        std::vector<char> data(static_cast<size_t>(count) * channels * sizeof(T));
+        for (int i = 0; i < count * channels; ++i) {
+            T value = static_cast<T>((i * 7919) % 65536 - 32768);
+            std::memcpy(data.data() + i * sizeof(T), &value, sizeof(T));
+        }
+        return data;
+    }
+
+    template <typename T>
+    void check_strided(int32_t type, int channels) {
+        for (int count : { 1, 3, 4, 5, 8, 9, 16, 31, 37, 256 }) {
+            std::vector<char> data = interleaved<T>(count, channels);
+            int stride = channels * static_cast<int>(sizeof(T));
+            VisageLine* line = VisageLine_new(count);
+
+            for (int channel = 0; channel < channels; ++channel) {
+                const char* start = data.data() + channel * sizeof(T);
+                REQUIRE(VisageLine_setFromStrided(line, VisageLineChannelY, start, type, stride, count, kScale, kOffset) == count);
+
+                const float* y = VisageLine_yValues(line);
+                for (int i = 0; i < count; ++i) {
+                    T value;
+                    std::memcpy(&value, start + i * stride, sizeof(T));
+                    REQUIRE(y[i] == static_cast<float>(value) * kScale + kOffset);
+                }
+            }
+            VisageLine_delete(line);
+        }
+    }
+}
+
+TEST_CASE("Strided samples convert like the scalar loop", "[line]") {
+    for (int channels : { 1, 2, 3 }) {
+        check_strided<float>(VisageSampleTypeFloat32, channels);
+        check_strided<double>(VisageSampleTypeFloat64, channels);
+        check_strided<int16_t>(VisageSampleTypeInt16, channels);
+        check_strided<int32_t>(VisageSampleTypeInt32, channels);
+    }
+}
+
+TEST_CASE("Strided samples are clipped to the line", "[line]") {
+    std::vector<char> data = interleaved<float>(16, 1);
+    VisageLine* line = VisageLine_new(10);
+    REQUIRE(VisageLine_setFromStrided(line, VisageLineChannelX, data.data(), VisageSampleTypeFloat32, sizeof(float), 16, 1.0f, 0.0f) == 10);
+    VisageLine_delete(line);
+}
+
+// Run with `VisageGraphicsCTests "[benchmark]"`.
+TEST_CASE("Strided sample throughput", "[.][benchmark]") {
+    constexpr int kCount = 4096;
+    std::vector<char> stereo = interleaved<int16_t>(kCount, 2);
+    std::vector<char> pairs = interleaved<double>(kCount, 2);
+    VisageLine* line = VisageLine_new(kCount);
+    float* y = VisageLine_yValues(line);
+
+    BENCHMARK("int16 stereo, scalar loop") {
+        const int16_t* samples = reinterpret_cast<const int16_t*>(stereo.data());
+        for (int i = 0; i < kCount; ++i)
+            y[i] = samples[2 * i] * kScale + kOffset;
+        return y[kCount - 1];
+    };
+    BENCHMARK("int16 stereo, setFromStrided") {
+        return VisageLine_setFromStrided(line, VisageLineChannelY, stereo.data(), VisageSampleTypeInt16,
+                                         2 * sizeof(int16_t), kCount, kScale, kOffset);
+    };
+    BENCHMARK("double xy pairs, scalar loop") {
+        const double* samples = reinterpret_cast<const double*>(pairs.data());
+        for (int i = 0; i < kCount; ++i)
+            y[i] = static_cast<float>(samples[2 * i + 1]) * kScale + kOffset;
+        return y[kCount - 1];
+    };
+    BENCHMARK("double xy pairs, setFromStrided") {
+        return VisageLine_setFromStrided(line, VisageLineChannelY, pairs.data() + sizeof(double), VisageSampleTypeFloat64,
+                                         2 * sizeof(double), kCount, kScale, kOffset);
+    };
+    VisageLine_delete(line);
+}
@@ -0,0 +1,252 @@
+#include "visage_graphics_c.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+    constexpr int kSize = 64;
+
+    VisageColor color(uint32_t argb) {
+        VisageColor result;
+        VisageColor_fromARGB_inner(argb, &result);
+        return result;
+    }
+
+    int channel(uint32_t argb, int shift) {
+        return static_cast<int>((argb >> shift) & 0xff);
+    }
+
+    // Records whatever `draw` issues on a fresh canvas and rasterizes it into a transparent target.
+    template <typename Draw>
+    VisageSoftwareRaster* rasterize(Draw draw) {
+        VisageCanvas* canvas = VisageCanvas_new();
+        VisageDisplayList* list = VisageDisplayList_new();
+        VisageCanvas_beginRecording(canvas, list);
+        draw(canvas);
+        VisageCanvas_endRecording(canvas);
+
+        VisageSoftwareRaster* raster = VisageSoftwareRaster_new(kSize, kSize);
+        VisageSoftwareRaster_drawDisplayList(raster, list, 0.0f, 0.0f);
+        VisageDisplayList_delete(list);
+        VisageCanvas_destroy(canvas);
+        return raster;
+    }
+
+    uint32_t pixel(VisageSoftwareRaster* raster, int x, int y) {
+        return VisageSoftwareRaster_pixels(raster)[y * kSize + x];
+    }
+}
+
+TEST_CASE("Software raster fills rectangles", "[software_raster]") {
+    VisageSoftwareRaster* raster = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xffff0000));
+        VisageCanvas_fill(canvas, 8.0f, 16.0f, 32.0f, 16.0f);
+    });
+
+    REQUIRE(pixel(raster, 8, 16) == 0xffff0000);
+    REQUIRE(pixel(raster, 20, 24) == 0xffff0000);
+    REQUIRE(pixel(raster, 39, 31) == 0xffff0000);
+    REQUIRE(pixel(raster, 7, 24) == 0);
+    REQUIRE(pixel(raster, 40, 24) == 0);
+    REQUIRE(pixel(raster, 20, 15) == 0);
+    REQUIRE(pixel(raster, 20, 32) == 0);
+
+    VisageSoftwareRasterStats stats;
+    VisageSoftwareRaster_getStats(raster, &stats);
+    REQUIRE(stats.shapes == 1);
+    REQUIRE(stats.skipped == 0);
+    VisageSoftwareRaster_delete(raster);
+}
+
+TEST_CASE("Software raster draws circles", "[software_raster]") {
+    VisageSoftwareRaster* raster = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xff00ff00));
+        VisageCanvas_circle(canvas, 16.0f, 16.0f, 32.0f);
+    });
+
+    REQUIRE(pixel(raster, 32, 32) == 0xff00ff00);
+    REQUIRE(pixel(raster, 32, 18) == 0xff00ff00);
+    REQUIRE(pixel(raster, 46, 32) == 0xff00ff00);
+    // The corners of the bounding box are outside the circle.
+    REQUIRE(pixel(raster, 17, 17) == 0);
+    REQUIRE(pixel(raster, 46, 46) == 0);
+    REQUIRE(pixel(raster, 32, 12) == 0);
+
+    // The edge is antialiased.
+    uint32_t edge = pixel(raster, 32, 16);
+    REQUIRE(channel(edge, 24) > 0);
+    REQUIRE(channel(edge, 24) < 255);
+    VisageSoftwareRaster_delete(raster);
+}
+
+TEST_CASE("Software raster draws arcs clockwise from straight up", "[software_raster]") {
+    // Around (32, 32), 24 to 32 pixels out, 45 degrees either side of straight up.
+    VisageSoftwareRaster* flat = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xff0000ff));
+        VisageCanvas_flatArc(canvas, 0.0f, 0.0f, 64.0f, 8.0f, 0.0f, 0.785398f);
+    });
+    VisageSoftwareRaster* rounded = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xff0000ff));
+        VisageCanvas_roundedArc(canvas, 0.0f, 0.0f, 64.0f, 8.0f, 0.0f, 0.785398f);
+    });
+
+    for (VisageSoftwareRaster* raster : { flat, rounded }) {
+        REQUIRE(pixel(raster, 32, 4) == 0xff0000ff);
+        REQUIRE(pixel(raster, 46, 7) == 0xff0000ff);
+        REQUIRE(pixel(raster, 17, 7) == 0xff0000ff);
+        REQUIRE(pixel(raster, 32, 16) == 0);
+        REQUIRE(pixel(raster, 32, 32) == 0);
+        REQUIRE(pixel(raster, 56, 18) == 0);
+        REQUIRE(pixel(raster, 60, 32) == 0);
+        REQUIRE(pixel(raster, 32, 60) == 0);
+    }
+    // Just past the end, on the center radius, only the rounded cap reaches.
+    REQUIRE(pixel(flat, 53, 13) == 0);
+    REQUIRE(pixel(rounded, 53, 13) == 0xff0000ff);
+
+    VisageSoftwareRaster* right = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xff0000ff));
+        VisageCanvas_flatArc(canvas, 0.0f, 0.0f, 64.0f, 8.0f, 1.570796f, 0.785398f);
+    });
+    REQUIRE(pixel(right, 60, 32) == 0xff0000ff);
+    REQUIRE(pixel(right, 3, 32) == 0);
+    REQUIRE(pixel(right, 32, 4) == 0);
+
+    VisageSoftwareRasterStats stats;
+    VisageSoftwareRaster_getStats(right, &stats);
+    REQUIRE(stats.shapes == 1);
+    REQUIRE(stats.skipped == 0);
+    VisageSoftwareRaster_delete(flat);
+    VisageSoftwareRaster_delete(rounded);
+    VisageSoftwareRaster_delete(right);
+}
+
+TEST_CASE("Software raster blurs arc shadows", "[software_raster]") {
+    // Around (32, 32), 16 to 24 pixels out.
+    VisageSoftwareRaster* arc = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xff000000));
+        VisageCanvas_flatArc(canvas, 8.0f, 8.0f, 48.0f, 8.0f, 0.0f, 1.0f);
+    });
+    VisageSoftwareRaster* shadow = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xff000000));
+        VisageCanvas_flatArcShadow(canvas, 8.0f, 8.0f, 48.0f, 8.0f, 0.0f, 1.0f, 4.0f);
+    });
+
+    REQUIRE(channel(pixel(shadow, 32, 12), 24) > 240);
+    REQUIRE(channel(pixel(arc, 32, 6), 24) == 0);
+    int outside = channel(pixel(shadow, 32, 6), 24);
+    REQUIRE(outside > 0);
+    REQUIRE(outside < 128);
+    REQUIRE(channel(pixel(shadow, 32, 4), 24) < outside);
+    VisageSoftwareRaster_delete(arc);
+    VisageSoftwareRaster_delete(shadow);
+}
+
+TEST_CASE("Software raster draws directional triangles", "[software_raster]") {
+    // Each is 16 deep towards its tip, on a 32 long base.
+    VisageSoftwareRaster* up = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xffff0000));
+        VisageCanvas_triangleUp(canvas, 16.0f, 16.0f, 16.0f);
+    });
+    REQUIRE(pixel(up, 32, 28) == 0xffff0000);
+    REQUIRE(pixel(up, 18, 31) == 0xffff0000);
+    REQUIRE(pixel(up, 20, 20) == 0);
+    REQUIRE(pixel(up, 32, 34) == 0);
+    REQUIRE(pixel(up, 32, 13) == 0);
+
+    VisageSoftwareRaster* down = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xffff0000));
+        VisageCanvas_triangleDown(canvas, 16.0f, 16.0f, 16.0f);
+    });
+    REQUIRE(pixel(down, 32, 18) == 0xffff0000);
+    REQUIRE(pixel(down, 20, 28) == 0);
+    REQUIRE(pixel(down, 32, 34) == 0);
+
+    VisageSoftwareRaster* left = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xffff0000));
+        VisageCanvas_triangleLeft(canvas, 16.0f, 16.0f, 16.0f);
+    });
+    REQUIRE(pixel(left, 28, 32) == 0xffff0000);
+    REQUIRE(pixel(left, 18, 20) == 0);
+    REQUIRE(pixel(left, 34, 32) == 0);
+
+    VisageSoftwareRaster* right = rasterize([](VisageCanvas* canvas) {
+        VisageCanvas_setColor(canvas, color(0xffff0000));
+        VisageCanvas_triangleRight(canvas, 16.0f, 16.0f, 16.0f);
+    });
+    REQUIRE(pixel(right, 20, 32) == 0xffff0000);
+    REQUIRE(pixel(right, 30, 20) == 0);
+    REQUIRE(pixel(right, 13, 32) == 0);
+
+    VisageSoftwareRaster_delete(up);
+    VisageSoftwareRaster_delete(down);
+    VisageSoftwareRaster_delete(left);
+    VisageSoftwareRaster_delete(right);
+}
+
+TEST_CASE("Software raster super ellipses match the exact outline", "[software_raster]") {
+    for (float power : { 0.8f, 1.5f, 4.0f }) {
+        VisageSoftwareRaster* raster = rasterize([power](VisageCanvas* canvas) {
+            VisageCanvas_setColor(canvas, color(0xffffffff));
+            VisageCanvas_superEllipse(canvas, 8.0f, 16.0f, 48.0f, 32.0f, power);
+        });
+
+        for (int y = 0; y < kSize; ++y) {
+            for (int x = 0; x < kSize; ++x) {
+                float nx = std::abs(x + 0.5f - 32.0f) / 24.0f;
+                float ny = std::abs(y + 0.5f - 32.0f) / 16.0f;
+                float radius = std::pow(std::pow(nx, power) + std::pow(ny, power), 1.0f / power);
+                float coverage = std::min(std::max(0.5f - (radius - 1.0f) * 16.0f, 0.0f), 1.0f);
+                int expected = static_cast<int>(coverage * 255.0f + 0.5f);
+                REQUIRE(std::abs(channel(pixel(raster, x, y), 24) - expected) <= 1);
+            }
+        }
+        VisageSoftwareRaster_delete(raster);
+    }
+}
+
+TEST_CASE("Software raster skips text", "[software_raster]") {
+    VisageFont* font = VisageFont_LatoRegular(12.0f, 1.0f);
+    VisageText* text = VisageText_new(font);
+    VisageText_setText(text, "text");
+    VisageSoftwareRaster* raster = rasterize([text](VisageCanvas* canvas) {
+        VisageCanvas_fill(canvas, 0.0f, 0.0f, 8.0f, 8.0f);
+        VisageCanvas_text(canvas, text, 0.0f, 0.0f, 64.0f, 16.0f, 0);
+    });
+
+    VisageSoftwareRasterStats stats;
+    VisageSoftwareRaster_getStats(raster, &stats);
+    REQUIRE(stats.shapes == 1);
+    REQUIRE(stats.skipped == 1);
+    VisageSoftwareRaster_delete(raster);
+    VisageText_delete(text);
+    VisageFont_delete(font);
+}
+
+TEST_CASE("Software raster shades horizontal gradients", "[software_raster]") {
+    VisageSoftwareRaster* raster = rasterize([](VisageCanvas* canvas) {
+        VisageBrush* brush = VisageBrush_new();
+        VisageBrush_horizontalFromTwo(brush, color(0xff000000), color(0xffffffff));
+        VisageCanvas_setBrush(canvas, brush);
+        VisageCanvas_fill(canvas, 0.0f, 0.0f, static_cast<float>(kSize), static_cast<float>(kSize));
+        VisageBrush_delete(brush);
+    });
+
+    REQUIRE(channel(pixel(raster, 0, 32), 16) < 16);
+    REQUIRE(channel(pixel(raster, kSize - 1, 32), 16) > 239);
+
+    int previous = -1;
+    for (int x = 0; x < kSize; ++x) {
+        uint32_t argb = pixel(raster, x, 32);
+        REQUIRE(channel(argb, 24) == 255);
+        REQUIRE(channel(argb, 16) >= previous);
+        REQUIRE(channel(argb, 16) == channel(argb, 8));
+        REQUIRE(channel(argb, 16) == channel(argb, 0));
+        // Every row is the same.
+        REQUIRE(pixel(raster, x, 0) == argb);
+        REQUIRE(pixel(raster, x, kSize - 1) == argb);
+        previous = channel(argb, 16);
+    }
+    VisageSoftwareRaster_delete(raster);
+}
@@ -1,7 +1,26 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 #include <visage/graphics.h>
 #include <visage_graphics/canvas.h>
 #include <visage_graphics/font.h>
@@ -12,9 +31,165 @@
 #include <visage_utils/space.h>
 #include <visage_utils/string_utils.h>
 #include <embedded/fonts.h>
+#include <nanosvg.h>
+#include <nanosvgrast.h>
 
 #include "visage_graphics_c.h"
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VISAGE_C_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VISAGE_C_NEON 1
+#endif
+
+// Set by the VISAGE_ENABLE_BACKGROUND_GRAPHICS_THREAD build option to start canvases out submitting
+// asynchronously.
+#ifndef VISAGE_C_BACKGROUND_GRAPHICS_THREAD
+#define VISAGE_C_BACKGROUND_GRAPHICS_THREAD 0
+#endif
+
+// Cleared by turning off the VISAGE_GRAPHICS_C_FRAME_STATS build option, which compiles out frame
+// statistics counting.
+#ifndef VISAGE_C_FRAME_STATS
+#define VISAGE_C_FRAME_STATS 1
+#endif
+
+// Runs `function(index)` for every index below `count` on a few short lived worker threads and
+// returns once all of them are done.
+template <typename Function>
+void parallel_for(size_t count, Function&& function) {
+    size_t num_threads = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    if (num_threads <= 1) {
+        for (size_t i = 0; i < count; ++i)
+            function(i);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto work = [&] {
+        for (size_t i = next++; i < count; i = next++)
+            function(i);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t t = 1; t < num_threads; ++t)
+        threads.emplace_back(work);
+    work();
+
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+// visage's renderer and glyph atlases aren't thread safe. Whatever uses them outside of drawing into
+// a canvas holds this lock: submitting frames, whether on the render thread or not, calls that
+// change a canvas's target, and measuring or prewarming fonts. Never destroyed, like the caches.
+inline std::mutex& render_mutex() {
+    static std::mutex* mutex = new std::mutex;
+    return *mutex;
+}
+
+inline uint64_t hash_bytes(const char* data, size_t size) {
+    uint64_t hash = 0x9e3779b97f4a7c15ull ^ size;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t chunk = 0;
+        std::memcpy(&chunk, data + i, sizeof(chunk));
+        hash = (hash ^ chunk) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+
+    uint64_t tail = 0;
+    std::memcpy(&tail, data + i, size - i);
+    hash = (hash ^ tail) * 0xc4ceb9fe1a85ec53ull;
+    return hash ^ (hash >> 29);
+}
+
+// Folds `value` into `hash` so the result depends on the order values are combined in.
+inline uint64_t hash_combine(uint64_t hash, uint64_t value) {
+    hash = (hash ^ value) * 0xff51afd7ed558ccdull;
+    return hash ^ (hash >> 32);
+}
+
+// Read-only memory mapping of a whole file. `data()` is null if the file couldn't be mapped.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE)
+            return;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0)
+            return;
+
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr)
+            return;
+
+        data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        size_ = data_ ? static_cast<size_t>(size.QuadPart) : 0;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = static_cast<const char*>(data);
+                size_ = static_cast<size_t>(info.st_size);
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data_)
+            UnmapViewOfFile(data_);
+        if (mapping_)
+            CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE)
+            CloseHandle(file_);
+#else
+        if (data_)
+            munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+};
+
 inline VisageColor color_from_cpp(visage::Color color) {
     return VisageColor { .values = {color.blue(), color.green(), color.red(), color.alpha() }, .hdr = color.hdr() };
 }
@@ -41,11 +216,4599 @@ inline visage::Direction direction_to_cpp(int32_t direction) {
     }
 }
 
+inline visage::Color command_color_to_cpp(const VisageShapeCommand& command) {
+    const float* v = command.values;
+    return visage::Color { v[VisageColorChannelAlpha], v[VisageColorChannelRed], v[VisageColorChannelGreen], v[VisageColorChannelBlue], v[4] };
+}
+
+// Draws a single geometry or state command. Color and brush commands depend on where the command
+// came from and are resolved by the caller.
+inline void draw_shape_command(visage::Canvas* canvas, const VisageShapeCommand& command) {
+    const float* v = command.values;
+    bool rounded = (command.flags & VISAGE_SHAPE_COMMAND_ROUNDED) != 0;
+
+    switch (command.type) {
+        case VisageShapeCommandFill:
+            canvas->fill(v[0], v[1], v[2], v[3]);
+            break;
+        case VisageShapeCommandCircle:
+            canvas->circle(v[0], v[1], v[2]);
+            break;
+        case VisageShapeCommandFadeCircle:
+            canvas->fadeCircle(v[0], v[1], v[2], v[3]);
+            break;
+        case VisageShapeCommandRing:
+            canvas->ring(v[0], v[1], v[2], v[3]);
+            break;
+        case VisageShapeCommandSquircle:
+            canvas->squircle(v[0], v[1], v[2], v[3]);
+            break;
+        case VisageShapeCommandSuperEllipse:
+            canvas->superEllipse(v[0], v[1], v[2], v[3], v[4]);
+            break;
+        case VisageShapeCommandArc:
+            canvas->arc(v[0], v[1], v[2], v[3], v[4], v[5], rounded);
+            break;
+        case VisageShapeCommandArcShadow:
+            if (rounded)
+                canvas->roundedArcShadow(v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
+            else
+                canvas->flatArcShadow(v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
+            break;
+        case VisageShapeCommandSegment:
+            canvas->segment(v[0], v[1], v[2], v[3], v[4], rounded);
+            break;
+        case VisageShapeCommandQuadratic:
+            canvas->quadratic(v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
+            break;
+        case VisageShapeCommandRectangle:
+            canvas->rectangle(v[0], v[1], v[2], v[3]);
+            break;
+        case VisageShapeCommandRectangleBorder:
+            canvas->rectangleBorder(v[0], v[1], v[2], v[3], v[4]);
+            break;
+        case VisageShapeCommandRoundedRectangle:
+            canvas->roundedRectangle(v[0], v[1], v[2], v[3], v[4]);
+            break;
+        case VisageShapeCommandLeftRoundedRectangle:
+            canvas->leftRoundedRectangle(v[0], v[1], v[2], v[3], v[4]);
+            break;
+        case VisageShapeCommandRightRoundedRectangle:
+            canvas->rightRoundedRectangle(v[0], v[1], v[2], v[3], v[4]);
+            break;
+        case VisageShapeCommandTopRoundedRectangle:
+            canvas->topRoundedRectangle(v[0], v[1], v[2], v[3], v[4]);
+            break;
+        case VisageShapeCommandBottomRoundedRectangle:
+            canvas->bottomRoundedRectangle(v[0], v[1], v[2], v[3], v[4]);
+            break;
+        case VisageShapeCommandRectangleShadow:
+            canvas->rectangleShadow(v[0], v[1], v[2], v[3], v[4]);
+            break;
+        case VisageShapeCommandRoundedRectangleShadow:
+            canvas->roundedRectangleShadow(v[0], v[1], v[2], v[3], v[4], v[5]);
+            break;
+        case VisageShapeCommandRoundedRectangleBorder:
+            canvas->roundedRectangleBorder(v[0], v[1], v[2], v[3], v[4], v[5]);
+            break;
+        case VisageShapeCommandDiamond:
+            canvas->diamond(v[0], v[1], v[2], v[3]);
+            break;
+        case VisageShapeCommandTriangle:
+            canvas->triangle(v[0], v[1], v[2], v[3], v[4], v[5]);
+            break;
+        case VisageShapeCommandTriangleBorder:
+            canvas->triangleBorder(v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
+            break;
+        case VisageShapeCommandRoundedTriangle:
+            canvas->roundedTriangle(v[0], v[1], v[2], v[3], v[4], v[5], v[6]);
+            break;
+        case VisageShapeCommandRoundedTriangleBorder:
+            canvas->roundedTriangleBorder(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+            break;
+        case VisageShapeCommandDirectionalTriangle:
+            switch (command.flags) {
+                case Up:
+                    canvas->triangleUp(v[0], v[1], v[2]);
+                    break;
+                case Right:
+                    canvas->triangleRight(v[0], v[1], v[2]);
+                    break;
+                case Down:
+                    canvas->triangleDown(v[0], v[1], v[2]);
+                    break;
+                default:
+                    canvas->triangleLeft(v[0], v[1], v[2]);
+                    break;
+            }
+            break;
+        case VisageShapeCommandSetPosition:
+            canvas->setPosition(v[0], v[1]);
+            break;
+        case VisageShapeCommandSaveState:
+            canvas->saveState();
+            break;
+        case VisageShapeCommandRestoreState:
+            canvas->restoreState();
+            break;
+        case VisageShapeCommandSetClampBounds:
+            canvas->setClampBounds(v[0], v[1], v[2], v[3]);
+            break;
+        case VisageShapeCommandTrimClampBounds:
+            canvas->trimClampBounds(v[0], v[1], v[2], v[3]);
+            break;
+        default:
+            break;
+    }
+}
+
+inline visage::Gradient gradient_from_colors(std::initializer_list<visage::Color> colors) {
+    visage::Gradient gradient;
+    gradient.setResolution(static_cast<int>(colors.size()));
+    int index = 0;
+    for (const visage::Color& color : colors)
+        gradient.setColor(index++, color);
+    return gradient;
+}
+
+// Unpacks 0xAARRGGBB colors. In memory each one is the bytes blue, green, red, alpha, which is
+// the channel order of VisageColor, so every color widens straight into one vector.
+inline void unpack_argb(const uint32_t* argb, size_t count, VisageColor* colors) {
+    constexpr float kByteScale = 1.0f / 255.0f;
+    size_t i = 0;
+#if VISAGE_C_SSE2
+    __m128i zero = _mm_setzero_si128();
+    __m128 scale = _mm_set1_ps(kByteScale);
+    for (; i + 4 <= count; i += 4) {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(argb + i));
+        __m128i low = _mm_unpacklo_epi8(packed, zero);
+        __m128i high = _mm_unpackhi_epi8(packed, zero);
+        __m128i channels[] = { _mm_unpacklo_epi16(low, zero), _mm_unpackhi_epi16(low, zero),
+                               _mm_unpacklo_epi16(high, zero), _mm_unpackhi_epi16(high, zero) };
+        for (int c = 0; c < 4; ++c) {
+            _mm_storeu_ps(colors[i + c].values, _mm_mul_ps(_mm_cvtepi32_ps(channels[c]), scale));
+            colors[i + c].hdr = 1.0f;
+        }
+    }
+#elif VISAGE_C_NEON
+    for (; i + 4 <= count; i += 4) {
+        uint8x16_t packed = vreinterpretq_u8_u32(vld1q_u32(argb + i));
+        uint16x8_t low = vmovl_u8(vget_low_u8(packed));
+        uint16x8_t high = vmovl_u8(vget_high_u8(packed));
+        uint32x4_t channels[] = { vmovl_u16(vget_low_u16(low)), vmovl_u16(vget_high_u16(low)),
+                                  vmovl_u16(vget_low_u16(high)), vmovl_u16(vget_high_u16(high)) };
+        for (int c = 0; c < 4; ++c) {
+            vst1q_f32(colors[i + c].values, vmulq_n_f32(vcvtq_f32_u32(channels[c]), kByteScale));
+            colors[i + c].hdr = 1.0f;
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        colors[i].values[VisageColorChannelBlue] = (argb[i] & 0xff) * kByteScale;
+        colors[i].values[VisageColorChannelGreen] = ((argb[i] >> 8) & 0xff) * kByteScale;
+        colors[i].values[VisageColorChannelRed] = ((argb[i] >> 16) & 0xff) * kByteScale;
+        colors[i].values[VisageColorChannelAlpha] = (argb[i] >> 24) * kByteScale;
+        colors[i].hdr = 1.0f;
+    }
+}
+
+inline void gradient_set_colors(visage::Gradient* gradient, const VisageColor* colors, int count) {
+    gradient->setResolution(count);
+    for (int i = 0; i < count; ++i)
+        gradient->setColor(i, color_to_cpp(colors[i]));
+}
+
+// What a brush was built from. visage::Brush doesn't expose its gradient or position, so this is
+// kept next to it to be able to write brushes into command streams.
+enum BrushKind : uint32_t {
+    kBrushSolid,
+    kBrushHorizontal,
+    kBrushVertical,
+    kBrushLinear,
+};
+
+struct BrushSource {
+    uint32_t kind = kBrushSolid;
+    visage::Gradient gradient;
+    float from_x = 0.0f;
+    float from_y = 0.0f;
+    float to_x = 0.0f;
+    float to_y = 0.0f;
+    // Computed by brush_source_rehash whenever the fields above change, so drawing never hashes.
+    uint64_t gradient_hash = 0;
+    uint64_t hash = 0;
+};
+
+inline visage::Brush brush_from_source(const BrushSource& source) {
+    switch (source.kind) {
+        case kBrushHorizontal:
+            return visage::Brush::horizontal(source.gradient);
+        case kBrushVertical:
+            return visage::Brush::vertical(source.gradient);
+        case kBrushLinear:
+            return visage::Brush::linear(source.gradient, visage::Point(source.from_x, source.from_y), visage::Point(source.to_x, source.to_y));
+        default:
+            return visage::Brush::solid(source.gradient.sample(0.0f));
+    }
+}
+
+struct VisageBrush_t {
+    visage::Brush brush;
+    BrushSource source;
+};
+
+inline uint64_t color_hash(const visage::Color& color) {
+    VisageColor packed = color_from_cpp(color);
+    return hash_bytes(reinterpret_cast<const char*>(&packed), sizeof(packed));
+}
+
+inline uint64_t gradient_hash(const visage::Gradient& gradient) {
+    uint64_t hash = gradient.colors().size();
+    for (const visage::Color& color : gradient.colors())
+        hash = hash_combine(hash, color_hash(color));
+    return hash;
+}
+
+inline void brush_source_rehash(BrushSource* source) {
+    float positions[] = { source->from_x, source->from_y, source->to_x, source->to_y };
+    source->gradient_hash = gradient_hash(source->gradient);
+    source->hash = source->gradient_hash ^
+                   (hash_bytes(reinterpret_cast<const char*>(positions), sizeof(positions)) + source->kind);
+}
+
+inline uint64_t brush_source_hash(const BrushSource& source) {
+    return source.hash;
+}
+
+// Brushes registered once and referenced by a small id after that. Identical brushes share an
+// entry and a reference count, and ids of released entries are reused. Registering and releasing
+// are thread safe. Entries live in chunks that never move, so looking an id up takes no lock; an id
+// must only be released once nothing draws with it anymore.
+class BrushPalette {
+public:
+    static constexpr int32_t kChunkSize = 256;
+    static constexpr int32_t kMaxChunks = 1024;
+
+    // Never destroyed, ids may still be released during static destruction.
+    static BrushPalette& instance() {
+        static BrushPalette* palette = new BrushPalette;
+        return *palette;
+    }
+
+    // Returns 0 if the palette is full.
+    int32_t add(const VisageBrush_t& brush) {
+        const BrushSource& source = brush.source;
+        uint64_t hash = brush_source_hash(source);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto range = ids_.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            Entry& entry = *find(it->second);
+            if (sameBrush(entry.owned->source, source)) {
+                entry.references++;
+                return it->second;
+            }
+        }
+
+        int32_t id = 0;
+        if (free_ids_.empty()) {
+            if (num_entries_ == kChunkSize * kMaxChunks)
+                return 0;
+            if (num_entries_ % kChunkSize == 0)
+                chunks_[num_entries_ / kChunkSize].store(new Entry[kChunkSize], std::memory_order_release);
+            id = ++num_entries_;
+        } else {
+            id = free_ids_.back();
+            free_ids_.pop_back();
+        }
+
+        Entry& entry = at(id);
+        entry.owned = std::make_unique<const VisageBrush_t>(brush);
+        entry.hash = hash;
+        entry.references = 1;
+        entry.brush.store(entry.owned.get(), std::memory_order_release);
+        ids_.emplace(hash, id);
+        return id;
+    }
+
+    void release(int32_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry* entry = find(id);
+        if (entry == nullptr || --entry->references > 0)
+            return;
+
+        auto range = ids_.equal_range(entry->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == id) {
+                ids_.erase(it);
+                break;
+            }
+        }
+        entry->brush.store(nullptr, std::memory_order_release);
+        entry->owned.reset();
+        free_ids_.push_back(id);
+    }
+
+    // Lock free. The brush stays valid until `id` is released.
+    const VisageBrush_t* get(int32_t id) const {
+        if (id <= 0 || id > kChunkSize * kMaxChunks)
+            return nullptr;
+
+        const Entry* entries = chunks_[(id - 1) / kChunkSize].load(std::memory_order_acquire);
+        return entries ? entries[(id - 1) % kChunkSize].brush.load(std::memory_order_acquire) : nullptr;
+    }
+
+    VisageBrushPaletteStats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        VisageBrushPaletteStats stats = {};
+        std::vector<const BrushSource*> gradients;
+
+        for (int32_t id = 1; id <= num_entries_; ++id) {
+            const Entry& entry = at(id);
+            if (entry.owned == nullptr)
+                continue;
+
+            stats.brushes++;
+            stats.references += entry.references;
+
+            const BrushSource& source = entry.owned->source;
+            auto same_gradient = [&source](const BrushSource* other) {
+                return other->gradient_hash == source.gradient_hash &&
+                       visage::Gradient::compare(other->gradient, source.gradient) == 0;
+            };
+            if (std::find_if(gradients.begin(), gradients.end(), same_gradient) == gradients.end()) {
+                gradients.push_back(&source);
+                stats.gradient_stops += source.gradient.resolution();
+            }
+        }
+
+        stats.gradients = static_cast<int32_t>(gradients.size());
+        return stats;
+    }
+
+private:
+    struct Entry {
+        // Set while `owned` is, read without the lock.
+        std::atomic<const VisageBrush_t*> brush { nullptr };
+        std::unique_ptr<const VisageBrush_t> owned;
+        uint64_t hash = 0;
+        int32_t references = 0;
+    };
+
+    static bool sameBrush(const BrushSource& a, const BrushSource& b) {
+        return a.kind == b.kind && a.from_x == b.from_x && a.from_y == b.from_y && a.to_x == b.to_x &&
+               a.to_y == b.to_y && visage::Gradient::compare(a.gradient, b.gradient) == 0;
+    }
+
+    Entry& at(int32_t id) {
+        return chunks_[(id - 1) / kChunkSize].load(std::memory_order_relaxed)[(id - 1) % kChunkSize];
+    }
+
+    Entry* find(int32_t id) {
+        if (id <= 0 || id > num_entries_ || at(id).owned == nullptr)
+            return nullptr;
+        return &at(id);
+    }
+
+    std::mutex mutex_;
+    std::array<std::atomic<Entry*>, kMaxChunks> chunks_ {};
+    int32_t num_entries_ = 0;
+    std::unordered_multimap<uint64_t, int32_t> ids_;
+    std::vector<int32_t> free_ids_;
+};
+
+// Bounded LRU of string measurements for a font. The measured strings are kept next to their
+// results so a hash collision can't return a wrong measurement. Not thread safe.
+class MeasureCache {
+public:
+    enum Kind : uint32_t {
+        kStringWidth,
+        kWidthOverflowIndex,
+    };
+
+    struct Query {
+        Kind kind;
+        const char32_t* string;
+        int length;
+        int character_override;
+        float width = 0.0f;
+        bool round = false;
+    };
+
+    explicit MeasureCache(size_t capacity) : capacity_(capacity) { }
+
+    static uint64_t hash(const Query& query) {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](uint64_t value) {
+            hash ^= value;
+            hash *= 1099511628211ull;
+        };
+
+        for (int i = 0; i < query.length; ++i)
+            mix(query.string[i]);
+
+        uint32_t width_bits = 0;
+        std::memcpy(&width_bits, &query.width, sizeof(width_bits));
+        mix(static_cast<uint32_t>(query.character_override));
+        mix(width_bits);
+        mix((static_cast<uint64_t>(query.kind) << 1) | (query.round ? 1 : 0));
+        return hash;
+    }
+
+    template <typename T, typename Measure>
+    T measure(const Query& query, Measure&& measure) {
+        uint64_t query_hash = hash(query);
+        auto range = index_.equal_range(query_hash);
+
+        for (auto it = range.first; it != range.second; ++it) {
+            auto entry = it->second;
+            if (entry->matches(query)) {
+                ++hits_;
+                entries_.splice(entries_.begin(), entries_, entry);
+                return static_cast<T>(entry->result);
+            }
+        }
+
+        ++misses_;
+        T result = measure();
+        if (capacity_ == 0)
+            return result;
+
+        if (entries_.size() >= capacity_)
+            evictLast();
+
+        entries_.push_front({ query_hash, query.kind, std::u32string(query.string, query.length), query.character_override,
+                              query.width, query.round, static_cast<double>(result) });
+        index_.emplace(query_hash, entries_.begin());
+        return result;
+    }
+
+    void setCapacity(size_t capacity) {
+        capacity_ = capacity;
+        while (entries_.size() > capacity_)
+            evictLast();
+    }
+    void clear() {
+        entries_.clear();
+        index_.clear();
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t size() const { return entries_.size(); }
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        Kind kind;
+        std::u32string string;
+        int character_override;
+        float width;
+        bool round;
+        double result;
+
+        bool matches(const Query& query) const {
+            return kind == query.kind && character_override == query.character_override && width == query.width &&
+                   round == query.round && string.size() == static_cast<size_t>(query.length) &&
+                   std::memcmp(string.data(), query.string, query.length * sizeof(char32_t)) == 0;
+        }
+    };
+
+    void evictLast() {
+        auto last = std::prev(entries_.end());
+        auto range = index_.equal_range(last->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == last) {
+                index_.erase(it);
+                break;
+            }
+        }
+        entries_.pop_back();
+    }
+
+    size_t capacity_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    // Most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index_;
+};
+
+struct FontKey {
+    const char* data;
+    int data_size;
+    float size;
+    float dpi_scale;
+
+    bool operator<(const FontKey& other) const {
+        return std::tie(data, data_size, size, dpi_scale) < std::tie(other.data, other.data_size, other.size, other.dpi_scale);
+    }
+};
+
+// visage keeps one glyph atlas per font data and pixel size.
+inline std::pair<const char*, float> font_atlas_key(const FontKey& key) {
+    return { key.data, key.size * (key.dpi_scale > 0.0f ? key.dpi_scale : 1.0f) };
+}
+
+// Bitset of unicode codepoints that any number of threads can add to without locking. Pages of
+// 4096 codepoints are allocated the first time one of them is added, and only freed with the set.
+class AtomicCodepointSet {
+public:
+    AtomicCodepointSet() = default;
+    AtomicCodepointSet(const AtomicCodepointSet&) = delete;
+    AtomicCodepointSet& operator=(const AtomicCodepointSet&) = delete;
+
+    ~AtomicCodepointSet() {
+        for (std::atomic<std::atomic<uint64_t>*>& page : pages_)
+            delete[] page.load(std::memory_order_relaxed);
+    }
+
+    // Returns true if `codepoint` wasn't in the set yet.
+    bool insert(uint32_t codepoint) {
+        if (codepoint > kMaxCodepoint)
+            return false;
+
+        std::atomic<uint64_t>& word = page(codepoint / kPageBits)[(codepoint % kPageBits) / 64];
+        uint64_t bit = 1ull << (codepoint % 64);
+        // Drawn glyphs are mostly drawn again, which only reads.
+        if (word.load(std::memory_order_relaxed) & bit)
+            return false;
+        return (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+    }
+
+private:
+    static constexpr uint32_t kMaxCodepoint = 0x10ffff;
+    static constexpr uint32_t kPageBits = 4096;
+    static constexpr uint32_t kNumPages = (kMaxCodepoint + kPageBits) / kPageBits;
+
+    std::atomic<uint64_t>* page(uint32_t index) {
+        std::atomic<uint64_t>* page = pages_[index].load(std::memory_order_acquire);
+        if (page)
+            return page;
+
+        auto created = new std::atomic<uint64_t>[kPageBits / 64];
+        for (uint32_t i = 0; i < kPageBits / 64; ++i)
+            created[i].store(0, std::memory_order_relaxed);
+        if (pages_[index].compare_exchange_strong(page, created, std::memory_order_acq_rel))
+            return created;
+
+        // Another thread added the page first.
+        delete[] created;
+        return page;
+    }
+
+    std::array<std::atomic<std::atomic<uint64_t>*>, kNumPages> pages_ {};
+};
+
+// A font shared by every handle created with the same data, size and dpi scale, together with
+// its measurement cache.
+struct FontEntry {
+    FontEntry(const FontKey& font_key, visage::Font visage_font) : key(font_key), font(std::move(visage_font)) { }
+
+    FontKey key;
+    visage::Font font;
+    std::shared_ptr<MeasureCache> measure_cache;
+    // Bitset of the codepoints used with this font while the glyph cache is enabled.
+    std::mutex used_glyphs_mutex;
+    std::vector<uint64_t> used_glyphs;
+    // Hash of the font data naming its glyph cache file, 0 until the cache first needs it.
+    std::atomic<uint64_t> data_hash { 0 };
+    // The codepoints drawn with this font, counted for frame stats.
+    AtomicCodepointSet drawn_glyphs;
+};
+
+// Interns fonts so identical VisageFont handles share one visage::Font, and with it the glyph
+// atlas. Entries are dropped when their last handle goes away.
+class FontRegistry {
+public:
+    // Never destroyed, handles may still be released during static destruction.
+    static FontRegistry& instance() {
+        static FontRegistry* registry = new FontRegistry;
+        return *registry;
+    }
+
+    std::shared_ptr<FontEntry> intern(const FontKey& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::weak_ptr<FontEntry>& slot = fonts_[key];
+        if (std::shared_ptr<FontEntry> entry = slot.lock())
+            return entry;
+
+        auto entry = new FontEntry(key, visage::Font(key.size, key.data, key.data_size, key.dpi_scale));
+        std::shared_ptr<FontEntry> shared(entry, [this](FontEntry* entry) { release(entry); });
+        slot = shared;
+        return shared;
+    }
+    std::shared_ptr<FontEntry> intern(const visage::EmbeddedFile& file, float size, float dpi_scale) {
+        return intern({ file.data, file.size, size, dpi_scale });
+    }
+
+    VisageFontRegistryStats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        VisageFontRegistryStats stats = {};
+        std::vector<std::pair<const char*, float>> atlases;
+
+        for (const auto& font : fonts_) {
+            long references = font.second.use_count();
+            if (references == 0)
+                continue;
+
+            stats.fonts++;
+            stats.references += static_cast<int32_t>(references);
+
+            std::pair<const char*, float> atlas = font_atlas_key(font.first);
+            if (std::find(atlases.begin(), atlases.end(), atlas) == atlases.end())
+                atlases.push_back(atlas);
+        }
+
+        stats.atlases = static_cast<int32_t>(atlases.size());
+        return stats;
+    }
+
+    std::vector<std::shared_ptr<FontEntry>> liveFonts() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::shared_ptr<FontEntry>> fonts;
+        for (const auto& font : fonts_) {
+            if (std::shared_ptr<FontEntry> entry = font.second.lock())
+                fonts.push_back(std::move(entry));
+        }
+        return fonts;
+    }
+
+private:
+    void release(FontEntry* entry) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = fonts_.find(entry->key);
+            if (it != fonts_.end() && it->second.expired())
+                fonts_.erase(it);
+        }
+        delete entry;
+    }
+
+    std::mutex mutex_;
+    std::map<FontKey, std::weak_ptr<FontEntry>> fonts_;
+};
+
+struct VisageFont_t {
+    std::shared_ptr<FontEntry> entry;
+};
+
+constexpr uint32_t kGlyphCacheMagic = 0x594c4756; // "VGLY"
+constexpr uint32_t kGlyphCacheVersion = 1;
+
+// A glyph cache file: the header followed by `num_codepoints` sorted uint32_t codepoints.
+struct GlyphCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t font_hash;
+    float size;
+    float dpi_scale;
+    uint32_t num_codepoints;
+    uint32_t reserved;
+};
+
+// Remembers, across launches, which glyphs each font used so they can be rasterized before the
+// first frame. There is one file per font data hash, size and dpi scale in the cache directory.
+class GlyphCache {
+public:
+    static GlyphCache& instance() {
+        static GlyphCache* cache = new GlyphCache;
+        return *cache;
+    }
+
+    void setDirectory(const char* directory) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        directory_ = directory ? directory : "";
+        enabled_ = !directory_.empty();
+    }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // The hash is kept with the font, so it goes away with the font's data. Threads racing to
+    // compute it store the same value.
+    static uint64_t fontHash(FontEntry* entry) {
+        uint64_t hash = entry->data_hash.load(std::memory_order_relaxed);
+        if (hash == 0) {
+            hash = hash_bytes(entry->key.data, static_cast<size_t>(entry->key.data_size));
+            entry->data_hash.store(hash, std::memory_order_relaxed);
+        }
+        return hash;
+    }
+
+    std::string path(FontEntry* entry) {
+        const FontKey& key = entry->key;
+        char name[64];
+        std::snprintf(name, sizeof(name), "%016llx_%g_%g.glyphs", static_cast<unsigned long long>(fontHash(entry)),
+                      key.size, key.dpi_scale);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return directory_ + "/" + name;
+    }
+
+private:
+    std::mutex mutex_;
+    std::string directory_;
+    std::atomic<bool> enabled_ { false };
+};
+
+inline void mark_used_glyphs(FontEntry* entry, const char32_t* codepoints, size_t count) {
+    if (!GlyphCache::instance().enabled())
+        return;
+
+    std::lock_guard<std::mutex> lock(entry->used_glyphs_mutex);
+    std::vector<uint64_t>& used = entry->used_glyphs;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t codepoint = codepoints[i];
+        if (codepoint > 0x10ffff)
+            continue;
+
+        size_t word = codepoint / 64;
+        if (word >= used.size())
+            used.resize(word + 1);
+        used[word] |= 1ull << (codepoint % 64);
+    }
+}
+
+// Marks `codepoints` as drawn with the font and returns how many were drawn for the first time,
+// which visage rasterizes into the font's atlas.
+inline size_t mark_drawn_glyphs(FontEntry* entry, const char32_t* codepoints, size_t count) {
+    size_t new_glyphs = 0;
+    for (size_t i = 0; i < count; ++i)
+        new_glyphs += entry->drawn_glyphs.insert(static_cast<uint32_t>(codepoints[i])) ? 1 : 0;
+    return new_glyphs;
+}
+
+inline std::vector<uint32_t> used_glyph_list(FontEntry* entry) {
+    std::lock_guard<std::mutex> lock(entry->used_glyphs_mutex);
+    std::vector<uint32_t> codepoints;
+    for (size_t word = 0; word < entry->used_glyphs.size(); ++word) {
+        for (uint64_t bits = entry->used_glyphs[word]; bits; bits &= bits - 1) {
+            int bit = 0;
+            while (((bits >> bit) & 1) == 0)
+                ++bit;
+            codepoints.push_back(static_cast<uint32_t>(word * 64 + bit));
+        }
+    }
+    return codepoints;
+}
+
+// Writes the glyphs `entry` used into the cache directory, replacing any previous file.
+inline bool save_glyph_cache(FontEntry* entry) {
+    std::vector<uint32_t> codepoints = used_glyph_list(entry);
+    if (codepoints.empty())
+        return true;
+
+    GlyphCache& cache = GlyphCache::instance();
+    GlyphCacheHeader header = { kGlyphCacheMagic, kGlyphCacheVersion, cache.fontHash(entry), entry->key.size,
+                                entry->key.dpi_scale, static_cast<uint32_t>(codepoints.size()), 0 };
+
+    std::string path = cache.path(entry);
+    std::string temp_path = path + ".tmp";
+    std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(codepoints.data(), sizeof(uint32_t), codepoints.size(), file) == codepoints.size();
+    written = std::fclose(file) == 0 && written;
+
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (!written || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Measuring a glyph makes visage rasterize it with FreeType and pack it into the font's atlas, the
+// atlas texture is uploaded in one go the next time the font is drawn.
+inline void prewarm_glyphs(const visage::Font& font, const char32_t* codepoints, int count) {
+    constexpr int kChunkSize = 256;
+    for (int i = 0; i < count; i += kChunkSize)
+        font.stringWidth(codepoints + i, std::min(kChunkSize, count - i));
+}
+
+inline void append_codepoint_range(std::u32string* codepoints, char32_t first, char32_t last) {
+    for (char32_t c = first; c <= last; ++c)
+        codepoints->push_back(c);
+}
+
+inline std::u32string glyph_preset_codepoints(uint32_t presets) {
+    std::u32string codepoints;
+    if (presets & VISAGE_GLYPH_PRESET_LATIN1) {
+        append_codepoint_range(&codepoints, 0x20, 0x7e);
+        append_codepoint_range(&codepoints, 0xa0, 0xff);
+    }
+    if (presets & VISAGE_GLYPH_PRESET_DIGITS) {
+        append_codepoint_range(&codepoints, U'0', U'9');
+        codepoints += U" +-.,:%";
+    }
+    if (presets & VISAGE_GLYPH_PRESET_UI_SYMBOLS) {
+        codepoints += U"\u00b0\u00b1\u00d7\u00f7\u2013\u2014\u2022\u2026\u20ac\u2190\u2191\u2192\u2193\u2212\u221e"
+                      U"\u2248\u2264\u2265\u25b2\u25b6\u25bc\u25c0\u266a\u2713\u2715";
+    }
+    return codepoints;
+}
+
+inline float font_string_width(const VisageFont* font, const char32_t* string, int length, int character_override) {
+    const FontEntry& entry = *font->entry;
+    if (!entry.measure_cache)
+        return entry.font.stringWidth(string, length, character_override);
+
+    MeasureCache::Query query = { MeasureCache::kStringWidth, string, length, character_override };
+    return entry.measure_cache->measure<float>(query, [&] { return entry.font.stringWidth(string, length, character_override); });
+}
+
+inline bool is_line_break_space(char32_t character) {
+    return character == U' ' || character == U'\t' || character == U'\n' || character == U'\r' || character == 0x3000;
+}
+
+// Finds where each wrapped line of `string` starts, following visage's rules: newlines always
+// break, otherwise lines break after the last whitespace that fits, or mid-word if a word is wider
+// than `width`. Measures with widthOverflowIndex so nothing is allocated. Writes up to `capacity`
+// indices and returns how many breaks there are.
+inline int32_t font_line_breaks(const visage::Font& font, const char32_t* string, int length, float width, int32_t* line_breaks, int32_t capacity) {
+    int32_t count = 0;
+    int start = 0;
+    int newline = 0;
+
+    while (start < length) {
+        if (newline < start)
+            newline = start;
+        while (newline < length && string[newline] != U'\n')
+            ++newline;
+
+        int overflow = start + font.widthOverflowIndex(string + start, newline - start, width);
+        int end = 0;
+        if (overflow >= newline) {
+            if (newline >= length)
+                break;
+            end = newline + 1;
+        } else {
+            end = overflow;
+            while (end > start && !is_line_break_space(string[end - 1]))
+                --end;
+            if (end == start)
+                end = std::max(overflow, start + 1);
+        }
+
+        if (count < capacity)
+            line_breaks[count] = end;
+        ++count;
+        start = end;
+    }
+
+    return count;
+}
+
+// Keeps the font wrapper next to the text so VisageText_getFont can hand out the same handle type.
+struct VisageText_t {
+    explicit VisageText_t(const VisageFont_t& text_font) : font(text_font) { text.setFont(font.entry->font); }
+
+    visage::Text text;
+    VisageFont_t font;
+    // Reused between UTF-8 updates so transcoding doesn't allocate once it has grown.
+    std::u32string utf32;
+    // The UTF-8 text last set, only meaningful while `has_utf8` is set. Reused like `utf32`.
+    std::string utf8;
+    bool has_utf8 = false;
+};
+
+// Widens 16 ASCII bytes to UTF-32. Returns false, writing nothing, if any byte isn't ASCII.
+inline bool ascii_block_to_utf32(const unsigned char* input, char32_t* output) {
+#if VISAGE_C_SSE2
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+    if (_mm_movemask_epi8(bytes))
+        return false;
+
+    __m128i zero = _mm_setzero_si128();
+    __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi16(low, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_unpackhi_epi16(low, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 8), _mm_unpacklo_epi16(high, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 12), _mm_unpackhi_epi16(high, zero));
+    return true;
+#elif VISAGE_C_NEON
+    uint8x16_t bytes = vld1q_u8(input);
+    if (vmaxvq_u8(bytes) >= 0x80)
+        return false;
+
+    uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+    uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+    auto words = reinterpret_cast<uint32_t*>(output);
+    vst1q_u32(words, vmovl_u16(vget_low_u16(low)));
+    vst1q_u32(words + 4, vmovl_u16(vget_high_u16(low)));
+    vst1q_u32(words + 8, vmovl_u16(vget_low_u16(high)));
+    vst1q_u32(words + 12, vmovl_u16(vget_high_u16(high)));
+    return true;
+#else
+    uint64_t first = 0;
+    uint64_t second = 0;
+    std::memcpy(&first, input, sizeof(first));
+    std::memcpy(&second, input + sizeof(first), sizeof(second));
+    if ((first | second) & 0x8080808080808080ull)
+        return false;
+
+    for (int i = 0; i < 16; ++i)
+        output[i] = input[i];
+    return true;
+#endif
+}
+
+// Decodes one UTF-8 sequence starting at `input[*index]`. Malformed sequences decode to U+FFFD
+// and consume a single byte.
+inline char32_t decode_utf8(const unsigned char* input, size_t size, size_t* index) {
+    constexpr char32_t kReplacement = 0xfffd;
+    size_t i = *index;
+    unsigned char lead = input[i];
+
+    int length = 0;
+    char32_t code_point = 0;
+    char32_t minimum = 0;
+    if (lead < 0x80) {
+        *index = i + 1;
+        return lead;
+    } else if ((lead & 0xe0) == 0xc0) {
+        length = 2;
+        code_point = lead & 0x1f;
+        minimum = 0x80;
+    } else if ((lead & 0xf0) == 0xe0) {
+        length = 3;
+        code_point = lead & 0x0f;
+        minimum = 0x800;
+    } else if ((lead & 0xf8) == 0xf0) {
+        length = 4;
+        code_point = lead & 0x07;
+        minimum = 0x10000;
+    } else {
+        *index = i + 1;
+        return kReplacement;
+    }
+
+    if (size - i < static_cast<size_t>(length)) {
+        *index = i + 1;
+        return kReplacement;
+    }
+
+    for (int c = 1; c < length; ++c) {
+        unsigned char continuation = input[i + c];
+        if ((continuation & 0xc0) != 0x80) {
+            *index = i + 1;
+            return kReplacement;
+        }
+        code_point = (code_point << 6) | (continuation & 0x3f);
+    }
+
+    if (code_point < minimum || code_point > 0x10ffff || (code_point >= 0xd800 && code_point <= 0xdfff)) {
+        *index = i + 1;
+        return kReplacement;
+    }
+
+    *index = i + length;
+    return code_point;
+}
+
+// Transcodes UTF-8 into `output`, reusing its capacity. Runs of ASCII are widened 16 bytes at a
+// time.
+inline void utf8_to_utf32(const char* string, size_t size, std::u32string* output) {
+    auto input = reinterpret_cast<const unsigned char*>(string);
+    output->resize(size);
+    char32_t* out = &(*output)[0];
+
+    size_t i = 0;
+    size_t written = 0;
+    while (i < size) {
+        if (size - i >= 16 && ascii_block_to_utf32(input + i, out + written)) {
+            i += 16;
+            written += 16;
+        } else {
+            out[written++] = decode_utf8(input, size, &i);
+        }
+    }
+
+    output->resize(written);
+}
+
+inline void text_set_utf8(VisageText* text, const char* string, size_t size) {
+    utf8_to_utf32(string, size, &text->utf32);
+    text->text.setText(text->utf32);
+    mark_used_glyphs(text->font.entry.get(), text->utf32.data(), text->utf32.size());
+    text->utf8.assign(string, size);
+    text->has_utf8 = true;
+}
+
+template <typename T>
+inline float load_sample(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return static_cast<float>(value);
+}
+
+// Converts `count` samples of `T` spaced `stride` bytes apart into `value * scale + offset`.
+// Contiguous samples and every other sample of an interleaved pair go through SIMD, anything else
+// is gathered one sample at a time. The SIMD loads read whole groups, so pairs only take the
+// vector path while a later sample exists to bound the over-read.
+template <typename T>
+void convert_samples(float* dest, const char* data, size_t stride, int count, float scale, float offset) {
+    int i = 0;
+    [[maybe_unused]] bool contiguous = stride == sizeof(T);
+    [[maybe_unused]] bool pairs = stride == 2 * sizeof(T);
+
+#if VISAGE_C_SSE2
+    __m128 scale4 = _mm_set1_ps(scale);
+    __m128 offset4 = _mm_set1_ps(offset);
+    auto store = [&](int index, __m128 values) {
+        _mm_storeu_ps(dest + index, _mm_add_ps(_mm_mul_ps(values, scale4), offset4));
+    };
+
+    if constexpr (std::is_same_v<T, float>) {
+        for (; contiguous && i + 4 <= count; i += 4)
+            store(i, _mm_loadu_ps(reinterpret_cast<const float*>(data) + i));
+        for (; pairs && i + 4 < count; i += 4) {
+            const float* group = reinterpret_cast<const float*>(data) + 2 * i;
+            store(i, _mm_shuffle_ps(_mm_loadu_ps(group), _mm_loadu_ps(group + 4), _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+    } else if constexpr (std::is_same_v<T, double>) {
+        // Two doubles at a time can be gathered from any stride without over-reading.
+        for (; i + 4 <= count; i += 4) {
+            const char* group = data + i * stride;
+            __m128d low = _mm_loadh_pd(_mm_load_sd(reinterpret_cast<const double*>(group)),
+                                       reinterpret_cast<const double*>(group + stride));
+            __m128d high = _mm_loadh_pd(_mm_load_sd(reinterpret_cast<const double*>(group + 2 * stride)),
+                                        reinterpret_cast<const double*>(group + 3 * stride));
+            store(i, _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high)));
+        }
+    } else if constexpr (std::is_same_v<T, int16_t>) {
+        for (; contiguous && i + 8 <= count; i += 8) {
+            __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * stride));
+            store(i, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16)));
+            store(i + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16)));
+        }
+        for (; pairs && i + 4 < count; i += 4) {
+            __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * stride));
+            store(i, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(values, 16), 16)));
+        }
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+        for (; contiguous && i + 4 <= count; i += 4)
+            store(i, _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * stride))));
+        for (; pairs && i + 4 < count; i += 4) {
+            const char* group = data + i * stride;
+            __m128 low = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+            __m128 high = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group + 16)));
+            store(i, _mm_cvtepi32_ps(_mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)))));
+        }
+    }
+#elif VISAGE_C_NEON
+    float32x4_t scale4 = vdupq_n_f32(scale);
+    float32x4_t offset4 = vdupq_n_f32(offset);
+    auto store = [&](int index, float32x4_t values) { vst1q_f32(dest + index, vmlaq_f32(offset4, values, scale4)); };
+
+    if constexpr (std::is_same_v<T, float>) {
+        for (; contiguous && i + 4 <= count; i += 4)
+            store(i, vld1q_f32(reinterpret_cast<const float*>(data) + i));
+        for (; pairs && i + 4 < count; i += 4)
+            store(i, vld2q_f32(reinterpret_cast<const float*>(data) + 2 * i).val[0]);
+    } else if constexpr (std::is_same_v<T, double>) {
+        for (; contiguous && i + 4 <= count; i += 4) {
+            const double* group = reinterpret_cast<const double*>(data) + i;
+            store(i, vcombine_f32(vcvt_f32_f64(vld1q_f64(group)), vcvt_f32_f64(vld1q_f64(group + 2))));
+        }
+        for (; pairs && i + 4 < count; i += 4) {
+            const double* group = reinterpret_cast<const double*>(data) + 2 * i;
+            store(i, vcombine_f32(vcvt_f32_f64(vld2q_f64(group).val[0]), vcvt_f32_f64(vld2q_f64(group + 4).val[0])));
+        }
+    } else if constexpr (std::is_same_v<T, int16_t>) {
+        for (; contiguous && i + 8 <= count; i += 8) {
+            int16x8_t values = vld1q_s16(reinterpret_cast<const int16_t*>(data) + i);
+            store(i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(values))));
+            store(i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(values))));
+        }
+        for (; pairs && i + 4 < count; i += 4)
+            store(i, vcvtq_f32_s32(vmovl_s16(vld2_s16(reinterpret_cast<const int16_t*>(data) + 2 * i).val[0])));
+    } else if constexpr (std::is_same_v<T, int32_t>) {
+        for (; contiguous && i + 4 <= count; i += 4)
+            store(i, vcvtq_f32_s32(vld1q_s32(reinterpret_cast<const int32_t*>(data) + i)));
+        for (; pairs && i + 4 < count; i += 4)
+            store(i, vcvtq_f32_s32(vld2q_s32(reinterpret_cast<const int32_t*>(data) + 2 * i).val[0]));
+    }
+#endif
+
+    for (; i < count; ++i)
+        dest[i] = load_sample<T>(data + i * stride) * scale + offset;
+}
+
+// Reduces groups of four floats to their minimum and maximum. `mins` and `maxs` are read as the
+// inputs, so the same kernel builds the first level from samples (both pointing at the samples)
+// and every coarser level from the one below.
+inline void reduce_min_max4(const float* mins, const float* maxs, size_t num_outputs, float* out_mins, float* out_maxs) {
+    size_t i = 0;
+#if VISAGE_C_SSE2
+    for (; i + 4 <= num_outputs; i += 4) {
+        __m128 min0 = _mm_loadu_ps(mins + 4 * i);
+        __m128 min1 = _mm_loadu_ps(mins + 4 * i + 4);
+        __m128 min2 = _mm_loadu_ps(mins + 4 * i + 8);
+        __m128 min3 = _mm_loadu_ps(mins + 4 * i + 12);
+        _MM_TRANSPOSE4_PS(min0, min1, min2, min3);
+        _mm_storeu_ps(out_mins + i, _mm_min_ps(_mm_min_ps(min0, min1), _mm_min_ps(min2, min3)));
+
+        __m128 max0 = _mm_loadu_ps(maxs + 4 * i);
+        __m128 max1 = _mm_loadu_ps(maxs + 4 * i + 4);
+        __m128 max2 = _mm_loadu_ps(maxs + 4 * i + 8);
+        __m128 max3 = _mm_loadu_ps(maxs + 4 * i + 12);
+        _MM_TRANSPOSE4_PS(max0, max1, max2, max3);
+        _mm_storeu_ps(out_maxs + i, _mm_max_ps(_mm_max_ps(max0, max1), _mm_max_ps(max2, max3)));
+    }
+#elif VISAGE_C_NEON
+    for (; i + 4 <= num_outputs; i += 4) {
+        float32x4x4_t min_groups = vld4q_f32(mins + 4 * i);
+        float32x4_t min_low = vminq_f32(min_groups.val[0], min_groups.val[1]);
+        float32x4_t min_high = vminq_f32(min_groups.val[2], min_groups.val[3]);
+        vst1q_f32(out_mins + i, vminq_f32(min_low, min_high));
+
+        float32x4x4_t max_groups = vld4q_f32(maxs + 4 * i);
+        float32x4_t max_low = vmaxq_f32(max_groups.val[0], max_groups.val[1]);
+        float32x4_t max_high = vmaxq_f32(max_groups.val[2], max_groups.val[3]);
+        vst1q_f32(out_maxs + i, vmaxq_f32(max_low, max_high));
+    }
+#endif
+    for (; i < num_outputs; ++i) {
+        const float* group_mins = mins + 4 * i;
+        const float* group_maxs = maxs + 4 * i;
+        out_mins[i] = std::min(std::min(group_mins[0], group_mins[1]), std::min(group_mins[2], group_mins[3]));
+        out_maxs[i] = std::max(std::max(group_maxs[0], group_maxs[1]), std::max(group_maxs[2], group_maxs[3]));
+    }
+}
+
+// Samples plus a min/max pyramid over them. Level `l` holds the minimum and maximum of every
+// block of 4^(l + 1) samples, so the extremes under a pixel column come from a few values per
+// level however many samples the column covers.
+class LinePyramid {
+public:
+    static constexpr int kBranching = 4;
+
+    void setSamples(const float* samples, int num_samples) {
+        samples_.assign(samples, samples + std::max(num_samples, 0));
+        levels_.clear();
+
+        size_t size = samples_.size();
+        while (size > 1) {
+            size = (size + kBranching - 1) / kBranching;
+            levels_.push_back({ std::vector<float>(size), std::vector<float>(size) });
+        }
+        rebuild(0, samples_.size());
+    }
+
+    // Replaces `count` samples from `start` and refreshes only the blocks covering them.
+    void updateSamples(int start, const float* samples, int count) {
+        if (start < 0) {
+            samples -= start;
+            count += start;
+            start = 0;
+        }
+        count = std::min(count, static_cast<int>(samples_.size()) - start);
+        if (count <= 0)
+            return;
+
+        std::memcpy(samples_.data() + start, samples, count * sizeof(float));
+        rebuild(start, start + count);
+    }
+
+    void setValueRange(float min_value, float max_value) {
+        min_value_ = min_value;
+        max_value_ = max_value;
+    }
+
+    int numSamples() const { return static_cast<int>(samples_.size()); }
+
+    // Fills `line_` with two points per pixel column for `count` samples from `start`, or with the
+    // samples themselves when there are few enough.
+    visage::Line* layout(int start, int count, float width, float height, float dpi_scale) {
+        start = std::max(start, 0);
+        count = std::min(count, numSamples() - start);
+        if (count <= 0 || width <= 0.0f)
+            return nullptr;
+
+        int columns = std::max(1, static_cast<int>(width * std::max(dpi_scale, 1.0f)));
+        float range = max_value_ - min_value_;
+        float value_scale = range != 0.0f ? height / range : 0.0f;
+        auto to_y = [&](float value) { return height - (value - min_value_) * value_scale; };
+
+        if (count <= 2 * columns) {
+            setNumPoints(count);
+            float x_scale = count > 1 ? width / (count - 1) : 0.0f;
+            for (int i = 0; i < count; ++i) {
+                line_.x[i] = i * x_scale;
+                line_.y[i] = to_y(samples_[start + i]);
+            }
+            return &line_;
+        }
+
+        double samples_per_column = static_cast<double>(count) / columns;
+        setNumPoints(2 * columns);
+        float x_scale = columns > 1 ? width / (columns - 1) : 0.0f;
+        for (int column = 0; column < columns; ++column) {
+            size_t begin = start + static_cast<size_t>(column * samples_per_column);
+            size_t end = std::max(begin + 1, start + static_cast<size_t>((column + 1) * samples_per_column));
+            float min = 0.0f;
+            float max = 0.0f;
+            rangeMinMax(begin, end, min, max);
+
+            // Alternating the order keeps the polyline a continuous zig-zag between columns.
+            float x = column * x_scale;
+            bool rising = column % 2 == 0;
+            line_.x[2 * column] = x;
+            line_.y[2 * column] = to_y(rising ? min : max);
+            line_.x[2 * column + 1] = x;
+            line_.y[2 * column + 1] = to_y(rising ? max : min);
+        }
+        return &line_;
+    }
+
+private:
+    struct Level {
+        std::vector<float> mins;
+        std::vector<float> maxs;
+    };
+
+    void setNumPoints(int num_points) {
+        if (line_.num_points != num_points)
+            line_.setNumPoints(num_points);
+    }
+
+    // Exact minimum and maximum of the samples in [begin, end). Unaligned ends are taken from the
+    // finer level and the aligned middle moves up a level, so this reads at most a few values per
+    // level.
+    void rangeMinMax(size_t begin, size_t end, float& min, float& max) const {
+        min = samples_[begin];
+        max = samples_[begin];
+        const float* mins = samples_.data();
+        const float* maxs = samples_.data();
+
+        for (size_t level = 0; begin < end; ++level) {
+            bool top = level == levels_.size();
+            while (begin < end && (top || begin % kBranching)) {
+                min = std::min(min, mins[begin]);
+                max = std::max(max, maxs[begin]);
+                ++begin;
+            }
+            while (end > begin && end % kBranching) {
+                --end;
+                min = std::min(min, mins[end]);
+                max = std::max(max, maxs[end]);
+            }
+            if (top)
+                break;
+
+            begin /= kBranching;
+            end /= kBranching;
+            mins = levels_[level].mins.data();
+            maxs = levels_[level].maxs.data();
+        }
+    }
+
+    // Recomputes every level over the samples in [begin, end).
+    void rebuild(size_t begin, size_t end) {
+        const float* mins = samples_.data();
+        const float* maxs = samples_.data();
+        size_t size = samples_.size();
+
+        for (Level& level : levels_) {
+            begin /= kBranching;
+            end = (end + kBranching - 1) / kBranching;
+
+            // Only whole groups go through the kernel, a partial last group is reduced here.
+            size_t whole = std::min(end, size / kBranching);
+            if (whole > begin)
+                reduce_min_max4(mins + begin * kBranching, maxs + begin * kBranching, whole - begin, level.mins.data() + begin,
+                                level.maxs.data() + begin);
+            for (size_t i = std::max(begin, whole); i < end; ++i) {
+                size_t group_end = std::min(size, (i + 1) * kBranching);
+                level.mins[i] = *std::min_element(mins + i * kBranching, mins + group_end);
+                level.maxs[i] = *std::max_element(maxs + i * kBranching, maxs + group_end);
+            }
+
+            mins = level.mins.data();
+            maxs = level.maxs.data();
+            size = level.mins.size();
+        }
+    }
+
+    std::vector<float> samples_;
+    std::vector<Level> levels_;
+    visage::Line line_;
+    float min_value_ = -1.0f;
+    float max_value_ = 1.0f;
+};
+
+// Single producer, single consumer ring of samples feeding a line. The producer only ever moves
+// `write_`, the consumer only `read_`, so pushing never locks, allocates or waits. Drawing copies
+// the newest `window` samples straight out of the ring and then releases everything older, which
+// leaves the producer `capacity - window` samples of room between frames.
+class LineFeed {
+public:
+    LineFeed(int window, int capacity) : window_(std::max(window, 1)) {
+        size_t size = 1;
+        while (size < static_cast<size_t>(std::max(capacity, 2 * window_)))
+            size *= 2;
+        ring_.reset(new float[size]());
+        mask_ = size - 1;
+        line_.setNumPoints(window_);
+    }
+
+    // Producer side. Writes as many samples as there is room for and counts the rest as dropped.
+    int push(const float* samples, int count) {
+        if (count <= 0)
+            return 0;
+
+        uint64_t write = write_.load(std::memory_order_relaxed);
+        uint64_t read = read_.load(std::memory_order_acquire);
+        size_t room = (mask_ + 1) - static_cast<size_t>(write - read);
+        size_t written = std::min(room, static_cast<size_t>(count));
+
+        size_t offset = write & mask_;
+        size_t first = std::min(written, mask_ + 1 - offset);
+        std::memcpy(ring_.get() + offset, samples, first * sizeof(float));
+        std::memcpy(ring_.get(), samples + first, (written - first) * sizeof(float));
+        write_.store(write + written, std::memory_order_release);
+
+        pushed_.fetch_add(written, std::memory_order_relaxed);
+        if (written < static_cast<size_t>(count)) {
+            dropped_.fetch_add(count - written, std::memory_order_relaxed);
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return static_cast<int>(written);
+    }
+
+    // Consumer side. Lays the newest window out across `width` x `height`, padding with the bottom
+    // of the value range until the producer has written a full window.
+    visage::Line* consume(float width, float height) {
+        uint64_t write = write_.load(std::memory_order_acquire);
+        uint64_t start = write - std::min<uint64_t>(write, window_);
+        int padding = window_ - static_cast<int>(write - start);
+
+        float range = max_value_ - min_value_;
+        float value_scale = range != 0.0f ? height / range : 0.0f;
+        for (int i = 0; i < padding; ++i)
+            line_.y[i] = height;
+        for (int i = padding; i < window_; ++i)
+            line_.y[i] = height - (ring_[(start + i - padding) & mask_] - min_value_) * value_scale;
+
+        read_.store(start, std::memory_order_release);
+        consumed_ = write;
+
+        if (width != laid_out_width_) {
+            laid_out_width_ = width;
+            float x_scale = window_ > 1 ? width / (window_ - 1) : 0.0f;
+            for (int i = 0; i < window_; ++i)
+                line_.x[i] = i * x_scale;
+        }
+        return &line_;
+    }
+
+    void setValueRange(float min_value, float max_value) {
+        min_value_ = min_value;
+        max_value_ = max_value;
+    }
+
+    visage::Line* line() { return &line_; }
+
+    void stats(VisageLineFeedStats* stats) const {
+        stats->pushed = pushed_.load(std::memory_order_relaxed);
+        stats->dropped = dropped_.load(std::memory_order_relaxed);
+        stats->overruns = overruns_.load(std::memory_order_relaxed);
+        stats->pending = write_.load(std::memory_order_acquire) - consumed_;
+        stats->capacity = static_cast<int32_t>(mask_ + 1);
+        stats->window = window_;
+    }
+
+private:
+    std::unique_ptr<float[]> ring_;
+    size_t mask_ = 0;
+    int window_ = 1;
+
+    // Written by the producer and read by the consumer, and the other way around, so each index
+    // gets its own cache line.
+    alignas(64) std::atomic<uint64_t> write_ { 0 };
+    alignas(64) std::atomic<uint64_t> read_ { 0 };
+    std::atomic<uint64_t> pushed_ { 0 };
+    std::atomic<uint64_t> dropped_ { 0 };
+    std::atomic<uint64_t> overruns_ { 0 };
+
+    alignas(64) uint64_t consumed_ = 0;
+    visage::Line line_;
+    float laid_out_width_ = -1.0f;
+    float min_value_ = -1.0f;
+    float max_value_ = 1.0f;
+};
+
+// Several lines sharing one set of x values. The x values are stored once and the y values of
+// every series in one block, series after series. Each series is a visage::Line pointed into those
+// buffers, so drawing copies nothing. visage::Line owns its arrays through unique_ptrs, so the
+// lines' pointers are released before the buffers go away; copies of a line, like recorded ones,
+// own arrays of their own.
+class LineSeries {
+public:
+    LineSeries(int num_series, int num_points) : lines_(std::max(num_series, 0)), brushes_(lines_.size()) {
+        setNumPoints(num_points);
+    }
+    ~LineSeries() { releaseLines(); }
+
+    LineSeries(const LineSeries&) = delete;
+    LineSeries& operator=(const LineSeries&) = delete;
+
+    void setNumPoints(int num_points) {
+        releaseLines();
+        num_points_ = std::max(num_points, 0);
+        size_t points = num_points_;
+        x_ = std::make_unique<float[]>(points);
+        y_ = std::make_unique<float[]>(points * lines_.size());
+        // visage reads fill values for every point, which are the same zeros for every series.
+        values_ = std::make_unique<float[]>(points);
+
+        for (size_t i = 0; i < lines_.size(); ++i) {
+            visage::Line& line = lines_[i];
+            line.num_points = num_points_;
+            line.x.reset(x_.get());
+            line.y.reset(y_.get() + i * points);
+            line.values.reset(values_.get());
+        }
+    }
+
+    int numSeries() const { return static_cast<int>(lines_.size()); }
+    int numPoints() const { return num_points_; }
+
+    float* xValues() { return lines_.empty() || num_points_ == 0 ? nullptr : x_.get(); }
+    float* yValues() { return lines_.empty() || num_points_ == 0 ? nullptr : y_.get(); }
+
+    float* seriesValues(int series) {
+        if (series < 0 || series >= numSeries() || num_points_ == 0)
+            return nullptr;
+        return lines_[series].y.get();
+    }
+
+    void setBrush(int series, const VisageBrush_t* brush) {
+        if (series < 0 || series >= numSeries())
+            return;
+
+        if (brush)
+            brushes_[series] = std::make_unique<VisageBrush_t>(*brush);
+        else
+            brushes_[series].reset();
+    }
+
+    const VisageBrush_t* brush(int series) const { return brushes_[series].get(); }
+
+    std::vector<visage::Line>& lines() { return lines_; }
+
+private:
+    // Takes the buffers back from the lines without freeing them.
+    void releaseLines() {
+        for (visage::Line& line : lines_) {
+            line.x.release();
+            line.y.release();
+            line.values.release();
+            line.num_points = 0;
+        }
+    }
+
+    std::unique_ptr<float[]> x_;
+    std::unique_ptr<float[]> y_;
+    std::unique_ptr<float[]> values_;
+    std::vector<visage::Line> lines_;
+    std::vector<std::unique_ptr<VisageBrush_t>> brushes_;
+    int num_points_ = 0;
+};
+
+// Converts a row of caller pixels into the RGBA8 bytes visage uploads. ARGB8 pixels are the bytes
+// blue, green, red, alpha in memory and float pixels are VisageColor channel order, so both only
+// need red and blue swapped on the way.
+inline void argb_row_to_rgba(const uint32_t* source, int count, uint8_t* dest) {
+    int i = 0;
+#if VISAGE_C_SSE2
+    __m128i green_alpha = _mm_set1_epi32(static_cast<int>(0xff00ff00));
+    __m128i low_byte = _mm_set1_epi32(0xff);
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        __m128i red = _mm_and_si128(_mm_srli_epi32(pixels, 16), low_byte);
+        __m128i blue = _mm_slli_epi32(_mm_and_si128(pixels, low_byte), 16);
+        __m128i swapped = _mm_or_si128(_mm_and_si128(pixels, green_alpha), _mm_or_si128(red, blue));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4 * i), swapped);
+    }
+#elif VISAGE_C_NEON
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t pixels = vld4q_u8(reinterpret_cast<const uint8_t*>(source + i));
+        uint8x16_t blue = pixels.val[0];
+        pixels.val[0] = pixels.val[2];
+        pixels.val[2] = blue;
+        vst4q_u8(dest + 4 * i, pixels);
+    }
+#endif
+    for (; i < count; ++i) {
+        uint32_t pixel = source[i];
+        uint32_t rgba = (pixel & 0xff00ff00) | ((pixel >> 16) & 0xff) | ((pixel & 0xff) << 16);
+        std::memcpy(dest + 4 * i, &rgba, sizeof(rgba));
+    }
+}
+
+inline void float_row_to_rgba(const float* source, int count, uint8_t* dest) {
+    int i = 0;
+#if VISAGE_C_SSE2
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 scale = _mm_set1_ps(255.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+    auto to_bytes = [&](const float* pixel) {
+        __m128 values = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pixel), zero), one);
+        values = _mm_shuffle_ps(values, values, _MM_SHUFFLE(3, 0, 1, 2));
+        return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(values, scale), half));
+    };
+    for (; i + 4 <= count; i += 4) {
+        const float* group = source + 4 * i;
+        __m128i low = _mm_packs_epi32(to_bytes(group), to_bytes(group + 4));
+        __m128i high = _mm_packs_epi32(to_bytes(group + 8), to_bytes(group + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4 * i), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < count; ++i) {
+        const float* pixel = source + 4 * i;
+        uint8_t* out = dest + 4 * i;
+        int channels[] = { VisageColorChannelRed, VisageColorChannelGreen, VisageColorChannelBlue, VisageColorChannelAlpha };
+        for (int c = 0; c < 4; ++c)
+            out[c] = static_cast<uint8_t>(std::min(std::max(pixel[channels[c]], 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+}
+
+// Pixels owned by the caller, drawn through visage's image atlas. The image is split into square
+// tiles that are converted and uploaded separately, and each tile tracks the rectangle changed in
+// it, so a changed column or rectangle only converts the pixels it touches. visage identifies
+// images by data pointer, so a changed tile gets a buffer it wasn't drawn from before: a recycled
+// one that nothing draws anymore, or a new one. Scrolling rotates which tile is drawn where
+// instead of moving pixels.
+class ImageSurface {
+public:
+    static constexpr int kTileSize = 128;
+
+    struct Tile {
+        std::shared_ptr<const uint8_t> pixels;
+        // Changed area in tile pixels, empty once converted.
+        int dirty_left = 0;
+        int dirty_top = 0;
+        int dirty_right = 0;
+        int dirty_bottom = 0;
+
+        bool dirty() const { return dirty_left < dirty_right && dirty_top < dirty_bottom; }
+    };
+
+    ImageSurface(const void* pixels, int format, int width, int height, int row_stride) :
+        format_(format), width_(std::max(width, 0)), height_(std::max(height, 0)) {
+        columns_ = (width_ + kTileSize - 1) / kTileSize;
+        rows_ = (height_ + kTileSize - 1) / kTileSize;
+        tiles_.resize(columns_ * rows_);
+        setPixels(pixels, row_stride);
+    }
+
+    void setPixels(const void* pixels, int row_stride) {
+        pixels_ = static_cast<const char*>(pixels);
+        row_stride_ = row_stride > 0 ? row_stride : width_ * bytesPerPixel();
+        updateRect(0, 0, width_, height_);
+    }
+
+    void updateRect(int x, int y, int width, int height) {
+        int left = std::max(x, 0);
+        int top = std::max(y, 0);
+        int right = std::min(x + width, width_);
+        int bottom = std::min(y + height, height_);
+        if (left >= right || top >= bottom)
+            return;
+
+        for (int row = top / kTileSize; row <= (bottom - 1) / kTileSize; ++row) {
+            for (int column = left / kTileSize; column <= (right - 1) / kTileSize; ++column) {
+                int tile_x = column * kTileSize;
+                int tile_y = row * kTileSize;
+                int tile_left = std::max(left - tile_x, 0);
+                int tile_top = std::max(top - tile_y, 0);
+                int tile_right = std::min(right - tile_x, tileWidth(column));
+                int tile_bottom = std::min(bottom - tile_y, tileHeight(row));
+
+                Tile& tile = tiles_[row * columns_ + column];
+                if (tile.dirty()) {
+                    tile.dirty_left = std::min(tile.dirty_left, tile_left);
+                    tile.dirty_top = std::min(tile.dirty_top, tile_top);
+                    tile.dirty_right = std::max(tile.dirty_right, tile_right);
+                    tile.dirty_bottom = std::max(tile.dirty_bottom, tile_bottom);
+                } else {
+                    tile.dirty_left = tile_left;
+                    tile.dirty_top = tile_top;
+                    tile.dirty_right = tile_right;
+                    tile.dirty_bottom = tile_bottom;
+                }
+            }
+        }
+    }
+
+    void setScrollOffset(int offset) {
+        scroll_offset_ = width_ > 0 ? ((offset % width_) + width_) % width_ : 0;
+    }
+
+    int scrollOffset() const { return scroll_offset_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int columns() const { return columns_; }
+    int rows() const { return rows_; }
+
+    void stats(VisageImageStats* stats) const {
+        stats->tiles = static_cast<int32_t>(tiles_.size());
+        stats->tile_uploads = tile_uploads_;
+        stats->uploaded_pixels = uploaded_pixels_;
+    }
+
+    int tileWidth(int column) const { return std::min(kTileSize, width_ - column * kTileSize); }
+    int tileHeight(int row) const { return std::min(kTileSize, height_ - row * kTileSize); }
+
+    // Converts the changed part of the tile, if any, and returns its RGBA8 pixels. The rest of the
+    // tile is copied from its previous buffer. A buffer handed out is never written again while
+    // anyone else holds it: whoever draws the pixels keeps a reference until the atlas can't refer
+    // to them anymore, see FramePixels.
+    const std::shared_ptr<const uint8_t>& tilePixels(int column, int row) {
+        Tile& tile = tiles_[row * columns_ + column];
+        if (!tile.dirty())
+            return tile.pixels;
+
+        int tile_width = tileWidth(column);
+        int tile_height = tileHeight(row);
+        std::shared_ptr<uint8_t> buffer = freeBuffer();
+        if (tile.pixels) {
+            std::memcpy(buffer.get(), tile.pixels.get(), static_cast<size_t>(tile_width) * tile_height * 4);
+        } else {
+            tile.dirty_left = 0;
+            tile.dirty_top = 0;
+            tile.dirty_right = tile_width;
+            tile.dirty_bottom = tile_height;
+        }
+
+        int dirty_width = tile.dirty_right - tile.dirty_left;
+        for (int y = tile.dirty_top; y < tile.dirty_bottom; ++y) {
+            const char* source = pixels_ + static_cast<size_t>(row * kTileSize + y) * row_stride_ +
+                                 static_cast<size_t>(column * kTileSize + tile.dirty_left) * bytesPerPixel();
+            uint8_t* dest = buffer.get() + (static_cast<size_t>(y) * tile_width + tile.dirty_left) * 4;
+            if (format_ == VisageImageFormatFloat)
+                float_row_to_rgba(reinterpret_cast<const float*>(source), dirty_width, dest);
+            else
+                argb_row_to_rgba(reinterpret_cast<const uint32_t*>(source), dirty_width, dest);
+        }
+
+        tile_uploads_++;
+        uploaded_pixels_ += static_cast<uint64_t>(dirty_width) * (tile.dirty_bottom - tile.dirty_top);
+        if (tile.pixels)
+            buffers_.push_back(std::move(tile.pixels));
+        tile.pixels = std::move(buffer);
+        tile.dirty_right = tile.dirty_left;
+        return tile.pixels;
+    }
+
+private:
+    int bytesPerPixel() const { return format_ == VisageImageFormatFloat ? 4 * sizeof(float) : sizeof(uint32_t); }
+
+    // Returns a buffer of a replaced tile that only this surface still references, or a new one.
+    // Frames let go of the buffers they drew once the atlas can't refer to them anymore. Past one
+    // spare buffer per tile, the oldest are freed instead of kept.
+    std::shared_ptr<uint8_t> freeBuffer() {
+        for (size_t i = 0; i < buffers_.size(); ++i) {
+            if (buffers_[i].use_count() == 1) {
+                std::shared_ptr<const uint8_t> buffer = std::move(buffers_[i]);
+                buffers_.erase(buffers_.begin() + static_cast<std::ptrdiff_t>(i));
+                return std::const_pointer_cast<uint8_t>(buffer);
+            }
+        }
+
+        if (buffers_.size() > tiles_.size())
+            buffers_.erase(buffers_.begin());
+        return std::shared_ptr<uint8_t>(new uint8_t[static_cast<size_t>(kTileSize) * kTileSize * 4],
+                                        std::default_delete<uint8_t[]>());
+    }
+
+    const char* pixels_ = nullptr;
+    int format_ = VisageImageFormatARGB8;
+    int width_ = 0;
+    int height_ = 0;
+    int row_stride_ = 0;
+    int columns_ = 0;
+    int rows_ = 0;
+    int scroll_offset_ = 0;
+    std::vector<Tile> tiles_;
+    // Buffers of replaced tiles, oldest first, reused once nothing else references them.
+    std::vector<std::shared_ptr<const uint8_t>> buffers_;
+    uint64_t tile_uploads_ = 0;
+    uint64_t uploaded_pixels_ = 0;
+};
+
+struct VisageSvg_t {
+    ~VisageSvg_t() { nsvgDelete(image); }
+
+    uint64_t id = 0;
+    NSVGimage* image = nullptr;
+};
+
+struct SvgRaster {
+    int width = 0;
+    int height = 0;
+    std::unique_ptr<uint8_t[]> pixels;
+};
+
+// Rasterizes `svg` scaled to fit `width` x `height` pixels and centered. nanosvg images are only
+// read while rasterizing, so several threads can rasterize the same svg with their own rasterizer.
+inline std::shared_ptr<const SvgRaster> rasterize_svg(const VisageSvg_t* svg, int width, int height) {
+    thread_local std::unique_ptr<NSVGrasterizer, void (*)(NSVGrasterizer*)> rasterizer(nsvgCreateRasterizer(),
+                                                                                       nsvgDeleteRasterizer);
+
+    auto raster = std::make_shared<SvgRaster>();
+    raster->width = width;
+    raster->height = height;
+    raster->pixels.reset(new uint8_t[static_cast<size_t>(width) * height * 4]());
+
+    NSVGimage* image = svg->image;
+    if (rasterizer && image->width > 0.0f && image->height > 0.0f) {
+        float scale = std::min(width / image->width, height / image->height);
+        float offset_x = 0.5f * (width - image->width * scale);
+        float offset_y = 0.5f * (height - image->height * scale);
+        nsvgRasterize(rasterizer.get(), image, offset_x, offset_y, scale, raster->pixels.get(), width, height, width * 4);
+    }
+    return raster;
+}
+
+// Rasterized svgs keyed by svg and pixel size, evicting the least recently used past a byte
+// budget. The pixel size already folds in the dpi scale, so returning to a scale or size that was
+// drawn before is a hit. Thread safe.
+class SvgCache {
+public:
+    static constexpr size_t kDefaultCapacity = 64 * 1024 * 1024;
+
+    struct Key {
+        uint64_t svg = 0;
+        int width = 0;
+        int height = 0;
+
+        bool operator<(const Key& other) const {
+            return std::tie(svg, width, height) < std::tie(other.svg, other.width, other.height);
+        }
+        bool operator==(const Key& other) const {
+            return svg == other.svg && width == other.width && height == other.height;
+        }
+    };
+
+    // Never destroyed, svgs may still be deleted during static destruction.
+    static SvgCache& instance() {
+        static SvgCache* cache = new SvgCache;
+        return *cache;
+    }
+
+    static Key key(const VisageSvg_t* svg, float width, float height, float dpi_scale) {
+        float scale = dpi_scale > 0.0f ? dpi_scale : 1.0f;
+        return { svg->id, std::max(1, static_cast<int>(width * scale + 0.5f)), std::max(1, static_cast<int>(height * scale + 0.5f)) };
+    }
+
+    // Looks up every key and rasterizes the missing ones in parallel before returning.
+    std::vector<std::shared_ptr<const SvgRaster>> resolve(const VisageSvg_t* const* svgs, const Key* keys, size_t count) {
+        std::vector<std::shared_ptr<const SvgRaster>> rasters(count);
+        std::vector<size_t> misses;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < count; ++i) {
+                auto found = entries_.find(keys[i]);
+                if (found != entries_.end()) {
+                    lru_.splice(lru_.begin(), lru_, found->second);
+                    rasters[i] = found->second->raster;
+                    hits_++;
+                    continue;
+                }
+
+                auto same_miss = [&](size_t miss) { return keys[miss] == keys[i]; };
+                if (std::none_of(misses.begin(), misses.end(), same_miss)) {
+                    misses.push_back(i);
+                    misses_++;
+                }
+            }
+        }
+
+        parallel_for(misses.size(), [&](size_t m) {
+            size_t i = misses[m];
+            rasters[i] = rasterize_svg(svgs[i], keys[i].width, keys[i].height);
+        });
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i : misses) {
+            if (entries_.count(keys[i]) == 0) {
+                lru_.push_front({ keys[i], rasters[i] });
+                entries_[keys[i]] = lru_.begin();
+                bytes_ += rasterBytes(*rasters[i]);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (rasters[i] == nullptr)
+                rasters[i] = entries_[keys[i]]->raster;
+        }
+        evict();
+        return rasters;
+    }
+
+    void remove(uint64_t svg) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = lru_.begin(); it != lru_.end();) {
+            if (it->key.svg == svg) {
+                bytes_ -= rasterBytes(*it->raster);
+                entries_.erase(it->key);
+                it = lru_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void setCapacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        evict();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.clear();
+        entries_.clear();
+        bytes_ = 0;
+    }
+
+    VisageSvgCacheStats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return { hits_, misses_, evictions_, bytes_, capacity_, static_cast<int32_t>(entries_.size()) };
+    }
+
+private:
+    struct Entry {
+        Key key;
+        std::shared_ptr<const SvgRaster> raster;
+    };
+
+    static uint64_t rasterBytes(const SvgRaster& raster) { return static_cast<uint64_t>(raster.width) * raster.height * 4; }
+
+    // Rasters still referenced by a canvas stay alive through their shared pointer until that
+    // canvas is cleared, so evicting never pulls pixels out from under a frame.
+    void evict() {
+        while (bytes_ > capacity_ && !lru_.empty()) {
+            bytes_ -= rasterBytes(*lru_.back().raster);
+            entries_.erase(lru_.back().key);
+            lru_.pop_back();
+            evictions_++;
+        }
+    }
+
+    std::mutex mutex_;
+    std::list<Entry> lru_;
+    std::map<Key, std::list<Entry>::iterator> entries_;
+    uint64_t bytes_ = 0;
+    uint64_t capacity_ = kDefaultCapacity;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
+
+// Command streams are a flat encoding of a CommandList that can be written to disk and replayed
+// straight from a memory mapping. Offsets are from the start of the stream, every section is 8 byte
+// aligned and values are stored in native byte order.
+constexpr uint32_t kCommandStreamMagic = 0x53435356; // "VSCS"
+constexpr uint32_t kCommandStreamVersion = 2;
+
+enum StreamFontSource : uint32_t {
+    kStreamFontData,
+    kStreamFontLatoRegular,
+    kStreamFontDroidSansMono,
+    kStreamFontTwemojiMozilla,
+};
+
+struct StreamSection {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct StreamHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t command_size;
+    int32_t width;
+    int32_t height;
+    float dpi_scale;
+    uint32_t reserved;
+    StreamSection commands; // VisageShapeCommand
+    StreamSection colors;   // VisageColor, recorded colors followed by brush gradients
+    StreamSection brushes;  // StreamBrush
+    StreamSection texts;    // StreamText
+    StreamSection lines;    // StreamLine
+    StreamSection fonts;    // StreamFont
+    StreamSection data;     // Bytes referenced by texts, lines and fonts, offsets are relative to it
+};
+
+struct StreamBrush {
+    uint32_t kind;
+    uint32_t first_color;
+    uint32_t num_colors;
+    float from_x;
+    float from_y;
+    float to_x;
+    float to_y;
+    uint32_t reserved;
+};
+
+struct StreamText {
+    uint32_t font;
+    uint32_t justification;
+    int32_t character_override;
+    uint32_t multi_line;
+    uint64_t characters; // char32_t
+    uint64_t length;
+};
+
+struct StreamLine {
+    uint32_t num_points;
+    float line_value_scale;
+    float fill_value_scale;
+    uint32_t reserved;
+    uint64_t x; // float[num_points]
+    uint64_t y;
+    uint64_t values;
+};
+
+struct StreamFont {
+    uint32_t source;
+    float size;
+    float dpi_scale;
+    uint32_t reserved;
+    uint64_t data;
+    uint64_t data_size;
+};
+
+static_assert(sizeof(VisageShapeCommand) == 40 && sizeof(VisageColor) == 20);
+static_assert(sizeof(StreamHeader) % 8 == 0 && sizeof(StreamBrush) % 8 == 0 && sizeof(StreamText) % 8 == 0);
+static_assert(sizeof(StreamLine) % 8 == 0 && sizeof(StreamFont) % 8 == 0);
+
+// Recorded commands that reference converted state. These only live inside a CommandList and are
+// numbered clear of the public VisageShapeCommandType so that can grow without changing streams.
+enum RecordedCommandType : uint32_t {
+    kRecordedColor = 0x100, // `flags` indexes colors
+    kRecordedBrush,         // `flags` indexes brushes
+    kRecordedText,          // `flags` indexes texts, x, y, width, height, direction
+    kRecordedLine,          // `flags` indexes lines, x, y, width, height, line_width
+    kRecordedLineFill,      // `flags` indexes lines, x, y, width, height, fill_position
+    kRecordedPixels,        // `flags` indexes pixels, x, y, width, height
+};
+static_assert(static_cast<uint32_t>(VisageNumShapeCommandTypes) <= kRecordedColor);
+
+struct Bounds {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+
+    bool isEmpty() const { return width <= 0.0f || height <= 0.0f; }
+    float right() const { return x + width; }
+    float bottom() const { return y + height; }
+
+    bool overlaps(const Bounds& other) const {
+        return x < other.right() && other.x < right() && y < other.bottom() && other.y < bottom();
+    }
+    Bounds united(const Bounds& other) const {
+        if (isEmpty())
+            return other;
+        if (other.isEmpty())
+            return *this;
+
+        float left = std::min(x, other.x);
+        float top = std::min(y, other.y);
+        return { left, top, std::max(right(), other.right()) - left, std::max(bottom(), other.bottom()) - top };
+    }
+    Bounds translated(float dx, float dy) const { return { x + dx, y + dy, width, height }; }
+    Bounds expanded(float amount) const { return { x - amount, y - amount, width + 2.0f * amount, height + 2.0f * amount }; }
+};
+
+inline Bounds points_bounds(const float* points, int num_points, float padding) {
+    float left = points[0];
+    float top = points[1];
+    float right = left;
+    float bottom = top;
+    for (int i = 1; i < num_points; ++i) {
+        left = std::min(left, points[2 * i]);
+        right = std::max(right, points[2 * i]);
+        top = std::min(top, points[2 * i + 1]);
+        bottom = std::max(bottom, points[2 * i + 1]);
+    }
+    return Bounds { left, top, right - left, bottom - top }.expanded(padding);
+}
+
+// Area a drawing command can touch, relative to the position it is drawn at. Returns false for
+// commands that only change state.
+inline bool command_bounds(const VisageShapeCommand& command, Bounds* bounds) {
+    const float* v = command.values;
+
+    switch (command.type) {
+        case VisageShapeCommandFill:
+        case VisageShapeCommandRectangle:
+        case VisageShapeCommandRectangleBorder:
+        case VisageShapeCommandRoundedRectangle:
+        case VisageShapeCommandLeftRoundedRectangle:
+        case VisageShapeCommandRightRoundedRectangle:
+        case VisageShapeCommandTopRoundedRectangle:
+        case VisageShapeCommandBottomRoundedRectangle:
+        case VisageShapeCommandRoundedRectangleBorder:
+        case VisageShapeCommandSuperEllipse:
+        case kRecordedText:
+        case kRecordedLineFill:
+        case kRecordedPixels:
+            *bounds = { v[0], v[1], v[2], v[3] };
+            return true;
+        case VisageShapeCommandRectangleShadow:
+            *bounds = Bounds { v[0], v[1], v[2], v[3] }.expanded(v[4]);
+            return true;
+        case VisageShapeCommandRoundedRectangleShadow:
+            *bounds = Bounds { v[0], v[1], v[2], v[3] }.expanded(v[5]);
+            return true;
+        case kRecordedLine:
+            *bounds = Bounds { v[0], v[1], v[2], v[3] }.expanded(v[4]);
+            return true;
+        case VisageShapeCommandCircle:
+        case VisageShapeCommandFadeCircle:
+        case VisageShapeCommandRing:
+        case VisageShapeCommandSquircle:
+        case VisageShapeCommandArc:
+        case VisageShapeCommandDiamond:
+            *bounds = { v[0], v[1], v[2], v[2] };
+            return true;
+        case VisageShapeCommandArcShadow:
+            *bounds = Bounds { v[0], v[1], v[2], v[2] }.expanded(v[6]);
+            return true;
+        case VisageShapeCommandDirectionalTriangle:
+            // Loose on purpose, the triangle's extent depends on its direction.
+            *bounds = Bounds { v[0], v[1], 0.0f, 0.0f }.expanded(2.0f * v[2]);
+            return true;
+        case VisageShapeCommandSegment:
+            *bounds = points_bounds(v, 2, v[4]);
+            return true;
+        case VisageShapeCommandQuadratic:
+        case VisageShapeCommandTriangleBorder:
+        case VisageShapeCommandRoundedTriangle:
+            *bounds = points_bounds(v, 3, v[6]);
+            return true;
+        case VisageShapeCommandRoundedTriangleBorder:
+            *bounds = points_bounds(v, 3, v[6] + v[7]);
+            return true;
+        case VisageShapeCommandTriangle:
+            *bounds = points_bounds(v, 3, 0.0f);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Follows the relative position changes of SetPosition, SaveState and RestoreState so command
+// bounds can be moved into canvas coordinates.
+class PositionTracker {
+public:
+    void reset() {
+        x_ = 0.0f;
+        y_ = 0.0f;
+        saved_.clear();
+    }
+
+    void apply(const VisageShapeCommand& command) {
+        switch (command.type) {
+            case VisageShapeCommandSetPosition:
+                x_ += command.values[0];
+                y_ += command.values[1];
+                break;
+            case VisageShapeCommandSaveState:
+                saved_.push_back(x_);
+                saved_.push_back(y_);
+                break;
+            case VisageShapeCommandRestoreState:
+                if (saved_.size() >= 2) {
+                    y_ = saved_.back();
+                    saved_.pop_back();
+                    x_ = saved_.back();
+                    saved_.pop_back();
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    float x() const { return x_; }
+    float y() const { return y_; }
+
+private:
+    float x_ = 0.0f;
+    float y_ = 0.0f;
+    std::vector<float> saved_;
+};
+
+// Merged set of invalidated rectangles. Overlapping rectangles are joined and past a handful of
+// rectangles everything collapses into their union, so testing a draw call stays cheap.
+class DirtyRegion {
+public:
+    static constexpr size_t kMaxRects = 16;
+
+    bool active() const { return !rects_.empty(); }
+    const std::vector<Bounds>& rects() const { return rects_; }
+
+    void clear() { rects_.clear(); }
+
+    void invalidate(Bounds bounds) {
+        if (bounds.isEmpty())
+            return;
+
+        for (size_t i = 0; i < rects_.size();) {
+            if (rects_[i].overlaps(bounds)) {
+                bounds = bounds.united(rects_[i]);
+                rects_.erase(rects_.begin() + i);
+                i = 0;
+            } else {
+                ++i;
+            }
+        }
+        rects_.push_back(bounds);
+
+        if (rects_.size() > kMaxRects) {
+            Bounds total;
+            for (const Bounds& rect : rects_)
+                total = total.united(rect);
+            rects_ = { total };
+        }
+    }
+
+    bool touches(const Bounds& bounds) const {
+        if (rects_.empty())
+            return true;
+
+        for (const Bounds& rect : rects_) {
+            if (rect.overlaps(bounds))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    std::vector<Bounds> rects_;
+};
+
+// Hashes of what drawing a line or text reads when the frame is submitted.
+inline uint64_t line_hash(const visage::Line& line) {
+    size_t size = static_cast<size_t>(std::max(line.num_points, 0)) * sizeof(float);
+    float scales[] = { line.line_value_scale, line.fill_value_scale };
+    uint64_t hash = hash_bytes(reinterpret_cast<const char*>(scales), sizeof(scales));
+    hash = hash_combine(hash, hash_bytes(reinterpret_cast<const char*>(line.x.get()), size));
+    hash = hash_combine(hash, hash_bytes(reinterpret_cast<const char*>(line.y.get()), size));
+    return hash_combine(hash, hash_bytes(reinterpret_cast<const char*>(line.values.get()), size));
+}
+inline uint64_t text_hash(const visage::Text& text) {
+    const visage::String& string = text.text();
+    const visage::Font& font = text.font();
+    float font_values[] = { font.size(), font.dpiScale() };
+    int32_t options[] = { static_cast<int32_t>(text.justification()), static_cast<int32_t>(text.characterOverride()),
+                          text.multiLine() ? 1 : 0 };
+
+    uint64_t hash = hash_bytes(reinterpret_cast<const char*>(string.c_str()), string.length() * sizeof(char32_t));
+    hash = hash_combine(hash, reinterpret_cast<uintptr_t>(font.fontData()));
+    hash = hash_combine(hash, hash_bytes(reinterpret_cast<const char*>(font_values), sizeof(font_values)));
+    return hash_combine(hash, hash_bytes(reinterpret_cast<const char*>(options), sizeof(options)));
+}
+
+// A recorded stream of canvas commands. Colors are converted and brushes, text and lines are copied
+// when they are recorded, so replaying only walks the command array.
+class CommandList {
+public:
+    // Pixels for visage's image atlas, kept alive by `owner` while the list holds them.
+    struct Pixels {
+        std::shared_ptr<const void> owner;
+        const uint8_t* data = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+
+    void clear() {
+        commands_.clear();
+        colors_.clear();
+        brushes_.clear();
+        texts_.clear();
+        lines_.clear();
+        pixels_.clear();
+        bounds_ = {};
+        position_.reset();
+    }
+
+    void add(const VisageShapeCommand& command) {
+        commands_.push_back(command);
+        track(command);
+    }
+    void addColor(const visage::Color& color) {
+        commands_.push_back({ kRecordedColor, static_cast<uint32_t>(colors_.size()), {} });
+        colors_.push_back(color);
+    }
+    void addBrush(const VisageBrush_t& brush) {
+        commands_.push_back({ kRecordedBrush, static_cast<uint32_t>(brushes_.size()), {} });
+        brushes_.push_back(brush);
+    }
+    void addText(const visage::Text& text, float x, float y, float width, float height, int32_t direction) {
+        commands_.push_back({ kRecordedText, static_cast<uint32_t>(texts_.size()), { x, y, width, height, static_cast<float>(direction) } });
+        texts_.push_back(std::make_unique<visage::Text>(text));
+        track(commands_.back());
+    }
+    void addLine(const visage::Line& line, float x, float y, float width, float height, float line_width) {
+        commands_.push_back({ kRecordedLine, static_cast<uint32_t>(lines_.size()), { x, y, width, height, line_width } });
+        lines_.push_back(std::make_unique<visage::Line>(line));
+        track(commands_.back());
+    }
+    void addLineFill(const visage::Line& line, float x, float y, float width, float height, float fill_position) {
+        commands_.push_back({ kRecordedLineFill, static_cast<uint32_t>(lines_.size()), { x, y, width, height, fill_position } });
+        lines_.push_back(std::make_unique<visage::Line>(line));
+        track(commands_.back());
+    }
+    void addPixels(Pixels pixels, float x, float y, float width, float height) {
+        commands_.push_back({ kRecordedPixels, static_cast<uint32_t>(pixels_.size()), { x, y, width, height } });
+        pixels_.push_back(std::move(pixels));
+        track(commands_.back());
+    }
+
+    // Appends a copy of `other`, offset by `x` and `y`.
+    void append(const CommandList& other, float x, float y) {
+        add({ VisageShapeCommandSaveState, 0, {} });
+        add({ VisageShapeCommandSetPosition, 0, { x, y } });
+
+        for (const VisageShapeCommand& command : other.commands_) {
+            const float* v = command.values;
+
+            switch (command.type) {
+                case kRecordedColor:
+                    addColor(other.colors_[command.flags]);
+                    break;
+                case kRecordedBrush:
+                    addBrush(other.brushes_[command.flags]);
+                    break;
+                case kRecordedText:
+                    addText(*other.texts_[command.flags], v[0], v[1], v[2], v[3], static_cast<int32_t>(v[4]));
+                    break;
+                case kRecordedLine:
+                    addLine(*other.lines_[command.flags], v[0], v[1], v[2], v[3], v[4]);
+                    break;
+                case kRecordedLineFill:
+                    addLineFill(*other.lines_[command.flags], v[0], v[1], v[2], v[3], v[4]);
+                    break;
+                case kRecordedPixels:
+                    addPixels(other.pixels_[command.flags], v[0], v[1], v[2], v[3]);
+                    break;
+                default:
+                    add(command);
+                    break;
+            }
+        }
+
+        add({ VisageShapeCommandRestoreState, 0, {} });
+    }
+
+    // Appends the text of `other` with the color, brush and state commands it depends on, leaving
+    // out every other drawing command. Nothing is appended if `other` has no text.
+    void appendText(const CommandList& other) {
+        if (other.texts_.empty())
+            return;
+
+        for (const VisageShapeCommand& command : other.commands_) {
+            const float* v = command.values;
+            Bounds command_area;
+
+            switch (command.type) {
+                case kRecordedColor:
+                    addColor(other.colors_[command.flags]);
+                    break;
+                case kRecordedBrush:
+                    addBrush(other.brushes_[command.flags]);
+                    break;
+                case kRecordedText:
+                    addText(*other.texts_[command.flags], v[0], v[1], v[2], v[3], static_cast<int32_t>(v[4]));
+                    break;
+                case kRecordedLine:
+                case kRecordedLineFill:
+                case kRecordedPixels:
+                    break;
+                default:
+                    if (!command_bounds(command, &command_area))
+                        add(command);
+                    break;
+            }
+        }
+    }
+
+    void replay(visage::Canvas* canvas) const {
+        for (const VisageShapeCommand& command : commands_) {
+            const float* v = command.values;
+
+            switch (command.type) {
+                case kRecordedColor:
+                    canvas->setColor(colors_[command.flags]);
+                    break;
+                case kRecordedBrush:
+                    canvas->setBrush(brushes_[command.flags].brush);
+                    break;
+                case kRecordedText:
+                    canvas->text(texts_[command.flags].get(), v[0], v[1], v[2], v[3], direction_to_cpp(static_cast<int32_t>(v[4])));
+                    break;
+                case kRecordedLine:
+                    canvas->line(lines_[command.flags].get(), v[0], v[1], v[2], v[3], v[4]);
+                    break;
+                case kRecordedLineFill:
+                    canvas->lineFill(lines_[command.flags].get(), v[0], v[1], v[2], v[3], v[4]);
+                    break;
+                case kRecordedPixels: {
+                    const Pixels& pixels = pixels_[command.flags];
+                    canvas->image(pixels.data, pixels.width * pixels.height * 4, v[0], v[1], v[2], v[3]);
+                    break;
+                }
+                default:
+                    draw_shape_command(canvas, command);
+                    break;
+            }
+        }
+    }
+
+    // Hands every command to `target` with the color, brush or line it references resolved, for
+    // drawing the list somewhere other than a visage canvas.
+    template <typename Target>
+    void visit(Target& target) const {
+        for (const VisageShapeCommand& command : commands_) {
+            switch (command.type) {
+                case kRecordedColor:
+                    target.setColor(colors_[command.flags]);
+                    break;
+                case kRecordedBrush:
+                    target.setBrush(brushes_[command.flags].source);
+                    break;
+                case kRecordedText:
+                    target.text(*texts_[command.flags], command);
+                    break;
+                case kRecordedLine:
+                case kRecordedLineFill:
+                    target.line(*lines_[command.flags], command);
+                    break;
+                case kRecordedPixels:
+                    target.image(pixels_[command.flags], command);
+                    break;
+                default:
+                    target.shape(command);
+                    break;
+            }
+        }
+    }
+
+    size_t numCommands() const { return commands_.size(); }
+    // Adds what keeps the pixels in the list alive to `owners`.
+    void pixelOwners(std::vector<std::shared_ptr<const void>>* owners) const {
+        for (const Pixels& pixels : pixels_)
+            owners->push_back(pixels.owner);
+    }
+    // Bytes the list holds, including storage kept for reuse after clearing.
+    size_t memoryBytes() const {
+        size_t bytes = commands_.capacity() * sizeof(VisageShapeCommand) + colors_.capacity() * sizeof(visage::Color) +
+                       brushes_.capacity() * sizeof(VisageBrush_t) + texts_.size() * sizeof(visage::Text) +
+                       pixels_.capacity() * sizeof(Pixels);
+        for (const std::unique_ptr<visage::Line>& line : lines_)
+            bytes += sizeof(visage::Line) + 3 * sizeof(float) * static_cast<size_t>(std::max(line->num_points, 0));
+        return bytes;
+    }
+    // Hash of everything replaying the list draws, including the brushes, text and lines it copied.
+    uint64_t hash() const {
+        uint64_t hash = hash_bytes(reinterpret_cast<const char*>(commands_.data()), commands_.size() * sizeof(VisageShapeCommand));
+        for (const visage::Color& color : colors_)
+            hash = hash_combine(hash, color_hash(color));
+        for (const VisageBrush_t& brush : brushes_)
+            hash = hash_combine(hash, brush_source_hash(brush.source));
+        for (const std::unique_ptr<visage::Text>& text : texts_)
+            hash = hash_combine(hash, text_hash(*text));
+        for (const std::unique_ptr<visage::Line>& line : lines_)
+            hash = hash_combine(hash, line_hash(*line));
+        for (const Pixels& pixels : pixels_)
+            hash = hash_combine(hash, reinterpret_cast<uintptr_t>(pixels.data));
+        return hash;
+    }
+    // Area the list draws into, relative to the position it is replayed at.
+    const Bounds& bounds() const { return bounds_; }
+
+    std::vector<char> toStream(int32_t width, int32_t height, float dpi_scale) const;
+
+private:
+    std::vector<VisageShapeCommand> commands_;
+    std::vector<visage::Color> colors_;
+    std::vector<VisageBrush_t> brushes_;
+    std::vector<std::unique_ptr<visage::Text>> texts_;
+    std::vector<std::unique_ptr<visage::Line>> lines_;
+    std::vector<Pixels> pixels_;
+    Bounds bounds_;
+    PositionTracker position_;
+
+    void track(const VisageShapeCommand& command) {
+        Bounds command_area;
+        if (command_bounds(command, &command_area))
+            bounds_ = bounds_.united(command_area.translated(position_.x(), position_.y()));
+        else
+            position_.apply(command);
+    }
+};
+
+inline uint32_t font_source(const visage::Font& font) {
+    if (font.fontData() == visage::fonts::Lato_Regular_ttf.data)
+        return kStreamFontLatoRegular;
+    if (font.fontData() == visage::fonts::DroidSansMono_ttf.data)
+        return kStreamFontDroidSansMono;
+    if (font.fontData() == visage::fonts::Twemoji_Mozilla_ttf.data)
+        return kStreamFontTwemojiMozilla;
+    return kStreamFontData;
+}
+
+inline const visage::EmbeddedFile* embedded_font(uint32_t source) {
+    switch (source) {
+        case kStreamFontLatoRegular:
+            return &visage::fonts::Lato_Regular_ttf;
+        case kStreamFontDroidSansMono:
+            return &visage::fonts::DroidSansMono_ttf;
+        case kStreamFontTwemojiMozilla:
+            return &visage::fonts::Twemoji_Mozilla_ttf;
+        default:
+            return nullptr;
+    }
+}
+
+inline size_t align_stream_offset(size_t offset) {
+    return (offset + 7) & ~static_cast<size_t>(7);
+}
+
+inline uint64_t append_stream_data(std::vector<char>& data, const void* bytes, size_t size) {
+    size_t offset = align_stream_offset(data.size());
+    data.resize(offset + size);
+    if (size > 0)
+        std::memcpy(data.data() + offset, bytes, size);
+    return offset;
+}
+
+template <typename T>
+StreamSection append_stream_section(std::vector<char>& stream, const std::vector<T>& values) {
+    StreamSection section = { align_stream_offset(stream.size()), values.size() };
+    stream.resize(section.offset + values.size() * sizeof(T));
+    if (!values.empty())
+        std::memcpy(stream.data() + section.offset, values.data(), values.size() * sizeof(T));
+    return section;
+}
+
+std::vector<char> CommandList::toStream(int32_t width, int32_t height, float dpi_scale) const {
+    std::vector<VisageColor> colors;
+    std::vector<StreamBrush> brushes;
+    std::vector<StreamText> texts;
+    std::vector<StreamLine> lines;
+    std::vector<StreamFont> fonts;
+    std::vector<const visage::Font*> font_keys;
+    std::vector<char> data;
+
+    colors.reserve(colors_.size());
+    for (const visage::Color& color : colors_)
+        colors.push_back(color_from_cpp(color));
+
+    for (const VisageBrush_t& brush : brushes_) {
+        const BrushSource& source = brush.source;
+        std::vector<visage::Color> gradient_colors = source.gradient.colors();
+
+        brushes.push_back({ source.kind, static_cast<uint32_t>(colors.size()), static_cast<uint32_t>(gradient_colors.size()),
+                            source.from_x, source.from_y, source.to_x, source.to_y, 0 });
+        for (const visage::Color& color : gradient_colors)
+            colors.push_back(color_from_cpp(color));
+    }
+
+    for (const std::unique_ptr<visage::Text>& text : texts_) {
+        const visage::Font& font = text->font();
+        size_t font_index = 0;
+        while (font_index < font_keys.size() &&
+               (font_keys[font_index]->fontData() != font.fontData() || font_keys[font_index]->size() != font.size() ||
+                font_keys[font_index]->dpiScale() != font.dpiScale())) {
+            ++font_index;
+        }
+
+        if (font_index == font_keys.size()) {
+            StreamFont stream_font = { font_source(font), font.size(), font.dpiScale(), 0, 0, 0 };
+            if (stream_font.source == kStreamFontData) {
+                stream_font.data = append_stream_data(data, font.fontData(), font.dataSize());
+                stream_font.data_size = font.dataSize();
+            }
+            fonts.push_back(stream_font);
+            font_keys.push_back(&font);
+        }
+
+        const visage::String& string = text->text();
+        uint64_t characters = append_stream_data(data, string.c_str(), string.length() * sizeof(char32_t));
+        texts.push_back({ static_cast<uint32_t>(font_index), static_cast<uint32_t>(text->justification()),
+                          static_cast<int32_t>(text->characterOverride()), text->multiLine() ? 1u : 0u, characters,
+                          static_cast<uint64_t>(string.length()) });
+    }
+
+    for (const std::unique_ptr<visage::Line>& line : lines_) {
+        size_t size = line->num_points * sizeof(float);
+        StreamLine stream_line = {};
+        stream_line.num_points = static_cast<uint32_t>(line->num_points);
+        stream_line.line_value_scale = line->line_value_scale;
+        stream_line.fill_value_scale = line->fill_value_scale;
+        stream_line.x = append_stream_data(data, line->x.get(), size);
+        stream_line.y = append_stream_data(data, line->y.get(), size);
+        stream_line.values = append_stream_data(data, line->values.get(), size);
+        lines.push_back(stream_line);
+    }
+
+    StreamHeader header = {};
+    header.magic = kCommandStreamMagic;
+    header.version = kCommandStreamVersion;
+    header.header_size = sizeof(StreamHeader);
+    header.command_size = sizeof(VisageShapeCommand);
+    header.width = width;
+    header.height = height;
+    header.dpi_scale = dpi_scale;
+
+    std::vector<char> stream(sizeof(StreamHeader));
+    header.commands = append_stream_section(stream, commands_);
+    header.colors = append_stream_section(stream, colors);
+    header.brushes = append_stream_section(stream, brushes);
+    header.texts = append_stream_section(stream, texts);
+    header.lines = append_stream_section(stream, lines);
+    header.fonts = append_stream_section(stream, fonts);
+    header.data = append_stream_section(stream, data);
+    std::memcpy(stream.data(), &header, sizeof(StreamHeader));
+    return stream;
+}
+
+// Objects rebuilt from a command stream. The canvas keeps pointers to them until the frame is
+// submitted, so they live until the next clearDrawnShapes.
+struct StreamStorage {
+    std::vector<std::unique_ptr<visage::Text>> texts;
+    std::vector<std::unique_ptr<visage::Line>> lines;
+
+    void clear() {
+        texts.clear();
+        lines.clear();
+    }
+};
+
+template <typename T>
+const T* stream_section(const char* stream, size_t size, const StreamSection& section) {
+    if (section.offset % alignof(T) != 0 || section.offset > size || section.count > (size - section.offset) / sizeof(T))
+        return nullptr;
+    return reinterpret_cast<const T*>(stream + section.offset);
+}
+
+inline bool stream_data_in_range(const StreamSection& data, uint64_t offset, uint64_t count, size_t element_size) {
+    return offset % element_size == 0 && offset <= data.count && count <= (data.count - offset) / element_size;
+}
+
+inline const StreamHeader* stream_header(const void* stream, size_t size) {
+    if (stream == nullptr || size < sizeof(StreamHeader) || reinterpret_cast<uintptr_t>(stream) % alignof(StreamHeader) != 0)
+        return nullptr;
+
+    auto header = static_cast<const StreamHeader*>(stream);
+    if (header->magic != kCommandStreamMagic || header->version != kCommandStreamVersion ||
+        header->header_size != sizeof(StreamHeader) || header->command_size != sizeof(VisageShapeCommand)) {
+        return nullptr;
+    }
+    return header;
+}
+
+// Where replay_command_stream draws: straight onto a visage canvas, or into a list that copies what
+// it is handed and is replayed later.
+struct CanvasStreamTarget {
+    visage::Canvas* canvas;
+
+    void setColor(const visage::Color& color) { canvas->setColor(color); }
+    void setBrush(const VisageBrush_t& brush) { canvas->setBrush(brush.brush); }
+    void text(visage::Text* text, const float* v) {
+        canvas->text(text, v[0], v[1], v[2], v[3], direction_to_cpp(static_cast<int32_t>(v[4])));
+    }
+    void line(visage::Line* line, const float* v) { canvas->line(line, v[0], v[1], v[2], v[3], v[4]); }
+    void lineFill(visage::Line* line, const float* v) { canvas->lineFill(line, v[0], v[1], v[2], v[3], v[4]); }
+    void shape(const VisageShapeCommand& command) { draw_shape_command(canvas, command); }
+};
+
+struct ListStreamTarget {
+    CommandList* list;
+
+    void setColor(const visage::Color& color) { list->addColor(color); }
+    void setBrush(const VisageBrush_t& brush) { list->addBrush(brush); }
+    void text(visage::Text* text, const float* v) { list->addText(*text, v[0], v[1], v[2], v[3], static_cast<int32_t>(v[4])); }
+    void line(visage::Line* line, const float* v) { list->addLine(*line, v[0], v[1], v[2], v[3], v[4]); }
+    void lineFill(visage::Line* line, const float* v) { list->addLineFill(*line, v[0], v[1], v[2], v[3], v[4]); }
+    void shape(const VisageShapeCommand& command) { list->add(command); }
+};
+
+// Replays a command stream onto `target`. Everything the commands reference is validated and
+// rebuilt before anything is drawn, the commands themselves are read in place.
+template <typename Target>
+bool replay_command_stream(Target target, const void* stream, size_t size, StreamStorage* storage) {
+    const StreamHeader* header = stream_header(stream, size);
+    if (header == nullptr)
+        return false;
+
+    auto bytes = static_cast<const char*>(stream);
+    auto commands = stream_section<VisageShapeCommand>(bytes, size, header->commands);
+    auto colors = stream_section<VisageColor>(bytes, size, header->colors);
+    auto brushes = stream_section<StreamBrush>(bytes, size, header->brushes);
+    auto texts = stream_section<StreamText>(bytes, size, header->texts);
+    auto lines = stream_section<StreamLine>(bytes, size, header->lines);
+    auto fonts = stream_section<StreamFont>(bytes, size, header->fonts);
+    auto data = stream_section<char>(bytes, size, header->data);
+    if (!commands || !colors || !brushes || !texts || !lines || !fonts || !data)
+        return false;
+
+    std::vector<VisageBrush_t> stream_brushes;
+    stream_brushes.reserve(header->brushes.count);
+    for (uint64_t i = 0; i < header->brushes.count; ++i) {
+        const StreamBrush& brush = brushes[i];
+        if (brush.num_colors == 0 || brush.first_color > header->colors.count ||
+            brush.num_colors > header->colors.count - brush.first_color) {
+            return false;
+        }
+
+        BrushSource source = { brush.kind, {}, brush.from_x, brush.from_y, brush.to_x, brush.to_y };
+        source.gradient.setResolution(static_cast<int>(brush.num_colors));
+        for (uint32_t c = 0; c < brush.num_colors; ++c)
+            source.gradient.setColor(static_cast<int>(c), color_to_cpp(colors[brush.first_color + c]));
+        brush_source_rehash(&source);
+        stream_brushes.push_back({ brush_from_source(source), std::move(source) });
+    }
+
+    std::vector<visage::Font> stream_fonts;
+    stream_fonts.reserve(header->fonts.count);
+    for (uint64_t i = 0; i < header->fonts.count; ++i) {
+        const StreamFont& font = fonts[i];
+        if (const visage::EmbeddedFile* file = embedded_font(font.source)) {
+            stream_fonts.emplace_back(font.size, *file, font.dpi_scale);
+        } else {
+            if (font.source != kStreamFontData || !stream_data_in_range(header->data, font.data, font.data_size, 1))
+                return false;
+            stream_fonts.emplace_back(font.size, data + font.data, static_cast<int>(font.data_size), font.dpi_scale);
+        }
+    }
+
+    size_t first_text = storage->texts.size();
+    size_t first_line = storage->lines.size();
+
+    for (uint64_t i = 0; i < header->texts.count; ++i) {
+        const StreamText& text = texts[i];
+        if (text.font >= header->fonts.count || !stream_data_in_range(header->data, text.characters, text.length, sizeof(char32_t)))
+            return false;
+
+        auto characters = reinterpret_cast<const char32_t*>(data + text.characters);
+        auto text_cpp = std::make_unique<visage::Text>();
+        text_cpp->setFont(stream_fonts[text.font]);
+        text_cpp->setText(std::u32string(characters, text.length));
+        text_cpp->setJustification(static_cast<visage::Font::Justification>(text.justification));
+        text_cpp->setMultiLine(text.multi_line != 0);
+        text_cpp->setCharacterOverride(static_cast<int>(text.character_override));
+        storage->texts.push_back(std::move(text_cpp));
+    }
+
+    for (uint64_t i = 0; i < header->lines.count; ++i) {
+        const StreamLine& line = lines[i];
+        if (!stream_data_in_range(header->data, line.x, line.num_points, sizeof(float)) ||
+            !stream_data_in_range(header->data, line.y, line.num_points, sizeof(float)) ||
+            !stream_data_in_range(header->data, line.values, line.num_points, sizeof(float))) {
+            return false;
+        }
+
+        size_t line_size = line.num_points * sizeof(float);
+        auto line_cpp = std::make_unique<visage::Line>(static_cast<int>(line.num_points));
+        line_cpp->line_value_scale = line.line_value_scale;
+        line_cpp->fill_value_scale = line.fill_value_scale;
+        if (line_size > 0) {
+            std::memcpy(line_cpp->x.get(), data + line.x, line_size);
+            std::memcpy(line_cpp->y.get(), data + line.y, line_size);
+            std::memcpy(line_cpp->values.get(), data + line.values, line_size);
+        }
+        storage->lines.push_back(std::move(line_cpp));
+    }
+
+    for (uint64_t i = 0; i < header->commands.count; ++i) {
+        const VisageShapeCommand& command = commands[i];
+        const float* v = command.values;
+
+        switch (command.type) {
+            case kRecordedColor:
+                if (command.flags < header->colors.count)
+                    target.setColor(color_to_cpp(colors[command.flags]));
+                break;
+            case kRecordedBrush:
+                if (command.flags < stream_brushes.size())
+                    target.setBrush(stream_brushes[command.flags]);
+                break;
+            case kRecordedText:
+                if (command.flags < header->texts.count)
+                    target.text(storage->texts[first_text + command.flags].get(), v);
+                break;
+            case kRecordedLine:
+                if (command.flags < header->lines.count)
+                    target.line(storage->lines[first_line + command.flags].get(), v);
+                break;
+            case kRecordedLineFill:
+                if (command.flags < header->lines.count)
+                    target.lineFill(storage->lines[first_line + command.flags].get(), v);
+                break;
+            case kRecordedPixels:
+                break;
+            default:
+                target.shape(command);
+                break;
+        }
+    }
+
+    return true;
+}
+
+// Four floats handled side by side, one per pixel of a row span. Comparisons return lane masks that
+// are only meant to be passed to `choose`.
+struct Float4 {
+#if VISAGE_C_SSE2
+    __m128 v;
+
+    Float4() = default;
+    Float4(float value) : v(_mm_set1_ps(value)) { }
+    explicit Float4(__m128 value) : v(value) { }
+
+    static Float4 load(const float* values) { return Float4(_mm_loadu_ps(values)); }
+    void store(float* values) const { _mm_storeu_ps(values, v); }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return Float4(_mm_add_ps(a.v, b.v)); }
+    friend Float4 operator-(Float4 a, Float4 b) { return Float4(_mm_sub_ps(a.v, b.v)); }
+    friend Float4 operator*(Float4 a, Float4 b) { return Float4(_mm_mul_ps(a.v, b.v)); }
+    friend Float4 operator/(Float4 a, Float4 b) { return Float4(_mm_div_ps(a.v, b.v)); }
+    friend Float4 operator<(Float4 a, Float4 b) { return Float4(_mm_cmplt_ps(a.v, b.v)); }
+    friend Float4 min(Float4 a, Float4 b) { return Float4(_mm_min_ps(a.v, b.v)); }
+    friend Float4 max(Float4 a, Float4 b) { return Float4(_mm_max_ps(a.v, b.v)); }
+    friend Float4 sqrt(Float4 a) { return Float4(_mm_sqrt_ps(a.v)); }
+    friend Float4 abs(Float4 a) { return Float4(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+    friend Float4 choose(Float4 mask, Float4 a, Float4 b) {
+        return Float4(_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)));
+    }
+    friend Float4 floor(Float4 a) {
+        Float4 truncated(_mm_cvtepi32_ps(_mm_cvttps_epi32(a.v)));
+        return truncated - choose(a < truncated, 1.0f, 0.0f);
+    }
+    // Unbiased exponent and the mantissa in [1, 2) of positive floats.
+    friend Float4 exponent(Float4 a) {
+        __m128i biased = _mm_srli_epi32(_mm_castps_si128(a.v), 23);
+        return Float4(_mm_cvtepi32_ps(_mm_sub_epi32(biased, _mm_set1_epi32(127))));
+    }
+    friend Float4 mantissa(Float4 a) {
+        __m128 bits = _mm_and_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(0x007fffff)));
+        return Float4(_mm_or_ps(bits, _mm_set1_ps(1.0f)));
+    }
+    // 2 to the power of whole numbers in the normal exponent range.
+    friend Float4 pow2i(Float4 a) {
+        __m128i biased = _mm_add_epi32(_mm_cvtps_epi32(a.v), _mm_set1_epi32(127));
+        return Float4(_mm_castsi128_ps(_mm_slli_epi32(biased, 23)));
+    }
+#elif VISAGE_C_NEON
+    float32x4_t v;
+
+    Float4() = default;
+    Float4(float value) : v(vdupq_n_f32(value)) { }
+    explicit Float4(float32x4_t value) : v(value) { }
+
+    static Float4 load(const float* values) { return Float4(vld1q_f32(values)); }
+    void store(float* values) const { vst1q_f32(values, v); }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return Float4(vaddq_f32(a.v, b.v)); }
+    friend Float4 operator-(Float4 a, Float4 b) { return Float4(vsubq_f32(a.v, b.v)); }
+    friend Float4 operator*(Float4 a, Float4 b) { return Float4(vmulq_f32(a.v, b.v)); }
+    friend Float4 operator/(Float4 a, Float4 b) { return Float4(vdivq_f32(a.v, b.v)); }
+    friend Float4 operator<(Float4 a, Float4 b) { return Float4(vreinterpretq_f32_u32(vcltq_f32(a.v, b.v))); }
+    friend Float4 min(Float4 a, Float4 b) { return Float4(vminq_f32(a.v, b.v)); }
+    friend Float4 max(Float4 a, Float4 b) { return Float4(vmaxq_f32(a.v, b.v)); }
+    friend Float4 sqrt(Float4 a) { return Float4(vsqrtq_f32(a.v)); }
+    friend Float4 abs(Float4 a) { return Float4(vabsq_f32(a.v)); }
+    friend Float4 choose(Float4 mask, Float4 a, Float4 b) {
+        return Float4(vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v));
+    }
+    friend Float4 floor(Float4 a) { return Float4(vrndmq_f32(a.v)); }
+    // Unbiased exponent and the mantissa in [1, 2) of positive floats.
+    friend Float4 exponent(Float4 a) {
+        int32x4_t biased = vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_f32(a.v), 23));
+        return Float4(vcvtq_f32_s32(vsubq_s32(biased, vdupq_n_s32(127))));
+    }
+    friend Float4 mantissa(Float4 a) {
+        uint32x4_t bits = vandq_u32(vreinterpretq_u32_f32(a.v), vdupq_n_u32(0x007fffff));
+        return Float4(vreinterpretq_f32_u32(vorrq_u32(bits, vdupq_n_u32(0x3f800000))));
+    }
+    // 2 to the power of whole numbers in the normal exponent range.
+    friend Float4 pow2i(Float4 a) {
+        int32x4_t biased = vaddq_s32(vcvtnq_s32_f32(a.v), vdupq_n_s32(127));
+        return Float4(vreinterpretq_f32_s32(vshlq_n_s32(biased, 23)));
+    }
+#else
+    float v[4];
+
+    Float4() = default;
+    Float4(float value) : v { value, value, value, value } { }
+
+    static Float4 load(const float* values) {
+        Float4 result;
+        std::memcpy(result.v, values, sizeof(result.v));
+        return result;
+    }
+    void store(float* values) const { std::memcpy(values, v, sizeof(v)); }
+
+    template <typename Function>
+    static Float4 lanes(Function&& function) {
+        Float4 result;
+        for (int i = 0; i < 4; ++i)
+            result.v[i] = function(i);
+        return result;
+    }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return lanes([&](int i) { return a.v[i] + b.v[i]; }); }
+    friend Float4 operator-(Float4 a, Float4 b) { return lanes([&](int i) { return a.v[i] - b.v[i]; }); }
+    friend Float4 operator*(Float4 a, Float4 b) { return lanes([&](int i) { return a.v[i] * b.v[i]; }); }
+    friend Float4 operator/(Float4 a, Float4 b) { return lanes([&](int i) { return a.v[i] / b.v[i]; }); }
+    friend Float4 operator<(Float4 a, Float4 b) { return lanes([&](int i) { return a.v[i] < b.v[i] ? 1.0f : 0.0f; }); }
+    friend Float4 min(Float4 a, Float4 b) { return lanes([&](int i) { return std::min(a.v[i], b.v[i]); }); }
+    friend Float4 max(Float4 a, Float4 b) { return lanes([&](int i) { return std::max(a.v[i], b.v[i]); }); }
+    friend Float4 sqrt(Float4 a) { return lanes([&](int i) { return std::sqrt(a.v[i]); }); }
+    friend Float4 abs(Float4 a) { return lanes([&](int i) { return std::abs(a.v[i]); }); }
+    friend Float4 choose(Float4 mask, Float4 a, Float4 b) {
+        return lanes([&](int i) { return mask.v[i] != 0.0f ? a.v[i] : b.v[i]; });
+    }
+    friend Float4 floor(Float4 a) { return lanes([&](int i) { return std::floor(a.v[i]); }); }
+    // Unbiased exponent and the mantissa in [1, 2) of positive floats.
+    friend Float4 exponent(Float4 a) {
+        return lanes([&](int i) { return static_cast<float>(static_cast<int>(bits(a.v[i]) >> 23) - 127); });
+    }
+    friend Float4 mantissa(Float4 a) {
+        return lanes([&](int i) { return fromBits((bits(a.v[i]) & 0x007fffff) | 0x3f800000); });
+    }
+    // 2 to the power of whole numbers in the normal exponent range.
+    friend Float4 pow2i(Float4 a) {
+        return lanes([&](int i) { return fromBits(static_cast<uint32_t>(static_cast<int>(a.v[i]) + 127) << 23); });
+    }
+
+    static uint32_t bits(float value) {
+        uint32_t result;
+        std::memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+    static float fromBits(uint32_t value) {
+        float result;
+        std::memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+#endif
+};
+
+inline Float4 clamp_unit(Float4 value) {
+    return min(max(value, 0.0f), 1.0f);
+}
+inline Float4 length(Float4 x, Float4 y) {
+    return sqrt(x * x + y * y);
+}
+
+// Base 2 logarithm of positive values, to about 1e-5. The mantissa's logarithm is summed from the
+// atanh series, which converges quickly over [1, 2).
+inline Float4 log2(Float4 value) {
+    Float4 m = mantissa(value);
+    Float4 t = (m - 1.0f) / (m + 1.0f);
+    Float4 t2 = t * t;
+    Float4 series = t * (Float4(1.0f) + t2 * (Float4(1.0f / 3.0f) + t2 * (Float4(1.0f / 5.0f) + t2 * (1.0f / 7.0f))));
+    return exponent(value) + series * 2.88539008f;
+}
+// 2 to the power of `value`, to about 1e-5 relative. Values are clamped to the normal float range,
+// so tiny results come out as the smallest normal float instead of zero.
+inline Float4 exp2(Float4 value) {
+    value = min(max(value, -126.0f), 126.0f);
+    Float4 whole = floor(value);
+    Float4 x = (value - whole) * 0.693147181f;
+    Float4 fraction = Float4(1.0f) + x * (Float4(1.0f) + x * (Float4(1.0f / 2.0f) + x * (Float4(1.0f / 6.0f) +
+                      x * (Float4(1.0f / 24.0f) + x * (Float4(1.0f / 120.0f) + x * (1.0f / 720.0f))))));
+    return pow2i(whole) * fraction;
+}
+// `base` to the power of `power` for non-negative bases.
+inline Float4 pow(Float4 base, float power) {
+    return exp2(log2(base) * power);
+}
+
+// CPU rasterizer for recorded commands. Commands are resolved into shapes in target pixels, with the
+// position, clamp bounds and paint in effect applied, and binned into the tiles they overlap. Tiles
+// are then shaded in parallel, each blending its shapes in order into premultiplied float planes, so
+// the result doesn't depend on how the tiles are spread over threads. Coverage comes from signed
+// distances, evaluated for four pixels at a time.
+class SoftwareRaster {
+public:
+    static constexpr int kTileSize = 64;
+    static constexpr int kGradientResolution = 256;
+    static constexpr int kQuadraticSegments = 16;
+
+    SoftwareRaster(int width, int height) :
+        width_(std::max(width, 0)), height_(std::max(height, 0)), stride_((width_ + 3) & ~3) {
+        tiles_x_ = (width_ + kTileSize - 1) / kTileSize;
+        tiles_y_ = (height_ + kTileSize - 1) / kTileSize;
+        tile_shapes_.resize(static_cast<size_t>(tiles_x_) * tiles_y_);
+        for (std::vector<float>& plane : planes_)
+            plane.assign(static_cast<size_t>(stride_) * height_, 0.0f);
+        stats_.tiles = static_cast<int32_t>(tile_shapes_.size());
+    }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    void setScale(float scale) { scale_ = scale; }
+
+    void clear(uint32_t argb) {
+        float alpha = (argb >> 24) / 255.0f;
+        float values[] = { ((argb >> 16) & 0xff) / 255.0f * alpha, ((argb >> 8) & 0xff) / 255.0f * alpha,
+                           (argb & 0xff) / 255.0f * alpha, alpha };
+        for (int i = 0; i < 4; ++i)
+            std::fill(planes_[i].begin(), planes_[i].end(), values[i]);
+        pixels_current_ = false;
+    }
+
+    // Draws `list` with its origin at `x`, `y`, before scaling.
+    void draw(const CommandList& list, float x, float y) {
+        auto start = std::chrono::steady_clock::now();
+
+        shapes_.clear();
+        points_.clear();
+        paints_.clear();
+        brush_paints_.clear();
+        saved_.clear();
+        skipped_ = 0;
+        state_ = { x * scale_, y * scale_, { 0.0f, 0.0f, static_cast<float>(width_), static_cast<float>(height_) }, 0 };
+        setColor(visage::Color());
+
+        list.visit(*this);
+        shadeTiles();
+        pixels_current_ = false;
+
+        stats_.shapes = static_cast<int32_t>(shapes_.size());
+        stats_.skipped = skipped_;
+        stats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const uint32_t* pixels() {
+        if (!pixels_current_) {
+            pixels_.resize(static_cast<size_t>(width_) * height_);
+            parallel_for(static_cast<size_t>(tiles_y_), [&](size_t band) {
+                int end = std::min(height_, static_cast<int>(band + 1) * kTileSize);
+                for (int y = static_cast<int>(band) * kTileSize; y < end; ++y)
+                    packRow(y);
+            });
+            pixels_current_ = true;
+        }
+        return pixels_.data();
+    }
+
+    const VisageSoftwareRasterStats& stats() const { return stats_; }
+
+    // Called through CommandList::visit.
+    void setColor(const visage::Color& color) {
+        Paint paint;
+        float alpha = color.alpha();
+        paint.color[0] = color.red() * alpha;
+        paint.color[1] = color.green() * alpha;
+        paint.color[2] = color.blue() * alpha;
+        paint.color[3] = alpha;
+        state_.paint = static_cast<uint32_t>(paints_.size());
+        paints_.push_back(std::move(paint));
+    }
+
+    void setBrush(const BrushSource& source) {
+        auto cached = brush_paints_.find(&source);
+        if (cached != brush_paints_.end()) {
+            state_.paint = cached->second;
+            return;
+        }
+
+        if (source.kind == kBrushSolid) {
+            setColor(source.gradient.sample(0.0f));
+        } else {
+            Paint paint;
+            paint.kind = source.kind;
+            paint.from_x = source.from_x;
+            paint.from_y = source.from_y;
+            paint.to_x = source.to_x;
+            paint.to_y = source.to_y;
+            paint.gradient.resize(4 * kGradientResolution);
+            for (int i = 0; i < kGradientResolution; ++i) {
+                visage::Color color = source.gradient.sample(i / (kGradientResolution - 1.0f));
+                float alpha = color.alpha();
+                paint.gradient[4 * i] = color.red() * alpha;
+                paint.gradient[4 * i + 1] = color.green() * alpha;
+                paint.gradient[4 * i + 2] = color.blue() * alpha;
+                paint.gradient[4 * i + 3] = alpha;
+            }
+            state_.paint = static_cast<uint32_t>(paints_.size());
+            paints_.push_back(std::move(paint));
+        }
+        brush_paints_[&source] = state_.paint;
+    }
+
+    void line(const visage::Line& line, const VisageShapeCommand& command) {
+        const float* v = command.values;
+        if (line.num_points < 2)
+            return;
+
+        Shape shape;
+        shape.first_point = static_cast<uint32_t>(points_.size() / 2);
+        shape.num_points = static_cast<uint32_t>(line.num_points);
+        for (int i = 0; i < line.num_points; ++i) {
+            points_.push_back(state_.x + (v[0] + line.x[i]) * scale_);
+            points_.push_back(state_.y + (v[1] + line.y[i]) * scale_);
+        }
+
+        if (command.type == kRecordedLine) {
+            shape.kind = kShapePolyline;
+            shape.v[0] = 0.5f * v[4] * scale_;
+        } else {
+            shape.kind = kShapeLineFill;
+            shape.v[0] = state_.y + (v[1] + v[4]) * scale_;
+        }
+        addShape(shape, command);
+    }
+
+    // visage packs glyphs into atlases private to its fonts, with no way to read their pixels back,
+    // so text is left to the GPU. Layers draw theirs through visage over the rasterized pixels.
+    void text(const visage::Text&, const VisageShapeCommand&) { skipped_++; }
+    void image(const CommandList::Pixels&, const VisageShapeCommand&) { skipped_++; }
+
+    void shape(const VisageShapeCommand& command) {
+        const float* v = command.values;
+        float s = scale_;
+        auto px = [&](float value) { return state_.x + value * s; };
+        auto py = [&](float value) { return state_.y + value * s; };
+        auto box = [&](Shape& shape, float rounding, uint32_t corners) {
+            shape.kind = kShapeBox;
+            shape.v[0] = px(v[0] + 0.5f * v[2]);
+            shape.v[1] = py(v[1] + 0.5f * v[3]);
+            shape.v[2] = 0.5f * v[2] * s;
+            shape.v[3] = 0.5f * v[3] * s;
+            float radius = std::min(rounding * s, std::min(shape.v[2], shape.v[3]));
+            for (int corner = 0; corner < 4; ++corner)
+                shape.v[4 + corner] = (corners & (1u << corner)) ? radius : 0.0f;
+        };
+        auto circle = [&](Shape& shape) {
+            shape.kind = kShapeEllipse;
+            shape.v[0] = px(v[0] + 0.5f * v[2]);
+            shape.v[1] = py(v[1] + 0.5f * v[2]);
+            shape.v[2] = 0.5f * v[2] * s;
+            shape.v[3] = shape.v[2];
+            shape.v[4] = 2.0f;
+        };
+        auto triangle = [&](Shape& shape, const float* points) {
+            shape.kind = kShapeTriangle;
+            for (int i = 0; i < 3; ++i) {
+                shape.v[2 * i] = px(points[2 * i]);
+                shape.v[2 * i + 1] = py(points[2 * i + 1]);
+            }
+        };
+        // `center_radians` is measured clockwise from straight up, and the arc covers `radians` on
+        // either side of it.
+        auto arc = [&](Shape& shape) {
+            shape.kind = (command.flags & VISAGE_SHAPE_COMMAND_ROUNDED) ? kShapeRoundedArc : kShapeArc;
+            float half_thickness = 0.5f * std::min(v[3], v[2] * 0.5f) * s;
+            float radians = std::min(std::abs(v[5]), 3.14159265f);
+            shape.v[0] = px(v[0] + 0.5f * v[2]);
+            shape.v[1] = py(v[1] + 0.5f * v[2]);
+            shape.v[2] = 0.5f * v[2] * s - half_thickness;
+            shape.v[3] = half_thickness;
+            shape.v[4] = std::cos(v[4]);
+            shape.v[5] = std::sin(v[4]);
+            shape.v[6] = std::sin(radians);
+            shape.v[7] = std::cos(radians);
+        };
+
+        Shape shape;
+        constexpr uint32_t kAllCorners = 0xf;
+        constexpr uint32_t kTopLeft = 0x1, kTopRight = 0x2, kBottomRight = 0x4, kBottomLeft = 0x8;
+
+        switch (command.type) {
+            case VisageShapeCommandFill:
+            case VisageShapeCommandRectangle:
+                box(shape, 0.0f, 0);
+                break;
+            case VisageShapeCommandRectangleBorder:
+                box(shape, 0.0f, 0);
+                shape.border = v[4] * s;
+                break;
+            case VisageShapeCommandRoundedRectangle:
+                box(shape, v[4], kAllCorners);
+                break;
+            case VisageShapeCommandLeftRoundedRectangle:
+                box(shape, v[4], kTopLeft | kBottomLeft);
+                break;
+            case VisageShapeCommandRightRoundedRectangle:
+                box(shape, v[4], kTopRight | kBottomRight);
+                break;
+            case VisageShapeCommandTopRoundedRectangle:
+                box(shape, v[4], kTopLeft | kTopRight);
+                break;
+            case VisageShapeCommandBottomRoundedRectangle:
+                box(shape, v[4], kBottomLeft | kBottomRight);
+                break;
+            case VisageShapeCommandRectangleShadow:
+                box(shape, 0.0f, 0);
+                setShadow(shape, v[4] * s);
+                break;
+            case VisageShapeCommandRoundedRectangleShadow:
+                box(shape, v[4], kAllCorners);
+                setShadow(shape, v[5] * s);
+                break;
+            case VisageShapeCommandRoundedRectangleBorder:
+                box(shape, v[4], kAllCorners);
+                shape.border = v[5] * s;
+                break;
+            case VisageShapeCommandCircle:
+                circle(shape);
+                break;
+            case VisageShapeCommandFadeCircle:
+                circle(shape);
+                shape.softness = std::max(1.0f, v[3] * s);
+                break;
+            case VisageShapeCommandRing:
+                circle(shape);
+                shape.border = v[3] * s;
+                break;
+            case VisageShapeCommandSquircle:
+                circle(shape);
+                shape.v[4] = v[3];
+                break;
+            case VisageShapeCommandArc:
+                arc(shape);
+                break;
+            case VisageShapeCommandArcShadow:
+                arc(shape);
+                setShadow(shape, v[6] * s);
+                break;
+            case VisageShapeCommandSuperEllipse:
+                shape.kind = kShapeEllipse;
+                shape.v[0] = px(v[0] + 0.5f * v[2]);
+                shape.v[1] = py(v[1] + 0.5f * v[3]);
+                shape.v[2] = 0.5f * v[2] * s;
+                shape.v[3] = 0.5f * v[3] * s;
+                shape.v[4] = v[4];
+                break;
+            case VisageShapeCommandSegment:
+                if (command.flags & VISAGE_SHAPE_COMMAND_ROUNDED) {
+                    shape.kind = kShapePolyline;
+                    shape.v[0] = 0.5f * v[4] * s;
+                    shape.first_point = static_cast<uint32_t>(points_.size() / 2);
+                    shape.num_points = 2;
+                    points_.insert(points_.end(), { px(v[0]), py(v[1]), px(v[2]), py(v[3]) });
+                } else {
+                    shape.kind = kShapeSegment;
+                    shape.v[0] = px(v[0]);
+                    shape.v[1] = py(v[1]);
+                    shape.v[2] = px(v[2]);
+                    shape.v[3] = py(v[3]);
+                    shape.v[4] = 0.5f * v[4] * s;
+                }
+                break;
+            case VisageShapeCommandQuadratic:
+                // Flattened, `b` being the control point.
+                shape.kind = kShapePolyline;
+                shape.v[0] = 0.5f * v[6] * s;
+                shape.first_point = static_cast<uint32_t>(points_.size() / 2);
+                shape.num_points = kQuadraticSegments + 1;
+                for (int i = 0; i <= kQuadraticSegments; ++i) {
+                    float t = static_cast<float>(i) / kQuadraticSegments;
+                    float a = (1.0f - t) * (1.0f - t);
+                    float b = 2.0f * (1.0f - t) * t;
+                    float c = t * t;
+                    points_.push_back(px(a * v[0] + b * v[2] + c * v[4]));
+                    points_.push_back(py(a * v[1] + b * v[3] + c * v[5]));
+                }
+                break;
+            case VisageShapeCommandDiamond:
+                shape.kind = kShapeDiamond;
+                shape.v[0] = px(v[0] + 0.5f * v[2]);
+                shape.v[1] = py(v[1] + 0.5f * v[2]);
+                shape.v[2] = 0.5f * v[2] * s;
+                shape.v[3] = std::min(v[3] * s, shape.v[2]);
+                break;
+            case VisageShapeCommandTriangle:
+                triangle(shape, v);
+                break;
+            case VisageShapeCommandTriangleBorder:
+                triangle(shape, v);
+                shape.border = v[6] * s;
+                break;
+            case VisageShapeCommandRoundedTriangle:
+                triangle(shape, v);
+                shape.offset = v[6] * s;
+                break;
+            case VisageShapeCommandRoundedTriangleBorder:
+                triangle(shape, v);
+                shape.offset = v[6] * s;
+                shape.border = v[7] * s;
+                break;
+            case VisageShapeCommandDirectionalTriangle: {
+                // Laid out like visage's: the tip is `width` from the middle of a base twice as long.
+                float x = v[0];
+                float y = v[1];
+                float w = v[2];
+                float left[] = { x + w, y, x + w, y + 2.0f * w, x, y + w };
+                float right[] = { x, y, x, y + 2.0f * w, x + w, y + w };
+                float up[] = { x, y + w, x + 2.0f * w, y + w, x + w, y };
+                float down[] = { x, y, x + 2.0f * w, y, x + w, y + w };
+                switch (command.flags) {
+                    case Right:
+                        triangle(shape, right);
+                        break;
+                    case Up:
+                        triangle(shape, up);
+                        break;
+                    case Down:
+                        triangle(shape, down);
+                        break;
+                    default:
+                        triangle(shape, left);
+                        break;
+                }
+                break;
+            }
+            case VisageShapeCommandSetPosition:
+                state_.x += v[0] * s;
+                state_.y += v[1] * s;
+                return;
+            case VisageShapeCommandSaveState:
+                saved_.push_back(state_);
+                return;
+            case VisageShapeCommandRestoreState:
+                if (!saved_.empty()) {
+                    state_ = saved_.back();
+                    saved_.pop_back();
+                }
+                return;
+            case VisageShapeCommandSetClampBounds:
+                state_.clamp = { px(v[0]), py(v[1]), v[2] * s, v[3] * s };
+                return;
+            case VisageShapeCommandTrimClampBounds: {
+                Bounds trim = { px(v[0]), py(v[1]), v[2] * s, v[3] * s };
+                float left = std::max(state_.clamp.x, trim.x);
+                float top = std::max(state_.clamp.y, trim.y);
+                state_.clamp = { left, top, std::max(0.0f, std::min(state_.clamp.right(), trim.right()) - left),
+                                 std::max(0.0f, std::min(state_.clamp.bottom(), trim.bottom()) - top) };
+                return;
+            }
+            default:
+                return;
+        }
+
+        addShape(shape, command);
+    }
+
+private:
+    enum ShapeKind : uint32_t {
+        kShapeBox,       // center x, y, half width, half height, radius per corner clockwise from top left
+        kShapeEllipse,   // center x, y, half width, half height, power
+        kShapeSegment,   // a x, y, b x, y, half thickness
+        kShapeDiamond,   // center x, y, half width, rounding
+        kShapeTriangle,  // a x, y, b x, y, c x, y
+        kShapePolyline,  // half thickness
+        kShapeLineFill,  // fill y
+        // center x, y, center radius, half thickness, cos and sin of the middle angle, sin and cos
+        // of the angle covered on each side
+        kShapeArc,
+        kShapeRoundedArc,
+    };
+
+    struct Shape {
+        uint32_t kind = kShapeBox;
+        float v[8] = {};
+        // Outlines are grown by `offset`. With a `border`, only a band that thick inside is drawn.
+        float offset = 0.0f;
+        float border = -1.0f;
+        // Width of the edge the coverage ramps over, smoothed for shadows.
+        float softness = 1.0f;
+        bool smooth = false;
+        uint32_t paint = 0;
+        // Gradient brushes sample at (pixel - origin) . direction.
+        float gradient[4] = {};
+        uint32_t first_point = 0;
+        uint32_t num_points = 0;
+        int rect[4] = {};
+    };
+
+    struct Paint {
+        float color[4] = {};
+        // Premultiplied colors sampled from gradient brushes, empty for solid ones.
+        std::vector<float> gradient;
+        uint32_t kind = kBrushSolid;
+        float from_x = 0.0f;
+        float from_y = 0.0f;
+        float to_x = 0.0f;
+        float to_y = 0.0f;
+    };
+
+    struct State {
+        float x = 0.0f;
+        float y = 0.0f;
+        Bounds clamp;
+        uint32_t paint = 0;
+    };
+
+    static void setShadow(Shape& shape, float blur_radius) {
+        if (blur_radius > 0.0f) {
+            shape.softness = 2.0f * blur_radius;
+            shape.smooth = true;
+        }
+    }
+
+    void addShape(Shape& shape, const VisageShapeCommand& command) {
+        Bounds bounds;
+        if (!command_bounds(command, &bounds))
+            return;
+
+        bounds = { state_.x + bounds.x * scale_, state_.y + bounds.y * scale_, bounds.width * scale_, bounds.height * scale_ };
+        shape.paint = state_.paint;
+        const Paint& paint = paints_[shape.paint];
+        if (paint.kind == kBrushHorizontal && bounds.width > 0.0f) {
+            shape.gradient[0] = bounds.x;
+            shape.gradient[2] = 1.0f / bounds.width;
+        } else if (paint.kind == kBrushVertical && bounds.height > 0.0f) {
+            shape.gradient[1] = bounds.y;
+            shape.gradient[3] = 1.0f / bounds.height;
+        } else if (paint.kind == kBrushLinear) {
+            float dx = (paint.to_x - paint.from_x) * scale_;
+            float dy = (paint.to_y - paint.from_y) * scale_;
+            float length_squared = dx * dx + dy * dy;
+            if (length_squared > 0.0f) {
+                shape.gradient[0] = state_.x + paint.from_x * scale_;
+                shape.gradient[1] = state_.y + paint.from_y * scale_;
+                shape.gradient[2] = dx / length_squared;
+                shape.gradient[3] = dy / length_squared;
+            }
+        }
+
+        // Pixels are covered when their centers are inside the clamp bounds.
+        Bounds area = bounds.expanded(1.0f + 0.5f * shape.softness);
+        const Bounds& clamp = state_.clamp;
+        shape.rect[0] = std::max({ 0, static_cast<int>(std::floor(area.x)), static_cast<int>(std::ceil(clamp.x - 0.5f)) });
+        shape.rect[1] = std::max({ 0, static_cast<int>(std::floor(area.y)), static_cast<int>(std::ceil(clamp.y - 0.5f)) });
+        shape.rect[2] = std::min({ width_, static_cast<int>(std::ceil(area.right())), static_cast<int>(std::ceil(clamp.right() - 0.5f)) });
+        shape.rect[3] = std::min({ height_, static_cast<int>(std::ceil(area.bottom())), static_cast<int>(std::ceil(clamp.bottom() - 0.5f)) });
+        if (shape.rect[0] < shape.rect[2] && shape.rect[1] < shape.rect[3])
+            shapes_.push_back(shape);
+    }
+
+    void shadeTiles() {
+        for (std::vector<uint32_t>& shapes : tile_shapes_)
+            shapes.clear();
+
+        for (size_t i = 0; i < shapes_.size(); ++i) {
+            const int* rect = shapes_[i].rect;
+            for (int tile_y = rect[1] / kTileSize; tile_y <= (rect[3] - 1) / kTileSize; ++tile_y) {
+                for (int tile_x = rect[0] / kTileSize; tile_x <= (rect[2] - 1) / kTileSize; ++tile_x)
+                    tile_shapes_[tile_y * tiles_x_ + tile_x].push_back(static_cast<uint32_t>(i));
+            }
+        }
+        stats_.tile_shapes = 0;
+        for (const std::vector<uint32_t>& shapes : tile_shapes_)
+            stats_.tile_shapes += static_cast<int64_t>(shapes.size());
+
+        parallel_for(tile_shapes_.size(), [&](size_t tile) {
+            int tile_x = static_cast<int>(tile % tiles_x_) * kTileSize;
+            int tile_y = static_cast<int>(tile / tiles_x_) * kTileSize;
+            for (uint32_t index : tile_shapes_[tile]) {
+                const Shape& shape = shapes_[index];
+                int rect[4] = { std::max(shape.rect[0], tile_x), std::max(shape.rect[1], tile_y),
+                                std::min(shape.rect[2], tile_x + kTileSize), std::min(shape.rect[3], tile_y + kTileSize) };
+                shadeShape(shape, rect);
+            }
+        });
+    }
+
+    void shadeShape(const Shape& shape, const int* rect) {
+        const float* v = shape.v;
+
+        switch (shape.kind) {
+            case kShapeBox:
+                shadeSpans(shape, rect, [&](Float4 x, Float4 y, int) {
+                    Float4 dx = x - v[0];
+                    Float4 dy = y - v[1];
+                    Float4 top = dy < 0.0f;
+                    Float4 radius = choose(dx < 0.0f, choose(top, v[4], v[7]), choose(top, v[5], v[6]));
+                    Float4 qx = abs(dx) - v[2] + radius;
+                    Float4 qy = abs(dy) - v[3] + radius;
+                    return length(max(qx, 0.0f), max(qy, 0.0f)) + min(max(qx, qy), 0.0f) - radius;
+                });
+                break;
+            case kShapeEllipse:
+                if (v[4] == 2.0f && v[2] == v[3]) {
+                    shadeSpans(shape, rect, [&](Float4 x, Float4 y, int) { return length(x - v[0], y - v[1]) - v[2]; });
+                    break;
+                }
+                shadeSpans(shape, rect, [&](Float4 x, Float4 y, int) {
+                    Float4 nx = abs(x - v[0]) * (1.0f / std::max(v[2], 1e-6f));
+                    Float4 ny = abs(y - v[1]) * (1.0f / std::max(v[3], 1e-6f));
+                    Float4 radius = pow(pow(nx, v[4]) + pow(ny, v[4]), 1.0f / v[4]);
+                    return (radius - 1.0f) * std::min(v[2], v[3]);
+                });
+                break;
+            case kShapeArc:
+            case kShapeRoundedArc:
+                // Ported from visage's arc shaders. Pixels are turned into the arc's frame, the
+                // middle of the arc pointing along +y and mirrored onto +x, and measured against
+                // the band around the center radius: up to the end caps' centers for rounded arcs,
+                // cut along the ray through the arc's end for flat ones.
+                shadeSpans(shape, rect, [&](Float4 x, Float4 y, int) {
+                    Float4 dx = x - v[0];
+                    Float4 dy = y - v[1];
+                    Float4 qx = abs(dx * v[4] + dy * v[5]);
+                    Float4 qy = dx * v[5] - dy * v[4];
+                    Float4 radius = length(qx, qy);
+                    Float4 band = abs(radius - v[2]) - v[3];
+                    if (shape.kind == kShapeArc)
+                        return max(band, qx * v[7] - qy * v[6]);
+
+                    Float4 cap = length(qx - v[6] * v[2], qy - v[7] * v[2]) - v[3];
+                    return choose(qy * v[6] < qx * v[7], cap, band);
+                });
+                break;
+            case kShapeSegment: {
+                float dx = v[2] - v[0];
+                float dy = v[3] - v[1];
+                float length_ab = std::sqrt(dx * dx + dy * dy);
+                float ux = length_ab > 0.0f ? dx / length_ab : 1.0f;
+                float uy = length_ab > 0.0f ? dy / length_ab : 0.0f;
+                float mid_x = 0.5f * (v[0] + v[2]);
+                float mid_y = 0.5f * (v[1] + v[3]);
+                shadeSpans(shape, rect, [&](Float4 x, Float4 y, int) {
+                    Float4 px = x - mid_x;
+                    Float4 py = y - mid_y;
+                    Float4 qx = abs(px * ux + py * uy) - 0.5f * length_ab;
+                    Float4 qy = abs(py * ux - px * uy) - v[4];
+                    return length(max(qx, 0.0f), max(qy, 0.0f)) + min(max(qx, qy), 0.0f);
+                });
+                break;
+            }
+            case kShapeDiamond: {
+                constexpr float kInverseSqrt2 = 0.70710678f;
+                float inset = v[2] - v[3] / kInverseSqrt2;
+                shadeSpans(shape, rect, [&](Float4 x, Float4 y, int) {
+                    return (abs(x - v[0]) + abs(y - v[1]) - inset) * kInverseSqrt2 - v[3];
+                });
+                break;
+            }
+            case kShapeTriangle: {
+                float edges[6];
+                float inverse_lengths[3];
+                for (int i = 0; i < 3; ++i) {
+                    int next = (i + 1) % 3;
+                    edges[2 * i] = v[2 * next] - v[2 * i];
+                    edges[2 * i + 1] = v[2 * next + 1] - v[2 * i + 1];
+                    float length_squared = edges[2 * i] * edges[2 * i] + edges[2 * i + 1] * edges[2 * i + 1];
+                    inverse_lengths[i] = length_squared > 0.0f ? 1.0f / length_squared : 0.0f;
+                }
+                float winding = edges[0] * edges[5] - edges[1] * edges[4];
+                float sign = winding < 0.0f ? -1.0f : 1.0f;
+                shadeSpans(shape, rect, [&](Float4 x, Float4 y, int) {
+                    Float4 distance = 1e20f;
+                    Float4 side = 1e20f;
+                    for (int i = 0; i < 3; ++i) {
+                        Float4 px = x - v[2 * i];
+                        Float4 py = y - v[2 * i + 1];
+                        float ex = edges[2 * i];
+                        float ey = edges[2 * i + 1];
+                        Float4 t = clamp_unit((px * ex + py * ey) * inverse_lengths[i]);
+                        Float4 qx = px - t * ex;
+                        Float4 qy = py - t * ey;
+                        distance = min(distance, qx * qx + qy * qy);
+                        side = min(side, (px * ey - py * ex) * sign);
+                    }
+                    Float4 root = sqrt(distance);
+                    return choose(Float4(0.0f) < side, Float4(0.0f) - root, root);
+                });
+                break;
+            }
+            case kShapePolyline: {
+                // Only the segments that reach into this tile are measured.
+                thread_local std::vector<uint32_t> segments;
+                segments.clear();
+                const float* points = points_.data() + 2 * shape.first_point;
+                float reach = v[0] + 0.5f * shape.softness + 1.0f;
+                for (uint32_t i = 0; i + 1 < shape.num_points; ++i) {
+                    const float* a = points + 2 * i;
+                    if (std::max(a[0], a[2]) + reach >= rect[0] && std::min(a[0], a[2]) - reach <= rect[2] &&
+                        std::max(a[1], a[3]) + reach >= rect[1] && std::min(a[1], a[3]) - reach <= rect[3]) {
+                        segments.push_back(i);
+                    }
+                }
+                if (segments.empty())
+                    break;
+
+                shadeSpans(shape, rect, [&](Float4 x, Float4 y, int) {
+                    Float4 distance = 1e20f;
+                    for (uint32_t i : segments) {
+                        const float* a = points + 2 * i;
+                        float ex = a[2] - a[0];
+                        float ey = a[3] - a[1];
+                        float length_squared = ex * ex + ey * ey;
+                        float inverse = length_squared > 0.0f ? 1.0f / length_squared : 0.0f;
+                        Float4 px = x - a[0];
+                        Float4 py = y - a[1];
+                        Float4 t = clamp_unit((px * ex + py * ey) * inverse);
+                        Float4 qx = px - t * ex;
+                        Float4 qy = py - t * ey;
+                        distance = min(distance, qx * qx + qy * qy);
+                    }
+                    return sqrt(distance) - v[0];
+                });
+                break;
+            }
+            case kShapeLineFill: {
+                // Per column, the span between the line and the fill height. Points are expected in
+                // increasing x order.
+                float tops[kTileSize + 4];
+                float bottoms[kTileSize + 4];
+                const float* points = points_.data() + 2 * shape.first_point;
+                uint32_t count = shape.num_points;
+                int first_column = rect[0] & ~3;
+                for (int column = first_column; column < ((rect[2] + 3) & ~3); ++column) {
+                    float x = column + 0.5f;
+                    float* top = tops + (column - first_column);
+                    float* bottom = bottoms + (column - first_column);
+                    if (column < rect[0] || column >= rect[2] || x < points[0] || x > points[2 * (count - 1)]) {
+                        *top = 1e20f;
+                        *bottom = -1e20f;
+                        continue;
+                    }
+
+                    uint32_t low = 0;
+                    uint32_t high = count - 1;
+                    while (high - low > 1) {
+                        uint32_t mid = (low + high) / 2;
+                        if (points[2 * mid] <= x)
+                            low = mid;
+                        else
+                            high = mid;
+                    }
+                    float span = points[2 * high] - points[2 * low];
+                    float t = span > 0.0f ? (x - points[2 * low]) / span : 0.0f;
+                    float line_y = points[2 * low + 1] + t * (points[2 * high + 1] - points[2 * low + 1]);
+                    *top = std::min(line_y, v[0]);
+                    *bottom = std::max(line_y, v[0]);
+                }
+
+                shadeSpans(shape, rect, [&](Float4, Float4 y, int column) {
+                    int index = column - first_column;
+                    return max(Float4::load(tops + index) - y, y - Float4::load(bottoms + index));
+                });
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // Blends the shape into every pixel of `rect`, four at a time. `distance(x, y, column)` returns
+    // the signed distance to the outline at the pixel centers `x`, `y` starting at `column`.
+    template <typename Distance>
+    void shadeSpans(const Shape& shape, const int* rect, Distance&& distance) {
+        const Paint& paint = paints_[shape.paint];
+        const float* g = shape.gradient;
+        bool gradient = !paint.gradient.empty();
+        Float4 lane_offsets = Float4::load(kLaneOffsets);
+        float left = static_cast<float>(rect[0]);
+        float right = static_cast<float>(rect[2]);
+
+        for (int y = rect[1]; y < rect[3]; ++y) {
+            Float4 pixel_y = y + 0.5f;
+            size_t row = static_cast<size_t>(y) * stride_;
+            for (int x = rect[0] & ~3; x < rect[2]; x += 4) {
+                Float4 pixel_x = Float4(static_cast<float>(x)) + lane_offsets;
+                Float4 d = distance(pixel_x, pixel_y, x) - shape.offset;
+                if (shape.border >= 0.0f)
+                    d = abs(d + 0.5f * shape.border) - 0.5f * shape.border;
+
+                Float4 coverage = clamp_unit(Float4(0.5f) - d / shape.softness);
+                if (shape.smooth)
+                    coverage = coverage * coverage * (Float4(3.0f) - coverage - coverage);
+                coverage = choose(pixel_x < left, 0.0f, choose(Float4(right) < pixel_x, 0.0f, coverage));
+
+                Float4 source[4];
+                if (gradient) {
+                    Float4 t = clamp_unit((pixel_x - g[0]) * g[2] + (pixel_y - g[1]) * g[3]);
+                    float positions[4];
+                    (t * (kGradientResolution - 1.0f) + 0.5f).store(positions);
+                    float channels[4][4];
+                    for (int lane = 0; lane < 4; ++lane) {
+                        const float* color = paint.gradient.data() + 4 * static_cast<int>(positions[lane]);
+                        for (int c = 0; c < 4; ++c)
+                            channels[c][lane] = color[c];
+                    }
+                    for (int c = 0; c < 4; ++c)
+                        source[c] = Float4::load(channels[c]);
+                } else {
+                    for (int c = 0; c < 4; ++c)
+                        source[c] = paint.color[c];
+                }
+
+                Float4 remaining = Float4(1.0f) - source[3] * coverage;
+                for (int c = 0; c < 4; ++c) {
+                    float* destination = planes_[c].data() + row + x;
+                    (source[c] * coverage + Float4::load(destination) * remaining).store(destination);
+                }
+            }
+        }
+    }
+
+    void packRow(int y) {
+        const float* planes[4];
+        for (int c = 0; c < 4; ++c)
+            planes[c] = planes_[c].data() + static_cast<size_t>(y) * stride_;
+
+        uint32_t* row = pixels_.data() + static_cast<size_t>(y) * width_;
+        for (int x = 0; x < width_; ++x) {
+            float alpha = std::min(std::max(planes[3][x], 0.0f), 1.0f);
+            float unpremultiply = alpha > 0.0f ? 255.0f / alpha : 0.0f;
+            auto channel = [&](const float* plane) {
+                return static_cast<uint32_t>(std::min(std::max(plane[x] * unpremultiply, 0.0f), 255.0f) + 0.5f);
+            };
+            row[x] = (static_cast<uint32_t>(alpha * 255.0f + 0.5f) << 24) | (channel(planes[0]) << 16) |
+                     (channel(planes[1]) << 8) | channel(planes[2]);
+        }
+    }
+
+    static constexpr float kLaneOffsets[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+
+    int width_ = 0;
+    int height_ = 0;
+    // Rows are padded to whole spans of four pixels.
+    int stride_ = 0;
+    int tiles_x_ = 0;
+    int tiles_y_ = 0;
+    float scale_ = 1.0f;
+    // Premultiplied red, green, blue and alpha.
+    std::vector<float> planes_[4];
+    std::vector<uint32_t> pixels_;
+    bool pixels_current_ = false;
+
+    std::vector<Shape> shapes_;
+    std::vector<float> points_;
+    std::vector<Paint> paints_;
+    std::unordered_map<const BrushSource*, uint32_t> brush_paints_;
+    std::vector<std::vector<uint32_t>> tile_shapes_;
+    State state_;
+    std::vector<State> saved_;
+    int32_t skipped_ = 0;
+    VisageSoftwareRasterStats stats_ = {};
+};
+
+// Pixels of a rasterized layer as atlas tiles. Every tile is converted when the raster is made, so
+// the surface never reads its source pixels again and drawing it only hands out tile buffers.
+struct LayerRaster {
+    LayerRaster(const uint32_t* pixels, int width, int height, float raster_scale) :
+        scale(raster_scale), surface(pixels, VisageImageFormatARGB8, width, height, 0) {
+        for (int row = 0; row < surface.rows(); ++row) {
+            for (int column = 0; column < surface.columns(); ++column)
+                surface.tilePixels(column, row);
+        }
+        bytes = static_cast<uint64_t>(surface.rows()) * surface.columns() * ImageSurface::kTileSize * ImageSurface::kTileSize * 4;
+    }
+
+    float scale = 1.0f;
+    uint64_t bytes = 0;
+    // Counts rasterizations, so a new raster can be told apart from one it replaced.
+    uint64_t generation = 0;
+    ImageSurface surface;
+};
+
+// Finds whether rasterizing a list and drawing its text over the pixels draws what replaying it
+// does: the software raster draws every shape in it and only text follows its first text.
+struct RasterCheck {
+    bool rasterizes = true;
+    bool seen_text = false;
+
+    void setColor(const visage::Color&) {}
+    void setBrush(const BrushSource&) {}
+    void text(const visage::Text&, const VisageShapeCommand&) { seen_text = true; }
+    void line(const visage::Line&, const VisageShapeCommand&) { rasterizes = rasterizes && !seen_text; }
+    void image(const CommandList::Pixels&, const VisageShapeCommand&) { rasterizes = false; }
+    void shape(const VisageShapeCommand& command) {
+        Bounds bounds;
+        bool draws = command_bounds(command, &bounds);
+        rasterizes = rasterizes && !(draws && seen_text);
+    }
+};
+
+struct VisageLayer_t {
+    float width = 0.0f;
+    float height = 0.0f;
+    // Set once the layer is drawn into, cleared when it is invalidated.
+    bool drawn = false;
+    // Whether `content` was checked with RasterCheck since it was drawn, and the result.
+    bool checked = false;
+    bool rasterizes = false;
+    CommandList content;
+    // The text of `content`, drawn over the pixels on every composite.
+    CommandList text;
+    std::shared_ptr<LayerRaster> raster;
+    std::list<VisageLayer_t*>::iterator entry;
+};
+
+// Every live layer, most recently composited first, and the bytes their rasters hold. Past the
+// budget, rasters of the least recently composited layers are dropped; their commands are kept, so
+// they are rasterized again the next time they are composited. Thread safe.
+class LayerCache {
+public:
+    static constexpr uint64_t kDefaultBudget = 128 * 1024 * 1024;
+
+    // Never destroyed, layers may still be deleted during static destruction.
+    static LayerCache& instance() {
+        static LayerCache* cache = new LayerCache;
+        return *cache;
+    }
+
+    void add(VisageLayer_t* layer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.push_front(layer);
+        layer->entry = lru_.begin();
+    }
+
+    void remove(VisageLayer_t* layer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dropRaster(layer);
+        lru_.erase(layer->entry);
+    }
+
+    // Drops the raster and commands of `layer` so it can be drawn again.
+    void invalidate(VisageLayer_t* layer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dropRaster(layer);
+        layer->content.clear();
+        layer->text.clear();
+        layer->drawn = false;
+        layer->checked = false;
+    }
+
+    // Whether `layer` is composited as pixels with its text drawn over them. Layers that aren't
+    // have their commands replayed on every composite instead.
+    bool rasterizes(VisageLayer_t* layer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!layer->checked) {
+            RasterCheck check;
+            layer->content.visit(check);
+            layer->rasterizes = check.rasterizes;
+            layer->checked = true;
+        }
+        return layer->rasterizes;
+    }
+
+    // Returns the raster of `layer` at `scale`, rasterizing its commands if there is none. The
+    // layer becomes the most recently used and is never evicted by its own composite.
+    std::shared_ptr<LayerRaster> resolve(VisageLayer_t* layer, float scale) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        composites_++;
+        if (layer->raster && layer->raster->scale != scale)
+            dropRaster(layer);
+
+        if (layer->raster == nullptr) {
+            int width = std::max(1, static_cast<int>(layer->width * scale + 0.5f));
+            int height = std::max(1, static_cast<int>(layer->height * scale + 0.5f));
+            SoftwareRaster software(width, height);
+            software.setScale(scale);
+            software.draw(layer->content, 0.0f, 0.0f);
+
+            layer->raster = std::make_shared<LayerRaster>(software.pixels(), width, height, scale);
+            layer->raster->generation = ++rasterizations_;
+            layer->text.clear();
+            layer->text.appendText(layer->content);
+            bytes_ += layer->raster->bytes;
+            resident_++;
+        }
+
+        lru_.splice(lru_.begin(), lru_, layer->entry);
+        evict(layer);
+        return layer->raster;
+    }
+
+    void setBudget(uint64_t budget) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        budget_ = budget;
+        evict(nullptr);
+    }
+
+    VisageLayerCacheStats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return { static_cast<int32_t>(lru_.size()), resident_, bytes_, budget_, rasterizations_, evictions_, composites_ };
+    }
+
+private:
+    // Canvases keep the rasters they composited alive until they are cleared, so dropping one never
+    // frees pixels a frame still points to.
+    void dropRaster(VisageLayer_t* layer) {
+        if (layer->raster == nullptr)
+            return;
+
+        bytes_ -= layer->raster->bytes;
+        resident_--;
+        layer->raster.reset();
+    }
+
+    void evict(const VisageLayer_t* keep) {
+        for (auto it = lru_.rbegin(); it != lru_.rend() && bytes_ > budget_; ++it) {
+            if (*it != keep && (*it)->raster) {
+                dropRaster(*it);
+                evictions_++;
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::list<VisageLayer_t*> lru_;
+    int32_t resident_ = 0;
+    uint64_t bytes_ = 0;
+    uint64_t budget_ = kDefaultBudget;
+    uint64_t rasterizations_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t composites_ = 0;
+};
+
+// The one thread that replays and submits the frames of every asynchronously submitting canvas,
+// in the order they were handed over, so only one thread at a time ever drives the renderer. Never
+// destroyed, canvases may still be destroyed during static destruction.
+class RenderThread {
+public:
+    static RenderThread& instance() {
+        static RenderThread* thread = new RenderThread;
+        return *thread;
+    }
+
+    // Runs `job` on the render thread after every job posted before it.
+    void post(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(std::move(job));
+        }
+        condition_.notify_one();
+    }
+
+private:
+    RenderThread() {
+        std::thread([this] { run(); }).detach();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            condition_.wait(lock, [&] { return !jobs_.empty(); });
+            std::function<void()> job = std::move(jobs_.front());
+            jobs_.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::function<void()>> jobs_;
+};
+
+// Submits the frames of one canvas on the render thread. The drawing thread fills `frame()` while
+// up to `frames_in_flight` earlier frames wait for or are being replayed onto the visage canvas and
+// submitted. A submitted list is kept until the next one is submitted, so pixels it handed to the
+// image atlas outlive the frame they were drawn in, then goes back to a pool for later frames.
+class AsyncSubmitter {
+public:
+    AsyncSubmitter(visage::Canvas* canvas, uint64_t submitted) :
+        canvas_(canvas), submitted_(submitted), completed_(submitted), frame_(std::make_unique<CommandList>()) { }
+
+    // Frames already handed over are submitted first.
+    ~AsyncSubmitter() { wait(UINT64_MAX); }
+
+    CommandList* frame() const { return frame_.get(); }
+    // How long replaying and submitting the last completed frame took.
+    double lastSubmitSeconds() const { return last_submit_seconds_.load(std::memory_order_relaxed); }
+
+    void setFramesInFlight(int frames) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            frames_in_flight_ = std::max(frames, 1);
+        }
+        condition_.notify_all();
+    }
+
+    // Hands the current frame to the render thread and starts an empty one. Only blocks while
+    // `frames_in_flight` frames are still queued or being submitted.
+    uint64_t submit(int pass) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [&] { return submitted_ - completed_ < static_cast<uint64_t>(frames_in_flight_); });
+
+        queue_.push_back({ std::move(frame_), pass, ++submitted_ });
+        if (free_.empty()) {
+            frame_ = std::make_unique<CommandList>();
+        } else {
+            frame_ = std::move(free_.back());
+            free_.pop_back();
+        }
+        uint64_t fence = submitted_;
+        lock.unlock();
+
+        RenderThread::instance().post([this] { submitNext(); });
+        return fence;
+    }
+
+    void wait(uint64_t fence) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [&] { return completed_ >= std::min(fence, submitted_); });
+    }
+    bool complete(uint64_t fence) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return completed_ >= fence;
+    }
+    uint64_t submitted() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return submitted_;
+    }
+
+private:
+    struct Frame {
+        std::unique_ptr<CommandList> commands;
+        int pass = 0;
+        uint64_t fence = 0;
+    };
+
+    // Called on the render thread once per submitted frame. Nothing is touched after the fence is
+    // completed, the submitter may be destroyed right after.
+    void submitNext() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Frame frame = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        {
+            std::lock_guard<std::mutex> render_lock(render_mutex());
+            auto start = std::chrono::steady_clock::now();
+            canvas_->clearDrawnShapes();
+            frame.commands->replay(canvas_);
+            canvas_->submit(frame.pass);
+            last_submit_seconds_.store(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+                                       std::memory_order_relaxed);
+        }
+
+        // Only the render thread and the destructor, after every frame completed, use `previous_`.
+        std::unique_ptr<CommandList> done = std::move(previous_);
+        previous_ = std::move(frame.commands);
+        if (done)
+            done->clear();
+
+        lock.lock();
+        if (done)
+            free_.push_back(std::move(done));
+        completed_ = frame.fence;
+        condition_.notify_all();
+    }
+
+    visage::Canvas* canvas_ = nullptr;
+    std::atomic<double> last_submit_seconds_ { 0.0 };
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Frame> queue_;
+    std::vector<std::unique_ptr<CommandList>> free_;
+    std::unique_ptr<CommandList> previous_;
+    uint64_t submitted_ = 0;
+    uint64_t completed_ = 0;
+    int frames_in_flight_ = 1;
+    std::unique_ptr<CommandList> frame_;
+};
+
+// Counters of the frame drawn on a canvas since it was last cleared. Each has a single writer, the
+// thread drawing the canvas, so adding is a relaxed load and store instead of a locked
+// read-modify-write, and stats can still be read from any thread. Counting compiles to nothing
+// without VISAGE_C_FRAME_STATS.
+class FrameCounters {
+public:
+    static constexpr bool kEnabled = VISAGE_C_FRAME_STATS != 0;
+    // Batch kind of pixels handed to the image atlas, next to the shape and recorded types.
+    static constexpr uint32_t kPixels = kRecordedLineFill + 1;
+
+    // Starts counting a new frame. Atlas entries used by the previous frame are still resident.
+    void reset() {
+        if (!kEnabled)
+            return;
+
+        for (std::atomic<uint32_t>& count : commands_)
+            count.store(0, std::memory_order_relaxed);
+        for (std::atomic<uint32_t>& count : counts_)
+            count.store(0, std::memory_order_relaxed);
+        for (std::atomic<uint64_t>& bytes : bytes_)
+            bytes.store(0, std::memory_order_relaxed);
+        frame_seconds_.store(0.0, std::memory_order_relaxed);
+        frame_++;
+        last_kind_ = UINT32_MAX;
+    }
+
+    // Adds the time spent inside a draw call to the frame's record time. Draw calls made from
+    // inside another one are part of its time.
+    class RecordTimer {
+    public:
+        explicit RecordTimer(FrameCounters* counters) : counters_(kEnabled ? counters : nullptr) {
+            if (counters_ && counters_->record_depth_++ == 0)
+                start_ = std::chrono::steady_clock::now();
+        }
+        ~RecordTimer() {
+            if (counters_ && --counters_->record_depth_ == 0) {
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+                add(counters_->frame_seconds_, seconds);
+            }
+        }
+
+        RecordTimer(const RecordTimer&) = delete;
+        RecordTimer& operator=(const RecordTimer&) = delete;
+
+    private:
+        FrameCounters* counters_ = nullptr;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    void command(const VisageShapeCommand& command, bool draws) {
+        if (!kEnabled)
+            return;
+
+        if (command.type < VisageNumShapeCommandTypes)
+            add(commands_[command.type], 1u);
+        if (draws)
+            draw(command.type);
+    }
+    void setColor(const visage::Color&) { command({ VisageShapeCommandSetColor, 0, {} }, false); }
+    void setBrush(const BrushSource& source) {
+        if (!kEnabled)
+            return;
+
+        command({ VisageShapeCommandSetBrush, 0, {} }, false);
+        if (firstUse(&gradients_, source.gradient_hash))
+            add(bytes_[kGradientUploadBytes], static_cast<uint64_t>(source.gradient.resolution()) * 4);
+    }
+    void line(bool fill) {
+        if (!kEnabled)
+            return;
+
+        add(counts_[fill ? kLineFills : kLines], 1u);
+        draw(fill ? kRecordedLineFill : kRecordedLine);
+    }
+    // `entry` is the font the text was set with, if known, for counting glyphs new to its atlas.
+    void text(const visage::Text& text, FontEntry* entry) {
+        if (!kEnabled)
+            return;
+
+        const visage::String& string = text.text();
+        add(counts_[kTexts], 1u);
+        add(counts_[kGlyphs], static_cast<uint32_t>(string.length()));
+        draw(kRecordedText);
+        if (entry) {
+            // Glyphs are assumed to take a square of the font's pixel size in an RGBA8 atlas.
+            uint64_t glyph_size = static_cast<uint64_t>(std::ceil(entry->key.size * std::max(entry->key.dpi_scale, 1.0f)));
+            size_t new_glyphs = mark_drawn_glyphs(entry, string.c_str(), string.length());
+            add(bytes_[kGlyphUploadBytes], new_glyphs * glyph_size * glyph_size * 4);
+        }
+    }
+    void pixels(const void* data, int width, int height) {
+        if (!kEnabled)
+            return;
+
+        add(counts_[kImages], 1u);
+        draw(kPixels);
+        if (firstUse(&pixels_, reinterpret_cast<uintptr_t>(data)))
+            add(bytes_[kImageUploadBytes], static_cast<uint64_t>(width) * height * 4);
+    }
+    // Counts what replaying `list` draws.
+    void list(const CommandList& list) {
+        if (kEnabled)
+            list.visit(*this);
+    }
+    // For visiting command lists.
+    void line(const visage::Line&, const VisageShapeCommand& command) { line(command.type == kRecordedLineFill); }
+    void text(const visage::Text& text, const VisageShapeCommand&) { this->text(text, nullptr); }
+    void image(const CommandList::Pixels& pixels, const VisageShapeCommand&) { this->pixels(pixels.data, pixels.width, pixels.height); }
+    void shape(const VisageShapeCommand& command) {
+        Bounds bounds;
+        this->command(command, command_bounds(command, &bounds));
+    }
+
+    // Called at submit with how long handing the frame over took and the bytes held for it, which
+    // is when the frame holds the most.
+    void submitted(bool elided, double submit_seconds, uint64_t frame_bytes) {
+        if (!kEnabled)
+            return;
+
+        submit_seconds_.store(submit_seconds, std::memory_order_relaxed);
+        bytes_[kFrameBytes].store(frame_bytes, std::memory_order_relaxed);
+        elided_.store(elided, std::memory_order_relaxed);
+    }
+
+    // `async` supplies the submit time while frames are submitted on a render thread.
+    void stats(VisageFrameStats* stats, const AsyncSubmitter* async) const {
+        *stats = {};
+        if (!kEnabled)
+            return;
+
+        for (int i = 0; i < VisageNumShapeCommandTypes; ++i)
+            stats->commands[i] = commands_[i].load(std::memory_order_relaxed);
+        stats->lines = counts_[kLines].load(std::memory_order_relaxed);
+        stats->line_fills = counts_[kLineFills].load(std::memory_order_relaxed);
+        stats->texts = counts_[kTexts].load(std::memory_order_relaxed);
+        stats->images = counts_[kImages].load(std::memory_order_relaxed);
+        stats->batches = counts_[kBatches].load(std::memory_order_relaxed);
+        stats->draw_calls = counts_[kDrawCalls].load(std::memory_order_relaxed);
+        stats->text_glyphs = counts_[kGlyphs].load(std::memory_order_relaxed);
+        stats->gradient_upload_bytes = bytes_[kGradientUploadBytes].load(std::memory_order_relaxed);
+        stats->glyph_upload_bytes = bytes_[kGlyphUploadBytes].load(std::memory_order_relaxed);
+        stats->image_upload_bytes = bytes_[kImageUploadBytes].load(std::memory_order_relaxed);
+        stats->peak_frame_bytes = bytes_[kFrameBytes].load(std::memory_order_relaxed);
+        stats->frame_seconds = frame_seconds_.load(std::memory_order_relaxed);
+        stats->submit_seconds = async ? async->lastSubmitSeconds() : submit_seconds_.load(std::memory_order_relaxed);
+        stats->elided = elided_.load(std::memory_order_relaxed);
+    }
+
+private:
+    enum Count { kLines, kLineFills, kTexts, kImages, kBatches, kDrawCalls, kGlyphs, kNumCounts };
+    enum Bytes { kGradientUploadBytes, kGlyphUploadBytes, kImageUploadBytes, kFrameBytes, kNumBytes };
+
+    template <typename T>
+    static void add(std::atomic<T>& counter, T amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // Visage batches consecutive draws of the same kind, so a batch starts wherever the kind changes.
+    void draw(uint32_t kind) {
+        add(counts_[kDrawCalls], 1u);
+        if (kind != last_kind_)
+            add(counts_[kBatches], 1u);
+        last_kind_ = kind;
+    }
+
+    // The frame an atlas entry was last used in. Entries are kept in a fixed table indexed by their
+    // key, so counting never allocates while drawing. Keys sharing a slot evict each other and are
+    // counted as uploaded again, which only makes the estimate higher.
+    struct AtlasUse {
+        uint64_t key = 0;
+        uint64_t frame = 0;
+    };
+    static constexpr int kAtlasUseBits = 10;
+
+    // Returns true if `key` wasn't used in this frame or the one before, so its atlas entry has to
+    // be uploaded.
+    bool firstUse(std::vector<AtlasUse>* uses, uint64_t key) {
+        AtlasUse& use = (*uses)[(key * 0x9e3779b97f4a7c15ull) >> (64 - kAtlasUseBits)];
+        bool used = use.frame != 0 && use.key == key && use.frame + 1 >= frame_;
+        use = { key, frame_ };
+        return !used;
+    }
+
+    std::atomic<uint32_t> commands_[VisageNumShapeCommandTypes] = {};
+    std::atomic<uint32_t> counts_[kNumCounts] = {};
+    std::atomic<uint64_t> bytes_[kNumBytes] = {};
+    std::atomic<double> frame_seconds_ { 0.0 };
+    std::atomic<double> submit_seconds_ { 0.0 };
+    std::atomic<bool> elided_ { false };
+    std::vector<AtlasUse> gradients_ = std::vector<AtlasUse>(kEnabled ? 1 << kAtlasUseBits : 0);
+    std::vector<AtlasUse> pixels_ = std::vector<AtlasUse>(kEnabled ? 1 << kAtlasUseBits : 0);
+    // Frames are counted from 1, so unused table entries are never recent.
+    uint64_t frame_ = 1;
+    uint32_t last_kind_ = UINT32_MAX;
+    int record_depth_ = 0;
+};
+
+// Everything whose pixels were handed to visage's image atlas in one frame. The atlas identifies
+// images by data pointer, so the buffers are kept alive through the frame after the one they're
+// drawn in: while the atlas may still hold an entry for an address, that address can't be reused by
+// an allocation with different pixels.
+struct FramePixels {
+    std::vector<std::shared_ptr<const uint8_t>> tiles;
+    std::vector<std::shared_ptr<const SvgRaster>> svgs;
+    std::vector<std::shared_ptr<LayerRaster>> layers;
+
+    // Pixels replayed from recording contexts, whose lists are cleared once the frame is submitted.
+    std::vector<std::shared_ptr<const void>> recorded;
+
+    void clear() {
+        tiles.clear();
+        svgs.clear();
+        layers.clear();
+        recorded.clear();
+    }
+};
+
+// What every canvas handle has. Handles from VisageCanvas_new are DrawingCanvases, recording
+// contexts are RecordingContexts, which always record and hold nothing that draws.
+struct VisageCanvas_t {
+    // While set, draw calls are appended to this list instead of being drawn.
+    CommandList* recording = nullptr;
+    bool is_context = false;
+};
+
+struct RecordingContext;
+
+struct DrawingCanvas : VisageCanvas_t {
+    visage::Canvas canvas;
+    int32_t width = 0;
+    int32_t height = 0;
+    // While set, draw calls are also appended to this list so the frame can be saved.
+    std::unique_ptr<CommandList> capture;
+    StreamStorage stream_storage;
+    // Copies of the lines pyramids were laid out into, drawn directly since the last clear. A pyramid
+    // reuses its line for every layout, and visage reads lines when the frame is submitted.
+    std::deque<visage::Line> frame_lines;
+    // Position of what is drawn directly, used to place draw calls against the dirty region.
+    PositionTracker position;
+    DirtyRegion dirty;
+    // Pixels drawn since the last clear and those drawn in the frame before.
+    FramePixels frame_pixels;
+    FramePixels previous_frame_pixels;
+    // While submit is asynchronous, what would be drawn on `canvas` goes into this frame instead.
+    std::unique_ptr<AsyncSubmitter> async;
+    CommandList* frame = nullptr;
+    uint64_t submitted_frames = 0;
+    int frames_in_flight = 1;
+    // Recording contexts drawn into this canvas at submit, sorted by order.
+    std::vector<RecordingContext*> contexts;
+    // Hash of what was drawn since the last clear. Submitting skips frames whose hash, folded with
+    // the size, scale and, when shaders read it, the time, matches the last submitted frame's.
+    // Nothing is hashed unless idle elision is turned on.
+    uint64_t frame_hash = 0;
+    uint64_t submitted_hash = 0;
+    bool idle_elision = false;
+    bool time_dependent = false;
+    // Set when the next frame has to be submitted whatever its hash.
+    bool redraw = true;
+    double time = 0.0;
+    FrameCounters counters;
+};
+
+// Records into `commands`, which are placed at `bounds` in `parent` when it submits.
+struct RecordingContext : VisageCanvas_t {
+    // Cleared if the parent is destroyed first.
+    DrawingCanvas* parent = nullptr;
+    CommandList commands;
+    Bounds bounds;
+    int32_t order = 0;
+};
+
+// Returns null for the other kind of handle. A handle that isn't recording is always a
+// DrawingCanvas, so draw paths past their recording check use `drawing_canvas_of`.
+inline DrawingCanvas* as_drawing_canvas(VisageCanvas* canvas) {
+    return canvas->is_context ? nullptr : static_cast<DrawingCanvas*>(canvas);
+}
+inline const DrawingCanvas* as_drawing_canvas(const VisageCanvas* canvas) {
+    return canvas->is_context ? nullptr : static_cast<const DrawingCanvas*>(canvas);
+}
+inline RecordingContext* as_recording_context(VisageCanvas* canvas) {
+    return canvas->is_context ? static_cast<RecordingContext*>(canvas) : nullptr;
+}
+inline const RecordingContext* as_recording_context(const VisageCanvas* canvas) {
+    return canvas->is_context ? static_cast<const RecordingContext*>(canvas) : nullptr;
+}
+inline DrawingCanvas* drawing_canvas_of(VisageCanvas* canvas) {
+    return static_cast<DrawingCanvas*>(canvas);
+}
+
+// Counters draw calls on `canvas` add their time to. Recording contexts may record on other
+// threads, while counters have a single writer, so only a canvas's own draw calls are timed.
+inline FrameCounters* record_counters(VisageCanvas* canvas) {
+    DrawingCanvas* drawing = as_drawing_canvas(canvas);
+    return drawing ? &drawing->counters : nullptr;
+}
+
+// Calls that change what the visage canvas renders to can't run while any frame is being
+// submitted, on the render thread or not.
+inline std::unique_lock<std::mutex> lock_visage_canvas(DrawingCanvas*) {
+    return std::unique_lock<std::mutex>(render_mutex());
+}
+
+// Folds what a draw call reads into the hash of the frame. Every drawing path hashes its arguments
+// when `canvas_hashing` is set, so frames drawn the same way hash the same.
+inline bool canvas_hashing(const DrawingCanvas* canvas) {
+    return canvas->idle_elision;
+}
+inline void canvas_hash(DrawingCanvas* canvas, uint64_t value) {
+    canvas->frame_hash = hash_combine(canvas->frame_hash, value);
+}
+inline void canvas_hash_bytes(DrawingCanvas* canvas, const void* data, size_t size) {
+    canvas_hash(canvas, hash_bytes(static_cast<const char*>(data), size));
+}
+
+// Returns true if `bounds`, relative to the current position, touches the dirty region. This is only
+// a hint for callers: visage composites the whole frame, so nothing is ever culled here.
+inline bool canvas_rect_dirty(const DrawingCanvas* canvas, const Bounds& bounds) {
+    return canvas->dirty.touches(bounds.translated(canvas->position.x(), canvas->position.y()));
+}
+
+inline void canvas_draw(VisageCanvas* handle, const VisageShapeCommand& command) {
+    if (handle->recording) {
+        handle->recording->add(command);
+        return;
+    }
+
+    DrawingCanvas* canvas = drawing_canvas_of(handle);
+    Bounds bounds;
+    bool draws = command_bounds(command, &bounds);
+    if (!draws)
+        canvas->position.apply(command);
+
+    if (canvas_hashing(canvas))
+        canvas_hash_bytes(canvas, &command, sizeof(command));
+    canvas->counters.command(command, draws);
+    if (canvas->capture)
+        canvas->capture->add(command);
+    if (canvas->frame)
+        canvas->frame->add(command);
+    else
+        draw_shape_command(&canvas->canvas, command);
+}
+inline void canvas_set_color(VisageCanvas* handle, const visage::Color& color) {
+    if (handle->recording) {
+        handle->recording->addColor(color);
+        return;
+    }
+
+    DrawingCanvas* canvas = drawing_canvas_of(handle);
+    if (canvas_hashing(canvas))
+        canvas_hash(canvas, color_hash(color));
+    canvas->counters.setColor(color);
+    if (canvas->capture)
+        canvas->capture->addColor(color);
+    if (canvas->frame)
+        canvas->frame->addColor(color);
+    else
+        canvas->canvas.setColor(color);
+}
+inline void canvas_set_brush(VisageCanvas* handle, const VisageBrush_t& brush) {
+    if (handle->recording) {
+        handle->recording->addBrush(brush);
+        return;
+    }
+
+    DrawingCanvas* canvas = drawing_canvas_of(handle);
+    if (canvas_hashing(canvas))
+        canvas_hash(canvas, brush_source_hash(brush.source));
+    canvas->counters.setBrush(brush.source);
+    if (canvas->capture)
+        canvas->capture->addBrush(brush);
+    if (canvas->frame)
+        canvas->frame->addBrush(brush);
+    else
+        canvas->canvas.setBrush(brush.brush);
+}
+
+// Draws `count` shapes built by `make_command(index)`, setting the color from `argb` first when it
+// is given and differs from the previous instance. The color change is undone afterwards.
+template <typename MakeCommand>
+void canvas_draw_instances(VisageCanvas* canvas, const uint32_t* argb, int32_t count, MakeCommand&& make_command) {
+    if (count <= 0)
+        return;
+
+    if (argb)
+        canvas_draw(canvas, { VisageShapeCommandSaveState, 0, {} });
+    for (int32_t i = 0; i < count; ++i) {
+        if (argb && (i == 0 || argb[i] != argb[i - 1]))
+            canvas_set_color(canvas, visage::Color::fromARGB(argb[i]));
+        canvas_draw(canvas, make_command(i));
+    }
+    if (argb)
+        canvas_draw(canvas, { VisageShapeCommandRestoreState, 0, {} });
+}
+
+// Images, svgs and layers are drawn as pixels, which display lists can't hold, so they're skipped
+// while recording one. Recording contexts keep them in their commands until the parent submits.
+inline bool canvas_recording_display_list(const VisageCanvas* canvas) {
+    const RecordingContext* context = as_recording_context(canvas);
+    return canvas->recording && (context == nullptr || canvas->recording != &context->commands);
+}
+
+// Draws a state command that belongs to the frame but not to captures or the tracked position, like
+// the clamp around an image.
+inline void canvas_frame_command(VisageCanvas* handle, const VisageShapeCommand& command) {
+    if (handle->recording) {
+        handle->recording->add(command);
+        return;
+    }
+
+    DrawingCanvas* canvas = drawing_canvas_of(handle);
+    if (canvas->frame)
+        canvas->frame->add(command);
+    else
+        draw_shape_command(&canvas->canvas, command);
+}
+
+// Draws `list` at `x`, `y` into the frame, without hashing, counting or capturing it.
+inline void canvas_frame_list(VisageCanvas* handle, const CommandList& list, float x, float y) {
+    if (handle->recording) {
+        handle->recording->append(list, x, y);
+        return;
+    }
+
+    DrawingCanvas* canvas = drawing_canvas_of(handle);
+    if (canvas->frame) {
+        canvas->frame->append(list, x, y);
+        return;
+    }
+
+    canvas->canvas.saveState();
+    canvas->canvas.setPosition(x, y);
+    list.replay(&canvas->canvas);
+    canvas->canvas.restoreState();
+}
+
+// Hands RGBA8 pixels to visage's image atlas, which uploads them once per data pointer. Frames
+// submitted asynchronously and recording contexts keep `pixels.owner` until they are replayed,
+// drawing directly leaves keeping the pixels alive to the caller.
+inline void canvas_draw_pixels(VisageCanvas* handle, CommandList::Pixels pixels, float x, float y, float width, float height) {
+    if (handle->recording) {
+        handle->recording->addPixels(std::move(pixels), x, y, width, height);
+        return;
+    }
+
+    DrawingCanvas* canvas = drawing_canvas_of(handle);
+    float values[] = { static_cast<float>(pixels.width), static_cast<float>(pixels.height), x, y, width, height };
+    if (canvas_hashing(canvas)) {
+        canvas_hash(canvas, reinterpret_cast<uintptr_t>(pixels.data));
+        canvas_hash_bytes(canvas, values, sizeof(values));
+    }
+    canvas->counters.pixels(pixels.data, pixels.width, pixels.height);
+    if (canvas->frame)
+        canvas->frame->addPixels(std::move(pixels), x, y, width, height);
+    else
+        canvas->canvas.image(pixels.data, pixels.width * pixels.height * 4, x, y, width, height);
+}
+
+// Recording contexts lay lines out and rasterize svgs and layers at their parent's scale.
+inline float canvas_dpi_scale(const VisageCanvas* canvas) {
+    if (const RecordingContext* context = as_recording_context(canvas))
+        return context->parent ? context->parent->canvas.dpiScale() : 1.0f;
+    return static_cast<const DrawingCanvas*>(canvas)->canvas.dpiScale();
+}
+
+inline void canvas_line(VisageCanvas* handle, visage::Line* line, float x, float y, float width, float height, float line_width) {
+    if (handle->recording) {
+        handle->recording->addLine(*line, x, y, width, height, line_width);
+        return;
+    }
+
+    DrawingCanvas* canvas = drawing_canvas_of(handle);
+    if (canvas_hashing(canvas)) {
+        float values[] = { x, y, width, height, line_width };
+        canvas_hash(canvas, line_hash(*line));
+        canvas_hash_bytes(canvas, values, sizeof(values));
+    }
+    canvas->counters.line(false);
+    if (canvas->capture)
+        canvas->capture->addLine(*line, x, y, width, height, line_width);
+    if (canvas->frame)
+        canvas->frame->addLine(*line, x, y, width, height, line_width);
+    else
+        canvas->canvas.line(line, x, y, width, height, line_width);
+}
+
+inline void canvas_draw_list(VisageCanvas* handle, const CommandList& list, float x, float y) {
+    if (handle->recording) {
+        handle->recording->append(list, x, y);
+        return;
+    }
+
+    DrawingCanvas* canvas = drawing_canvas_of(handle);
+    if (canvas_hashing(canvas)) {
+        float position[] = { x, y };
+        canvas_hash(canvas, list.hash());
+        canvas_hash_bytes(canvas, position, sizeof(position));
+    }
+    canvas->counters.list(list);
+    if (canvas->capture)
+        canvas->capture->append(list, x, y);
+    canvas_frame_list(canvas, list, x, y);
+}
+
+// Draws what the recording contexts of `canvas` recorded, in order, each clamped to its bounds.
+// Contexts are cleared once the frame is submitted, so pixels replayed directly are kept alive as
+// long as the frame's own.
+inline void canvas_merge_contexts(DrawingCanvas* canvas) {
+    for (const RecordingContext* context : canvas->contexts) {
+        const CommandList& list = context->commands;
+        if (list.numCommands() == 0)
+            continue;
+
+        if (canvas->frame == nullptr)
+            list.pixelOwners(&canvas->frame_pixels.recorded);
+        const Bounds& bounds = context->bounds;
+        canvas_draw(canvas, { VisageShapeCommandSaveState, 0, {} });
+        canvas_draw(canvas, { VisageShapeCommandSetPosition, 0, { bounds.x, bounds.y } });
+        if (!bounds.isEmpty())
+            canvas_draw(canvas, { VisageShapeCommandTrimClampBounds, 0, { 0.0f, 0.0f, bounds.width, bounds.height } });
+        canvas_draw_list(canvas, list, 0.0f, 0.0f);
+        canvas_draw(canvas, { VisageShapeCommandRestoreState, 0, {} });
+    }
+}
+
+// Returns true if the frame drawn since the last clear would look like the last submitted frame,
+// in which case it doesn't need to be submitted. Otherwise it becomes the last submitted frame.
+inline bool canvas_frame_unchanged(DrawingCanvas* canvas) {
+    if (!canvas->idle_elision) {
+        canvas->redraw = false;
+        return false;
+    }
+
+    float dpi_scale = canvas->canvas.dpiScale();
+    uint64_t hash = hash_combine(canvas->frame_hash, (static_cast<uint64_t>(static_cast<uint32_t>(canvas->width)) << 32) |
+                                                         static_cast<uint32_t>(canvas->height));
+    hash = hash_combine(hash, hash_bytes(reinterpret_cast<const char*>(&dpi_scale), sizeof(dpi_scale)));
+    if (canvas->time_dependent)
+        hash = hash_combine(hash, hash_bytes(reinterpret_cast<const char*>(&canvas->time), sizeof(canvas->time)));
+
+    bool unchanged = !canvas->redraw && hash == canvas->submitted_hash;
+    canvas->submitted_hash = hash;
+    canvas->redraw = false;
+    return unchanged;
+}
+
+// Bytes held for the frame drawn since the last clear: recorded frames, captured commands, what
+// recording contexts recorded and the pixels handed to the image atlas.
+inline uint64_t canvas_frame_bytes(const DrawingCanvas* canvas) {
+    uint64_t bytes = 0;
+    if (canvas->frame)
+        bytes += canvas->frame->memoryBytes();
+    if (canvas->capture)
+        bytes += canvas->capture->memoryBytes();
+    for (const RecordingContext* context : canvas->contexts)
+        bytes += context->commands.memoryBytes();
+    bytes += static_cast<uint64_t>(canvas->frame_pixels.tiles.size()) * ImageSurface::kTileSize * ImageSurface::kTileSize * 4;
+    for (const std::shared_ptr<const SvgRaster>& raster : canvas->frame_pixels.svgs)
+        bytes += static_cast<uint64_t>(raster->width) * raster->height * 4;
+    for (const std::shared_ptr<LayerRaster>& raster : canvas->frame_pixels.layers)
+        bytes += raster->bytes;
+    return bytes;
+}
+
+// Submits what was drawn and returns its fence, or the fence of the last submitted frame if
+// nothing changed since. `submitted` is set to whether the frame was submitted.
+inline uint64_t canvas_submit(DrawingCanvas* canvas, int submit_pass, bool* submitted) {
+    *submitted = false;
+    canvas_merge_contexts(canvas);
+    canvas->dirty.clear();
+    uint64_t frame_bytes = FrameCounters::kEnabled ? canvas_frame_bytes(canvas) : 0;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t fence = 0;
+    if (canvas_frame_unchanged(canvas)) {
+        fence = canvas->async ? canvas->async->submitted() : canvas->submitted_frames;
+    } else if (canvas->async) {
+        fence = canvas->async->submit(submit_pass);
+        canvas->frame = canvas->async->frame();
+        *submitted = true;
+    } else {
+        std::lock_guard<std::mutex> lock(render_mutex());
+        canvas->canvas.submit(submit_pass);
+        fence = ++canvas->submitted_frames;
+        *submitted = true;
+    }
+
+    double submit_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    canvas->counters.submitted(!*submitted, submit_seconds, frame_bytes);
+    for (RecordingContext* context : canvas->contexts)
+        context->commands.clear();
+    return fence;
+}
+
 extern "C"
 {
     // -- Renderer -------------------------------------------------------------------------------------
 
     void VisageRenderer_checkInitialization(void* model_window, void* display) {
+        std::lock_guard<std::mutex> lock(render_mutex());
         visage::Renderer::instance().checkInitialization(model_window, display);
     }
     bool VisageRenderer_supported() {
@@ -95,7 +4858,7 @@ extern "C"
         auto gradient = new visage::Gradient;
         return reinterpret_cast<VisageGradient*>(gradient);
     }
-    VisageGradient* VisageGradient_clone(const VisageGradient* gradient) {
+    VisageGradient* VisageGradient_copy(const VisageGradient* gradient) {
         auto clone = new visage::Gradient(*reinterpret_cast<const visage::Gradient*>(gradient));
         return reinterpret_cast<VisageGradient*>(clone);
     }
@@ -109,6 +4872,15 @@ extern "C"
         auto gradient = new visage::Gradient(visage::Gradient::fromSampleFunction(static_cast<int>(resolution), sample_function_cpp));
         return reinterpret_cast<VisageGradient*>(gradient);
     }
+    VisageGradient* VisageGradient_fromPackedARGB(const uint32_t* argb, int32_t count) {
+        size_t num_colors = static_cast<size_t>(std::max<int32_t>(count, 0));
+        std::unique_ptr<VisageColor[]> colors(new VisageColor[num_colors]);
+        unpack_argb(argb, num_colors, colors.get());
+
+        auto gradient = new visage::Gradient;
+        gradient_set_colors(gradient, colors.get(), static_cast<int>(num_colors));
+        return reinterpret_cast<VisageGradient*>(gradient);
+    }
     void VisageGradient_delete(VisageGradient* gradient) {
         delete reinterpret_cast<visage::Gradient*>(gradient);
     }
@@ -120,17 +4892,27 @@ extern "C"
         reinterpret_cast<visage::Gradient*>(gradient)->setResolution(static_cast<int>(resolution));
     }
     void VisageGradient_getColor(const VisageGradient* gradient, int32_t index, VisageColor* returnValue) {
-        auto colors = reinterpret_cast<const visage::Gradient*>(gradient)->colors();
+        const auto& colors = reinterpret_cast<const visage::Gradient*>(gradient)->colors();
         if (index < colors.size()) {
             *returnValue = color_from_cpp(colors[index]);
         }
     }
+    int32_t VisageGradient_getColors(const VisageGradient* gradient, VisageColor* colors, int32_t max_colors) {
+        const auto& colors_cpp = reinterpret_cast<const visage::Gradient*>(gradient)->colors();
+        size_t num_colors = std::min(colors_cpp.size(), static_cast<size_t>(std::max<int32_t>(max_colors, 0)));
+        for (size_t i = 0; i < num_colors; ++i)
+            colors[i] = color_from_cpp(colors_cpp[i]);
+        return static_cast<int32_t>(colors_cpp.size());
+    }
     void VisageGradient_setColor(VisageGradient* gradient, int32_t index, VisageColor color) {
         reinterpret_cast<visage::Gradient*>(gradient)->setColor(static_cast<int>(index), color_to_cpp(color));
     }
+    void VisageGradient_setColors(VisageGradient* gradient, const VisageColor* colors, int32_t count) {
+        gradient_set_colors(reinterpret_cast<visage::Gradient*>(gradient), colors, static_cast<int>(std::max<int32_t>(count, 0)));
+    }
     void VisageGradient_interpolateWith(VisageGradient* gradient, const VisageGradient* other, float t) {
-        auto b = reinterpret_cast<const visage::Gradient*>(gradient);
-        reinterpret_cast<visage::Gradient*>(gradient)->interpolateWith(*b, t);
+        auto other_cpp = reinterpret_cast<const visage::Gradient*>(other);
+        reinterpret_cast<visage::Gradient*>(gradient)->interpolateWith(*other_cpp, t);
     }
     void VisageGradient_sample(const VisageGradient* gradient, float t, VisageColor* returnValue) {
         auto color = reinterpret_cast<const visage::Gradient*>(gradient)->sample(t);
@@ -149,51 +4931,93 @@ extern "C"
     // -- Brush ----------------------------------------------------------------------------------------
 
     VisageBrush* VisageBrush_new() {
-        auto brush = new visage::Brush;
-        return reinterpret_cast<VisageBrush*>(brush);
+        auto brush = new VisageBrush_t;
+        brush_source_rehash(&brush->source);
+        return brush;
     }
-    VisageBrush* VisageBrush_clone(const VisageBrush* brush) {
-        auto clone = new visage::Brush(*reinterpret_cast<const visage::Brush*>(brush));
-        return reinterpret_cast<VisageBrush*>(clone);
+    VisageBrush* VisageBrush_copy(const VisageBrush* brush) {
+        return new VisageBrush_t(*brush);
     }
     void VisageBrush_delete(VisageBrush* brush) {
-        delete reinterpret_cast<visage::Brush*>(brush);
+        delete brush;
     }
 
     void VisageBrush_solid(VisageBrush* brush, const VisageColor color) {
-        *reinterpret_cast<visage::Brush*>(brush) = visage::Brush::solid(color_to_cpp(color));
+        auto color_cpp = color_to_cpp(color);
+        brush->brush = visage::Brush::solid(color_cpp);
+        brush->source = { kBrushSolid, gradient_from_colors({ color_cpp }) };
+        brush_source_rehash(&brush->source);
     }
     void VisageBrush_horizontal(VisageBrush* brush, const VisageGradient* gradient) {
-        *reinterpret_cast<visage::Brush*>(brush) = visage::Brush::horizontal(*reinterpret_cast<const visage::Gradient*>(gradient));
+        auto g = reinterpret_cast<const visage::Gradient*>(gradient);
+        brush->brush = visage::Brush::horizontal(*g);
+        brush->source = { kBrushHorizontal, *g };
+        brush_source_rehash(&brush->source);
     }
     void VisageBrush_horizontalFromTwo(VisageBrush* brush, VisageColor left, VisageColor right) {
-        *reinterpret_cast<visage::Brush*>(brush) = visage::Brush::horizontal(color_to_cpp(left), color_to_cpp(right));
+        auto left_cpp = color_to_cpp(left);
+        auto right_cpp = color_to_cpp(right);
+        brush->brush = visage::Brush::horizontal(left_cpp, right_cpp);
+        brush->source = { kBrushHorizontal, gradient_from_colors({ left_cpp, right_cpp }) };
+        brush_source_rehash(&brush->source);
     }
     void VisageBrush_vertical(VisageBrush* brush, const VisageGradient* gradient) {
-        *reinterpret_cast<visage::Brush*>(brush) = visage::Brush::vertical(*reinterpret_cast<const visage::Gradient*>(gradient));
+        auto g = reinterpret_cast<const visage::Gradient*>(gradient);
+        brush->brush = visage::Brush::vertical(*g);
+        brush->source = { kBrushVertical, *g };
+        brush_source_rehash(&brush->source);
     }
     void VisageBrush_verticalFromTwo(VisageBrush* brush, VisageColor top, VisageColor bottom) {
-        *reinterpret_cast<visage::Brush*>(brush) = visage::Brush::vertical(color_to_cpp(top), color_to_cpp(bottom));
+        auto top_cpp = color_to_cpp(top);
+        auto bottom_cpp = color_to_cpp(bottom);
+        brush->brush = visage::Brush::vertical(top_cpp, bottom_cpp);
+        brush->source = { kBrushVertical, gradient_from_colors({ top_cpp, bottom_cpp }) };
+        brush_source_rehash(&brush->source);
     }
     void VisageBrush_linear(VisageBrush* brush, const VisageGradient* gradient, float from_x, float from_y, float to_x, float to_y) {
         auto g = reinterpret_cast<const visage::Gradient*>(gradient);
         auto from_position = visage::Point(from_x, from_y);
         auto to_position = visage::Point(to_x, to_y);
-        *reinterpret_cast<visage::Brush*>(brush) = visage::Brush::linear(*g, from_position, to_position);
+        brush->brush = visage::Brush::linear(*g, from_position, to_position);
+        brush->source = { kBrushLinear, *g, from_x, from_y, to_x, to_y };
+        brush_source_rehash(&brush->source);
     }
     void VisageBrush_linearFromTwo(VisageBrush* brush, VisageColor from_color, VisageColor to_color, float from_x, float from_y, float to_x, float to_y) {
         auto from_color_cpp = color_to_cpp(from_color);
         auto to_color_cpp = color_to_cpp(to_color);
         auto from_position = visage::Point(from_x, from_y);
         auto to_position = visage::Point(to_x, to_y);
-        *reinterpret_cast<visage::Brush*>(brush) = visage::Brush::linear(from_color_cpp, to_color_cpp, from_position, to_position);
+        brush->brush = visage::Brush::linear(from_color_cpp, to_color_cpp, from_position, to_position);
+        brush->source = { kBrushLinear, gradient_from_colors({ from_color_cpp, to_color_cpp }), from_x, from_y, to_x, to_y };
+        brush_source_rehash(&brush->source);
     }
     void VisageBrush_interpolateWith(VisageBrush* brush, const VisageBrush* other, float t) {
-        reinterpret_cast<visage::Brush*>(brush)->interpolateWith(*reinterpret_cast<const visage::Brush*>(brush), t);
+        brush->brush.interpolateWith(other->brush, t);
+
+        BrushSource& source = brush->source;
+        source.gradient.interpolateWith(other->source.gradient, t);
+        source.from_x += (other->source.from_x - source.from_x) * t;
+        source.from_y += (other->source.from_y - source.from_y) * t;
+        source.to_x += (other->source.to_x - source.to_x) * t;
+        source.to_y += (other->source.to_y - source.to_y) * t;
+        brush_source_rehash(&source);
     }
     void VisageBrush_multiplyAlpha(VisageBrush* brush, float mult) {
-        auto b = reinterpret_cast<visage::Brush*>(brush);
-        *b = b->withMultipliedAlpha(mult);
+        brush->brush = brush->brush.withMultipliedAlpha(mult);
+        brush->source.gradient = brush->source.gradient.withMultipliedAlpha(mult);
+        brush_source_rehash(&brush->source);
+    }
+
+    // -- Brush Palette --------------------------------------------------------------------------------
+
+    int32_t VisageBrushPalette_register(const VisageBrush* brush) {
+        return BrushPalette::instance().add(*brush);
+    }
+    void VisageBrushPalette_release(int32_t id) {
+        BrushPalette::instance().release(id);
+    }
+    void VisageBrushPalette_getStats(VisageBrushPaletteStats* stats) {
+        *stats = BrushPalette::instance().stats();
     }
 
     // -- Line -----------------------------------------------------------------------------------------
@@ -256,337 +5080,1356 @@ extern "C"
         }
     }
 
+    // -- Line Pyramid ---------------------------------------------------------------------------------
+
+    VisageLinePyramid* VisageLinePyramid_new() {
+        auto pyramid = new LinePyramid;
+        return reinterpret_cast<VisageLinePyramid*>(pyramid);
+    }
+    void VisageLinePyramid_delete(VisageLinePyramid* pyramid) {
+        delete reinterpret_cast<LinePyramid*>(pyramid);
+    }
+
+    void VisageLinePyramid_setSamples(VisageLinePyramid* pyramid, const float* samples, int32_t num_samples) {
+        reinterpret_cast<LinePyramid*>(pyramid)->setSamples(samples, static_cast<int>(num_samples));
+    }
+    void VisageLinePyramid_updateSamples(VisageLinePyramid* pyramid, int32_t start, const float* samples, int32_t count) {
+        reinterpret_cast<LinePyramid*>(pyramid)->updateSamples(static_cast<int>(start), samples, static_cast<int>(count));
+    }
+    int32_t VisageLinePyramid_numSamples(const VisageLinePyramid* pyramid) {
+        return static_cast<int32_t>(reinterpret_cast<const LinePyramid*>(pyramid)->numSamples());
+    }
+    void VisageLinePyramid_setValueRange(VisageLinePyramid* pyramid, float min_value, float max_value) {
+        reinterpret_cast<LinePyramid*>(pyramid)->setValueRange(min_value, max_value);
+    }
+    VisageLine* VisageLinePyramid_layout(VisageLinePyramid* pyramid, int32_t start, int32_t count, float width, float height, float dpi_scale) {
+        auto line = reinterpret_cast<LinePyramid*>(pyramid)->layout(static_cast<int>(start), static_cast<int>(count), width,
+                                                                      height, dpi_scale);
+        return reinterpret_cast<VisageLine*>(line);
+    }
+
+    // -- Line Feed ------------------------------------------------------------------------------------
+
+    VisageLineFeed* VisageLineFeed_new(int32_t window, int32_t capacity) {
+        auto feed = new LineFeed(static_cast<int>(window), static_cast<int>(capacity));
+        return reinterpret_cast<VisageLineFeed*>(feed);
+    }
+    void VisageLineFeed_delete(VisageLineFeed* feed) {
+        delete reinterpret_cast<LineFeed*>(feed);
+    }
+
+    int32_t VisageLineFeed_push(VisageLineFeed* feed, const float* samples, int32_t count) {
+        return static_cast<int32_t>(reinterpret_cast<LineFeed*>(feed)->push(samples, static_cast<int>(count)));
+    }
+    void VisageLineFeed_setValueRange(VisageLineFeed* feed, float min_value, float max_value) {
+        reinterpret_cast<LineFeed*>(feed)->setValueRange(min_value, max_value);
+    }
+    VisageLine* VisageLineFeed_line(VisageLineFeed* feed) {
+        return reinterpret_cast<VisageLine*>(reinterpret_cast<LineFeed*>(feed)->line());
+    }
+    VisageLine* VisageLineFeed_consume(VisageLineFeed* feed, float width, float height) {
+        return reinterpret_cast<VisageLine*>(reinterpret_cast<LineFeed*>(feed)->consume(width, height));
+    }
+    void VisageLineFeed_getStats(const VisageLineFeed* feed, VisageLineFeedStats* stats) {
+        reinterpret_cast<const LineFeed*>(feed)->stats(stats);
+    }
+
+    int32_t VisageLine_setFromStrided(VisageLine* line, int32_t channel, const void* data, int32_t type, int32_t stride, int32_t count, float scale, float offset) {
+        auto line_cpp = reinterpret_cast<visage::Line*>(line);
+        int num_points = std::min(static_cast<int>(count), line_cpp->num_points);
+        if (num_points <= 0 || data == nullptr)
+            return 0;
+
+        float* dest = nullptr;
+        switch (channel) {
+            case VisageLineChannelX:
+                dest = line_cpp->x.get();
+                break;
+            case VisageLineChannelY:
+                dest = line_cpp->y.get();
+                break;
+            case VisageLineChannelValues:
+                dest = line_cpp->values.get();
+                break;
+            default:
+                return 0;
+        }
+
+        auto bytes = static_cast<const char*>(data);
+        size_t byte_stride = static_cast<size_t>(stride);
+        switch (type) {
+            case VisageSampleTypeFloat32:
+                convert_samples<float>(dest, bytes, byte_stride, num_points, scale, offset);
+                break;
+            case VisageSampleTypeFloat64:
+                convert_samples<double>(dest, bytes, byte_stride, num_points, scale, offset);
+                break;
+            case VisageSampleTypeInt16:
+                convert_samples<int16_t>(dest, bytes, byte_stride, num_points, scale, offset);
+                break;
+            case VisageSampleTypeInt32:
+                convert_samples<int32_t>(dest, bytes, byte_stride, num_points, scale, offset);
+                break;
+            default:
+                return 0;
+        }
+        return static_cast<int32_t>(num_points);
+    }
+
+    // -- Line Series ----------------------------------------------------------------------------------
+
+    VisageLineSeries* VisageLineSeries_new(int32_t num_series, int32_t points) {
+        auto series = new LineSeries(static_cast<int>(num_series), static_cast<int>(points));
+        return reinterpret_cast<VisageLineSeries*>(series);
+    }
+    void VisageLineSeries_delete(VisageLineSeries* series) {
+        delete reinterpret_cast<LineSeries*>(series);
+    }
+
+    int32_t VisageLineSeries_getNumSeries(const VisageLineSeries* series) {
+        return static_cast<int32_t>(reinterpret_cast<const LineSeries*>(series)->numSeries());
+    }
+    int32_t VisageLineSeries_getNumPoints(const VisageLineSeries* series) {
+        return static_cast<int32_t>(reinterpret_cast<const LineSeries*>(series)->numPoints());
+    }
+    void VisageLineSeries_setNumPoints(VisageLineSeries* series, int32_t points) {
+        reinterpret_cast<LineSeries*>(series)->setNumPoints(static_cast<int>(points));
+    }
+
+    float* VisageLineSeries_xValues(VisageLineSeries* series) {
+        return reinterpret_cast<LineSeries*>(series)->xValues();
+    }
+    float* VisageLineSeries_yValues(VisageLineSeries* series) {
+        return reinterpret_cast<LineSeries*>(series)->yValues();
+    }
+    float* VisageLineSeries_seriesValues(VisageLineSeries* series, int32_t index) {
+        return reinterpret_cast<LineSeries*>(series)->seriesValues(static_cast<int>(index));
+    }
+    void VisageLineSeries_setBrush(VisageLineSeries* series, int32_t index, const VisageBrush* brush) {
+        reinterpret_cast<LineSeries*>(series)->setBrush(static_cast<int>(index), brush);
+    }
+
+    // -- Image ----------------------------------------------------------------------------------------
+
+    VisageImage* VisageImage_new(const void* pixels, int32_t format, int32_t width, int32_t height, int32_t row_stride) {
+        auto image = new ImageSurface(pixels, static_cast<int>(format), static_cast<int>(width), static_cast<int>(height),
+                                      static_cast<int>(row_stride));
+        return reinterpret_cast<VisageImage*>(image);
+    }
+    void VisageImage_delete(VisageImage* image) {
+        delete reinterpret_cast<ImageSurface*>(image);
+    }
+
+    void VisageImage_setPixels(VisageImage* image, const void* pixels, int32_t row_stride) {
+        reinterpret_cast<ImageSurface*>(image)->setPixels(pixels, static_cast<int>(row_stride));
+    }
+    void VisageImage_updateRect(VisageImage* image, int32_t x, int32_t y, int32_t width, int32_t height) {
+        reinterpret_cast<ImageSurface*>(image)->updateRect(static_cast<int>(x), static_cast<int>(y), static_cast<int>(width),
+                                                           static_cast<int>(height));
+    }
+    void VisageImage_updateColumn(VisageImage* image, int32_t x) {
+        auto image_cpp = reinterpret_cast<ImageSurface*>(image);
+        image_cpp->updateRect(static_cast<int>(x), 0, 1, image_cpp->height());
+    }
+    void VisageImage_setScrollOffset(VisageImage* image, int32_t offset) {
+        reinterpret_cast<ImageSurface*>(image)->setScrollOffset(static_cast<int>(offset));
+    }
+    int32_t VisageImage_getScrollOffset(const VisageImage* image) {
+        return static_cast<int32_t>(reinterpret_cast<const ImageSurface*>(image)->scrollOffset());
+    }
+    void VisageImage_getStats(const VisageImage* image, VisageImageStats* stats) {
+        reinterpret_cast<const ImageSurface*>(image)->stats(stats);
+    }
+
+    // -- Svg ------------------------------------------------------------------------------------------
+
+    VisageSvg* VisageSvg_new(const char* data, int32_t data_size) {
+        std::string copy(data, std::max<int32_t>(data_size, 0));
+        NSVGimage* image = nsvgParse(&copy[0], "px", 96.0f);
+        if (image == nullptr)
+            return nullptr;
+
+        static std::atomic<uint64_t> next_id(1);
+        return new VisageSvg_t { next_id++, image };
+    }
+    VisageSvg* VisageSvg_fromFile(const char* path) {
+        MappedFile file(path);
+        if (file.data() == nullptr)
+            return nullptr;
+        return VisageSvg_new(file.data(), static_cast<int32_t>(file.size()));
+    }
+    void VisageSvg_delete(VisageSvg* svg) {
+        if (svg == nullptr)
+            return;
+        SvgCache::instance().remove(svg->id);
+        delete svg;
+    }
+
+    void VisageSvg_getDimensions(const VisageSvg* svg, float* width, float* height) {
+        *width = svg->image->width;
+        *height = svg->image->height;
+    }
+
+    void VisageSvgCache_setCapacity(size_t bytes) {
+        SvgCache::instance().setCapacity(bytes);
+    }
+    void VisageSvgCache_clear() {
+        SvgCache::instance().clear();
+    }
+    void VisageSvgCache_getStats(VisageSvgCacheStats* stats) {
+        *stats = SvgCache::instance().stats();
+    }
+    void VisageSvgCache_prewarm(const VisageSvg* const* svgs, const float* widths, const float* heights, int32_t count, float dpi_scale) {
+        size_t num_svgs = static_cast<size_t>(std::max<int32_t>(count, 0));
+        std::vector<SvgCache::Key> keys(num_svgs);
+        for (size_t i = 0; i < num_svgs; ++i)
+            keys[i] = SvgCache::key(svgs[i], widths[i], heights[i], dpi_scale);
+        SvgCache::instance().resolve(svgs, keys.data(), num_svgs);
+    }
+
+    // -- Layer ----------------------------------------------------------------------------------------
+
+    VisageLayer* VisageLayer_new(float width, float height) {
+        auto layer = new VisageLayer_t;
+        layer->width = std::max(width, 0.0f);
+        layer->height = std::max(height, 0.0f);
+        LayerCache::instance().add(layer);
+        return layer;
+    }
+    void VisageLayer_delete(VisageLayer* layer) {
+        LayerCache::instance().remove(layer);
+        delete layer;
+    }
+
+    void VisageLayer_invalidate(VisageLayer* layer) {
+        LayerCache::instance().invalidate(layer);
+    }
+    bool VisageLayer_isValid(const VisageLayer* layer) {
+        return layer->drawn;
+    }
+
+    void VisageLayerCache_setBudget(size_t bytes) {
+        LayerCache::instance().setBudget(bytes);
+    }
+    void VisageLayerCache_getStats(VisageLayerCacheStats* stats) {
+        *stats = LayerCache::instance().stats();
+    }
+
     // -- Font -----------------------------------------------------------------------------------------
 
     VisageFont* VisageFont_new(float size, const char* font_data, int32_t data_size, float dpi_scale) {
-        auto font = new visage::Font(size, font_data, static_cast<int>(data_size), dpi_scale);
-        return reinterpret_cast<VisageFont*>(font);
+        return new VisageFont_t { FontRegistry::instance().intern({ font_data, static_cast<int>(data_size), size, dpi_scale }) };
     }
     VisageFont* VisageFont_copy(const VisageFont* font) {
-        auto clone = new visage::Font(*reinterpret_cast<const visage::Font*>(font));
-        return reinterpret_cast<VisageFont*>(clone);
+        return new VisageFont_t(*font);
     }
     VisageFont* VisageFont_withDpiScale(const VisageFont* font, float dpi_scale) {
-        auto new_font = new visage::Font(reinterpret_cast<const visage::Font*>(font)->withDpiScale(dpi_scale));
-        return reinterpret_cast<VisageFont*>(new_font);
+        FontKey key = font->entry->key;
+        key.dpi_scale = dpi_scale;
+        return new VisageFont_t { FontRegistry::instance().intern(key) };
     }
     void VisageFont_delete(VisageFont* font) {
-        delete reinterpret_cast<visage::Font*>(font);
+        delete font;
     }
 
     float VisageFont_getDpiScale(const VisageFont* font) {
-        return reinterpret_cast<const visage::Font*>(font)->dpiScale();
+        return font->entry->font.dpiScale();
     }
 
     int32_t VisageFont_widthOverflowIndex(const VisageFont* font, const char32_t* string, int32_t string_length, float width, bool round, int32_t character_override) {
-        auto font_cpp = reinterpret_cast<const visage::Font*>(font);
         auto string_length_cpp = static_cast<int>(string_length);
         auto character_override_cpp = static_cast<int>(character_override);
+        auto measure = [&] {
+            return font->entry->font.widthOverflowIndex(string, string_length_cpp, width, round, character_override_cpp);
+        };
 
-        return font_cpp->widthOverflowIndex(string, string_length_cpp, width, round, character_override_cpp);
+        std::lock_guard<std::mutex> lock(render_mutex());
+        if (!font->entry->measure_cache)
+            return measure();
+
+        MeasureCache::Query query = { MeasureCache::kWidthOverflowIndex, string, string_length_cpp, character_override_cpp, width, round };
+        return font->entry->measure_cache->measure<int32_t>(query, measure);
     }
     int32_t VisageFont_lineBreaks(const VisageFont* font, const char32_t* string, int32_t string_length, float width, int* line_breaks, int32_t line_breaks_length) {
-        auto font_cpp = reinterpret_cast<const visage::Font*>(font);
         auto string_length_cpp = static_cast<int>(string_length);
 
-        auto result = font_cpp->lineBreaks(string, string_length_cpp, width);
+        std::unique_lock<std::mutex> lock(render_mutex());
+        auto result = font->entry->font.lineBreaks(string, string_length_cpp, width);
+        lock.unlock();
 
         auto length = std::min(result.size(), static_cast<size_t>(line_breaks_length));
 
         if (length > 0) {
-            std::memcpy(line_breaks, &(result[0]), length);
+            std::memcpy(line_breaks, &(result[0]), length * sizeof(int));
         }
 
         return result.size();
     }
+    int32_t VisageFont_lineBreaksInto(const VisageFont* font, const char32_t* string, int32_t string_length, float width, int32_t* line_breaks, int32_t line_breaks_capacity) {
+        std::lock_guard<std::mutex> lock(render_mutex());
+        return font_line_breaks(font->entry->font, string, static_cast<int>(string_length), width, line_breaks, std::max(line_breaks_capacity, 0));
+    }
+    int32_t VisageFont_lineBreaksBatch(const VisageFont* font, const char32_t* const* strings, const int32_t* string_lengths, const float* widths, int32_t num_strings, int32_t* line_breaks, int32_t line_breaks_capacity, int32_t* break_counts) {
+        int32_t total = 0;
+
+        std::lock_guard<std::mutex> lock(render_mutex());
+        for (int32_t i = 0; i < num_strings; ++i) {
+            int32_t capacity = std::max(line_breaks_capacity - total, 0);
+            int32_t* output = capacity > 0 ? line_breaks + total : nullptr;
+
+            break_counts[i] = font_line_breaks(font->entry->font, strings[i], static_cast<int>(string_lengths[i]), widths[i], output, capacity);
+            total += break_counts[i];
+        }
+        return total;
+    }
     float VisageFont_stringWidth(const VisageFont* font, const char32_t* string, int32_t string_length, int32_t character_override) {
-        auto font_cpp = reinterpret_cast<const visage::Font*>(font);
-        auto string_length_cpp = static_cast<int>(string_length);
+        std::lock_guard<std::mutex> lock(render_mutex());
+        return font_string_width(font, string, static_cast<int>(string_length), static_cast<int>(character_override));
+    }
+    void VisageFont_stringWidths(const VisageFont* font, const char32_t* const* strings, const int32_t* string_lengths, int32_t num_strings, int32_t character_override, float* widths) {
         auto character_override_cpp = static_cast<int>(character_override);
 
-        return font_cpp->stringWidth(string, string_length_cpp, character_override_cpp);
+        std::lock_guard<std::mutex> lock(render_mutex());
+        for (int32_t i = 0; i < num_strings; ++i)
+            widths[i] = font_string_width(font, strings[i], static_cast<int>(string_lengths[i]), character_override_cpp);
     }
     float VisageFont_lineHeight(const VisageFont* font) {
-        return reinterpret_cast<const visage::Font*>(font)->lineHeight();
+        return font->entry->font.lineHeight();
     }
     float VisageFont_capitalHeight(const VisageFont* font) {
-        return reinterpret_cast<const visage::Font*>(font)->capitalHeight();
+        return font->entry->font.capitalHeight();
     }
     float VisageFont_lowerDipHeight(const VisageFont* font) {
-        return reinterpret_cast<const visage::Font*>(font)->lowerDipHeight();
+        return font->entry->font.lowerDipHeight();
     }
     float VisageFont_size(const VisageFont* font) {
-        return reinterpret_cast<const visage::Font*>(font)->size();
+        return font->entry->font.size();
     }
     const char* VisageFont_fontData(const VisageFont* font, int32_t* data_size) {
-        auto font_cpp = reinterpret_cast<const visage::Font*>(font);
-        *data_size = font_cpp->dataSize();
-        return font_cpp->fontData();
+        *data_size = font->entry->font.dataSize();
+        return font->entry->font.fontData();
+    }
+
+    void VisageFont_setMeasureCacheCapacity(VisageFont* font, int32_t capacity) {
+        if (capacity <= 0)
+            font->entry->measure_cache.reset();
+        else if (font->entry->measure_cache)
+            font->entry->measure_cache->setCapacity(static_cast<size_t>(capacity));
+        else
+            font->entry->measure_cache = std::make_shared<MeasureCache>(static_cast<size_t>(capacity));
+    }
+    void VisageFont_clearMeasureCache(VisageFont* font) {
+        if (font->entry->measure_cache)
+            font->entry->measure_cache->clear();
+    }
+    void VisageFont_getMeasureCacheStats(const VisageFont* font, VisageMeasureCacheStats* stats) {
+        *stats = {};
+        if (font->entry->measure_cache) {
+            stats->hits = font->entry->measure_cache->hits();
+            stats->misses = font->entry->measure_cache->misses();
+            stats->entries = static_cast<int32_t>(font->entry->measure_cache->size());
+            stats->capacity = static_cast<int32_t>(font->entry->measure_cache->capacity());
+        }
     }
 
     VisageFont* VisageFont_LatoRegular(float size, float dpi_scale) {
-        auto font = new visage::Font(size, visage::fonts::Lato_Regular_ttf);
-        return reinterpret_cast<VisageFont*>(font);
+        return new VisageFont_t { FontRegistry::instance().intern(visage::fonts::Lato_Regular_ttf, size, dpi_scale) };
     }
     VisageFont* VisageFont_DroidSansMono(float size, float dpi_scale) {
-        auto font = new visage::Font(size, visage::fonts::DroidSansMono_ttf);
-        return reinterpret_cast<VisageFont*>(font);
+        return new VisageFont_t { FontRegistry::instance().intern(visage::fonts::DroidSansMono_ttf, size, dpi_scale) };
     }
     VisageFont* VisageFont_TwemojiMozilla(float size, float dpi_scale) {
-        auto font = new visage::Font(size, visage::fonts::Twemoji_Mozilla_ttf);
-        return reinterpret_cast<VisageFont*>(font);
+        return new VisageFont_t { FontRegistry::instance().intern(visage::fonts::Twemoji_Mozilla_ttf, size, dpi_scale) };
+    }
+
+    void VisageFont_prewarm(const VisageFont* font, const char32_t* codepoints, int32_t count) {
+        {
+            std::lock_guard<std::mutex> lock(render_mutex());
+            prewarm_glyphs(font->entry->font, codepoints, static_cast<int>(count));
+        }
+        mark_used_glyphs(font->entry.get(), codepoints, static_cast<size_t>(std::max(count, 0)));
+    }
+    void VisageFont_prewarmPreset(const VisageFont* font, uint32_t presets) {
+        std::u32string codepoints = glyph_preset_codepoints(presets);
+        {
+            std::lock_guard<std::mutex> lock(render_mutex());
+            prewarm_glyphs(font->entry->font, codepoints.data(), static_cast<int>(codepoints.size()));
+        }
+        mark_used_glyphs(font->entry.get(), codepoints.data(), codepoints.size());
+    }
+    void VisageFont_prewarmFonts(const VisageFont* const* fonts, int32_t num_fonts, const char32_t* codepoints, int32_t count, uint32_t presets) {
+        std::u32string all_codepoints = glyph_preset_codepoints(presets);
+        all_codepoints.append(codepoints, std::max(count, 0));
+
+        // Fonts with the same data and pixel size share an atlas in visage, only one of them is
+        // warmed so no atlas is touched by two threads.
+        std::vector<const visage::Font*> atlas_fonts;
+        std::vector<std::pair<const char*, float>> atlas_keys;
+        for (int32_t i = 0; i < num_fonts; ++i) {
+            std::pair<const char*, float> atlas_key = font_atlas_key(fonts[i]->entry->key);
+            if (std::find(atlas_keys.begin(), atlas_keys.end(), atlas_key) == atlas_keys.end()) {
+                atlas_keys.push_back(atlas_key);
+                atlas_fonts.push_back(&fonts[i]->entry->font);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(render_mutex());
+            parallel_for(atlas_fonts.size(), [&](size_t i) {
+                prewarm_glyphs(*atlas_fonts[i], all_codepoints.data(), static_cast<int>(all_codepoints.size()));
+            });
+        }
+
+        for (int32_t i = 0; i < num_fonts; ++i)
+            mark_used_glyphs(fonts[i]->entry.get(), all_codepoints.data(), all_codepoints.size());
+    }
+
+    void VisageFontRegistry_getStats(VisageFontRegistryStats* stats) {
+        *stats = FontRegistry::instance().stats();
+    }
+
+    // -- Glyph Cache ----------------------------------------------------------------------------------
+
+    void VisageGlyphCache_setDirectory(const char* directory) {
+        GlyphCache::instance().setDirectory(directory);
+    }
+    int32_t VisageGlyphCache_prewarm(const VisageFont* const* fonts, int32_t num_fonts) {
+        GlyphCache& cache = GlyphCache::instance();
+        if (!cache.enabled())
+            return 0;
+
+        struct CachedFont {
+            FontEntry* entry;
+            std::unique_ptr<MappedFile> file;
+        };
+
+        std::vector<CachedFont> cached_fonts;
+        for (int32_t i = 0; i < num_fonts; ++i) {
+            FontEntry* entry = fonts[i]->entry.get();
+            bool duplicate = std::any_of(cached_fonts.begin(), cached_fonts.end(), [&](const CachedFont& cached) {
+                return font_atlas_key(cached.entry->key) == font_atlas_key(entry->key);
+            });
+            if (duplicate)
+                continue;
+
+            auto file = std::make_unique<MappedFile>(cache.path(entry));
+            if (file->size() < sizeof(GlyphCacheHeader))
+                continue;
+
+            auto header = reinterpret_cast<const GlyphCacheHeader*>(file->data());
+            size_t max_codepoints = (file->size() - sizeof(GlyphCacheHeader)) / sizeof(uint32_t);
+            if (header->magic != kGlyphCacheMagic || header->version != kGlyphCacheVersion ||
+                header->font_hash != cache.fontHash(entry) || header->num_codepoints > max_codepoints) {
+                continue;
+            }
+
+            cached_fonts.push_back({ entry, std::move(file) });
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(render_mutex());
+            parallel_for(cached_fonts.size(), [&](size_t i) {
+                auto header = reinterpret_cast<const GlyphCacheHeader*>(cached_fonts[i].file->data());
+                auto codepoints = reinterpret_cast<const char32_t*>(header + 1);
+                prewarm_glyphs(cached_fonts[i].entry->font, codepoints, static_cast<int>(header->num_codepoints));
+            });
+        }
+
+        for (const CachedFont& cached : cached_fonts) {
+            auto header = reinterpret_cast<const GlyphCacheHeader*>(cached.file->data());
+            mark_used_glyphs(cached.entry, reinterpret_cast<const char32_t*>(header + 1), header->num_codepoints);
+        }
+        return static_cast<int32_t>(cached_fonts.size());
+    }
+    bool VisageGlyphCache_save() {
+        if (!GlyphCache::instance().enabled())
+            return false;
+
+        bool saved = true;
+        for (const std::shared_ptr<FontEntry>& entry : FontRegistry::instance().liveFonts())
+            saved = save_glyph_cache(entry.get()) && saved;
+        return saved;
     }
 
     // -- Text -----------------------------------------------------------------------------------------
 
     VisageText* VisageText_new(const VisageFont* font) {
-        auto text = new visage::Text;
-        text->setFont(*reinterpret_cast<const visage::Font*>(font));
-        return reinterpret_cast<VisageText*>(text);
+        return new VisageText_t(*font);
     }
     VisageText* VisageText_copy(const VisageText* text) {
-        auto clone = new visage::Text(*reinterpret_cast<const visage::Text*>(text));
-        return reinterpret_cast<VisageText*>(clone);
+        return new VisageText_t(*text);
     }
     void VisageText_delete(VisageText* text) {
-        delete reinterpret_cast<visage::Text*>(text);
+        delete text;
     }
 
     void VisageText_setText(VisageText* text, const char* s) {
-        visage::String cpp_str = visage::String(s);
-        reinterpret_cast<visage::Text*>(text)->setText(cpp_str);
+        text_set_utf8(text, s, std::strlen(s));
     }
     void VisageText_setTextWithLength(VisageText* text, const char* s, int32_t length) {
-        std::string cpp_str = std::string(s, length);
-        reinterpret_cast<visage::Text*>(text)->setText(cpp_str);
+        text_set_utf8(text, s, static_cast<size_t>(std::max(length, 0)));
+    }
+    bool VisageText_setTextIfChanged(VisageText* text, const char* s, int32_t length) {
+        auto size = static_cast<size_t>(std::max(length, 0));
+        if (text->has_utf8 && text->utf8.size() == size && (size == 0 || std::memcmp(text->utf8.data(), s, size) == 0))
+            return false;
+
+        text_set_utf8(text, s, size);
+        return true;
     }
     void VisageText_setTextU32(VisageText* text, const char32_t* s) {
         visage::String cpp_str = visage::String(s);
-        reinterpret_cast<visage::Text*>(text)->setText(cpp_str);
+        text->text.setText(cpp_str);
+        text->has_utf8 = false;
+        mark_used_glyphs(text->font.entry.get(), cpp_str.c_str(), cpp_str.length());
     }
     void VisageText_setTextU32WithLength(VisageText* text, const char32_t* s, int32_t length) {
         std::u32string cpp_str = std::u32string(s, length);
-        reinterpret_cast<visage::Text*>(text)->setText(cpp_str);
+        text->text.setText(cpp_str);
+        text->has_utf8 = false;
+        mark_used_glyphs(text->font.entry.get(), cpp_str.data(), cpp_str.size());
     }
     const char32_t* VisageText_getTextU32(const VisageText* text, int32_t* length) {
-        auto text_cpp = reinterpret_cast<const visage::Text*>(text);
-        auto s = &(text_cpp->text());
+        auto s = &(text->text.text());
         *length = s->length();
         return s->c_str();
     }
 
     void VisageText_setFont(VisageText* text, const VisageFont* font) {
-        reinterpret_cast<visage::Text*>(text)->setFont(*reinterpret_cast<const visage::Font*>(font));
+        text->text.setFont(font->entry->font);
+        text->font = *font;
+
+        const visage::String& string = text->text.text();
+        mark_used_glyphs(font->entry.get(), string.c_str(), string.length());
     }
     const VisageFont* VisageText_getFont(const VisageText* text) {
-        return reinterpret_cast<const VisageFont*>(&(reinterpret_cast<const visage::Text*>(text)->font()));
+        return &text->font;
     }
 
     void VisageText_setJustification(VisageText* text, uint32_t justification) {
-        reinterpret_cast<visage::Text*>(text)->setJustification(static_cast<visage::Font::Justification>(justification));
+        text->text.setJustification(static_cast<visage::Font::Justification>(justification));
     }
     uint32_t VisageText_getJustification(const VisageText* text) {
-        return static_cast<uint32_t>(reinterpret_cast<const visage::Text*>(text)->justification());
+        return static_cast<uint32_t>(text->text.justification());
     }
 
     void VisageText_setMultiLine(VisageText* text, bool multi_line) {
-        reinterpret_cast<visage::Text*>(text)->setMultiLine(multi_line);
+        text->text.setMultiLine(multi_line);
     }
     bool VisageText_getMultiLine(const VisageText* text) {
-        return reinterpret_cast<const visage::Text*>(text)->multiLine();
+        return text->text.multiLine();
     }
 
     void VisageText_setCharacterOverride(VisageText* text, int32_t character) {
-        reinterpret_cast<visage::Text*>(text)->setCharacterOverride(static_cast<int>(character));
+        text->text.setCharacterOverride(static_cast<int>(character));
     }
     int32_t VisageText_getCharacterOverride(const VisageText* text) {
-        return static_cast<int32_t>(reinterpret_cast<const visage::Text*>(text)->characterOverride());
+        return static_cast<int32_t>(text->text.characterOverride());
     }
 
     // -- Canvas ---------------------------------------------------------------------------------------
 
     VisageCanvas* VisageCanvas_new() {
-        auto canvas = new visage::Canvas;
-        return reinterpret_cast<VisageCanvas*>(canvas);
+        auto canvas = new DrawingCanvas;
+        if (VISAGE_C_BACKGROUND_GRAPHICS_THREAD)
+            VisageCanvas_setAsyncSubmit(canvas, true);
+        return canvas;
+    }
+    void VisageCanvas_destroy(VisageCanvas* handle) {
+        if (RecordingContext* context = as_recording_context(handle)) {
+            if (context->parent) {
+                std::vector<RecordingContext*>& siblings = context->parent->contexts;
+                siblings.erase(std::find(siblings.begin(), siblings.end(), context));
+            }
+            delete context;
+            return;
+        }
+
+        DrawingCanvas* canvas = drawing_canvas_of(handle);
+        for (RecordingContext* context : canvas->contexts)
+            context->parent = nullptr;
+        delete canvas;
+    }
+
+    VisageCanvas* VisageCanvas_newRecordingContext(VisageCanvas* parent, int32_t order) {
+        // Contexts of contexts are drawn into the canvas their parent is drawn into.
+        DrawingCanvas* canvas = as_drawing_canvas(parent);
+        if (RecordingContext* parent_context = as_recording_context(parent))
+            canvas = parent_context->parent;
+
+        auto context = new RecordingContext;
+        context->is_context = true;
+        context->recording = &context->commands;
+        context->parent = canvas;
+        context->order = order;
+        if (canvas) {
+            auto position = std::upper_bound(canvas->contexts.begin(), canvas->contexts.end(), order,
+                                             [](int32_t order, const RecordingContext* other) { return order < other->order; });
+            canvas->contexts.insert(position, context);
+        }
+        return context;
     }
-    void VisageCanvas_destroy(VisageCanvas* canvas) {
-        delete reinterpret_cast<visage::Canvas*>(canvas);
+    void VisageCanvas_setRecordingBounds(VisageCanvas* handle, float x, float y, float width, float height) {
+        if (RecordingContext* context = as_recording_context(handle))
+            context->bounds = { x, y, width, height };
     }
 
-    void VisageCanvas_pairToWindow(VisageCanvas* canvas, void* window_handle, int32_t width, int32_t height) {
-        reinterpret_cast<visage::Canvas*>(canvas)->pairToWindow(window_handle, static_cast<int>(width), static_cast<int>(height));
+    void VisageCanvas_pairToWindow(VisageCanvas* handle, void* window_handle, int32_t width, int32_t height) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            auto lock = lock_visage_canvas(canvas);
+            canvas->canvas.pairToWindow(window_handle, static_cast<int>(width), static_cast<int>(height));
+            canvas->redraw = true;
+            canvas->width = width;
+            canvas->height = height;
+        }
     }
-    void VisageCanvas_setDimensions(VisageCanvas* canvas, int32_t width, int32_t height) {
-        reinterpret_cast<visage::Canvas*>(canvas)->setDimensions(static_cast<int>(width), static_cast<int>(height));
+    void VisageCanvas_setDimensions(VisageCanvas* handle, int32_t width, int32_t height) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            auto lock = lock_visage_canvas(canvas);
+            canvas->canvas.setDimensions(static_cast<int>(width), static_cast<int>(height));
+            canvas->width = width;
+            canvas->height = height;
+        }
+    }
+    void VisageCanvas_setDpiScale(VisageCanvas* handle, float scale) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            auto lock = lock_visage_canvas(canvas);
+            canvas->canvas.setDpiScale(scale);
+        }
     }
-    void VisageCanvas_setDpiScale(VisageCanvas* canvas, float scale) {
-        reinterpret_cast<visage::Canvas*>(canvas)->setDpiScale(scale);
+    void VisageCanvas_setNativePixelScale(VisageCanvas* handle) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            auto lock = lock_visage_canvas(canvas);
+            canvas->canvas.setNativePixelScale();
+            canvas->redraw = true;
+        }
     }
-    void VisageCanvas_setNativePixelScale(VisageCanvas* canvas) {
-        reinterpret_cast<visage::Canvas*>(canvas)->setNativePixelScale();
+    void VisageCanvas_setLogicalPixelScale(VisageCanvas* handle) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            auto lock = lock_visage_canvas(canvas);
+            canvas->canvas.setLogicalPixelScale();
+            canvas->redraw = true;
+        }
     }
-    void VisageCanvas_setLogicalPixelScale(VisageCanvas* canvas) {
-        reinterpret_cast<visage::Canvas*>(canvas)->setLogicalPixelScale();
+    void VisageCanvas_clearDrawnShapes(VisageCanvas* handle) {
+        if (RecordingContext* context = as_recording_context(handle)) {
+            context->commands.clear();
+            return;
+        }
+
+        DrawingCanvas* canvas = drawing_canvas_of(handle);
+        if (canvas->frame)
+            canvas->frame->clear();
+        else
+            canvas->canvas.clearDrawnShapes();
+        canvas->stream_storage.clear();
+        canvas->frame_lines.clear();
+        canvas->position.reset();
+        canvas->frame_hash = 0;
+        canvas->counters.reset();
+        std::swap(canvas->previous_frame_pixels, canvas->frame_pixels);
+        canvas->frame_pixels.clear();
+        if (canvas->capture)
+            canvas->capture->clear();
+    }
+    bool VisageCanvas_submit(VisageCanvas* handle, int32_t submit_pass) {
+        DrawingCanvas* canvas = as_drawing_canvas(handle);
+        bool submitted = false;
+        if (canvas)
+            canvas_submit(canvas, static_cast<int>(submit_pass), &submitted);
+        return submitted;
+    }
+    uint64_t VisageCanvas_submitAsync(VisageCanvas* handle, int32_t submit_pass) {
+        DrawingCanvas* canvas = as_drawing_canvas(handle);
+        bool submitted = false;
+        return canvas ? canvas_submit(canvas, static_cast<int>(submit_pass), &submitted) : 0;
     }
-    void VisageCanvas_clearDrawnShapes(VisageCanvas* canvas) {
-        reinterpret_cast<visage::Canvas*>(canvas)->clearDrawnShapes();
+
+    void VisageCanvas_setAsyncSubmit(VisageCanvas* handle, bool enabled) {
+        DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas == nullptr || enabled == (canvas->async != nullptr))
+            return;
+
+        canvas->redraw = true;
+        if (enabled) {
+            canvas->async = std::make_unique<AsyncSubmitter>(&canvas->canvas, canvas->submitted_frames);
+            canvas->async->setFramesInFlight(canvas->frames_in_flight);
+            canvas->frame = canvas->async->frame();
+        } else {
+            canvas->submitted_frames = canvas->async->submitted();
+            canvas->frame = nullptr;
+            canvas->async.reset();
+        }
     }
-    void VisageCanvas_submit(VisageCanvas* canvas, int32_t submit_pass) {
-        reinterpret_cast<visage::Canvas*>(canvas)->submit(static_cast<int>(submit_pass));
+    bool VisageCanvas_isAsyncSubmit(const VisageCanvas* handle) {
+        const DrawingCanvas* canvas = as_drawing_canvas(handle);
+        return canvas && canvas->async != nullptr;
     }
-    void VisageCanvas_updateTime(VisageCanvas* canvas, double time) {
-        reinterpret_cast<visage::Canvas*>(canvas)->updateTime(time);
+    void VisageCanvas_setFramesInFlight(VisageCanvas* handle, int32_t frames) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            canvas->frames_in_flight = std::max(frames, 1);
+            if (canvas->async)
+                canvas->async->setFramesInFlight(canvas->frames_in_flight);
+        }
     }
-    void VisageCanvas_setWindowless(VisageCanvas* canvas, int32_t width, int32_t height) {
-        reinterpret_cast<visage::Canvas*>(canvas)->setWindowless(static_cast<int>(width), static_cast<int>(height));
+    bool VisageCanvas_isFenceComplete(VisageCanvas* handle, uint64_t fence) {
+        DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas == nullptr)
+            return true;
+        return canvas->async ? canvas->async->complete(fence) : fence <= canvas->submitted_frames;
     }
-    void VisageCanvas_removeFromWindow(VisageCanvas* canvas) {
-        reinterpret_cast<visage::Canvas*>(canvas)->removeFromWindow();
+    void VisageCanvas_waitForFence(VisageCanvas* handle, uint64_t fence) {
+        DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas && canvas->async)
+            canvas->async->wait(fence);
     }
-    void VisageCanvas_requestScreenshot(VisageCanvas* canvas) {
-        reinterpret_cast<visage::Canvas*>(canvas)->requestScreenshot();
+    void VisageCanvas_waitForIdle(VisageCanvas* handle) {
+        DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas && canvas->async)
+            canvas->async->wait(UINT64_MAX);
     }
 
-    float VisageCanvas_dpiScale(VisageCanvas* canvas) {
-        return reinterpret_cast<visage::Canvas*>(canvas)->dpiScale();
+    void VisageCanvas_setIdleFrameElision(VisageCanvas* handle, bool enabled) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            // The frame being drawn was only partly hashed, if at all.
+            if (enabled != canvas->idle_elision)
+                canvas->redraw = true;
+            canvas->idle_elision = enabled;
+        }
+    }
+    void VisageCanvas_setTimeDependent(VisageCanvas* handle, bool time_dependent) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle))
+            canvas->time_dependent = time_dependent;
+    }
+    void VisageCanvas_requestRedraw(VisageCanvas* handle) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle))
+            canvas->redraw = true;
     }
-    double VisageCanvas_time(VisageCanvas* canvas) {
-        return reinterpret_cast<visage::Canvas*>(canvas)->time();
+
+    void VisageCanvas_getFrameStats(const VisageCanvas* handle, VisageFrameStats* stats) {
+        if (const DrawingCanvas* canvas = as_drawing_canvas(handle))
+            canvas->counters.stats(stats, canvas->async.get());
+        else
+            *stats = {};
+    }
+
+    void VisageCanvas_updateTime(VisageCanvas* handle, double time) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            auto lock = lock_visage_canvas(canvas);
+            canvas->canvas.updateTime(time);
+            canvas->time = time;
+        }
+    }
+    void VisageCanvas_setWindowless(VisageCanvas* handle, int32_t width, int32_t height) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            auto lock = lock_visage_canvas(canvas);
+            canvas->canvas.setWindowless(static_cast<int>(width), static_cast<int>(height));
+            canvas->redraw = true;
+            canvas->width = width;
+            canvas->height = height;
+        }
+    }
+    void VisageCanvas_removeFromWindow(VisageCanvas* handle) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            auto lock = lock_visage_canvas(canvas);
+            canvas->canvas.removeFromWindow();
+            canvas->redraw = true;
+        }
     }
-    double VisageCanvas_deltaTime(VisageCanvas* canvas) {
-        return reinterpret_cast<visage::Canvas*>(canvas)->deltaTime();
+    void VisageCanvas_requestScreenshot(VisageCanvas* handle) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle)) {
+            auto lock = lock_visage_canvas(canvas);
+            canvas->canvas.requestScreenshot();
+            canvas->redraw = true;
+        }
     }
-    int32_t VisageCanvas_frameCount(VisageCanvas* canvas) {
-        return static_cast<int32_t>(reinterpret_cast<visage::Canvas*>(canvas)->frameCount());
+
+    float VisageCanvas_dpiScale(VisageCanvas* canvas) {
+        return canvas_dpi_scale(canvas);
+    }
+    double VisageCanvas_time(VisageCanvas* handle) {
+        DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas == nullptr)
+            return 0.0;
+        auto lock = lock_visage_canvas(canvas);
+        return canvas->canvas.time();
+    }
+    double VisageCanvas_deltaTime(VisageCanvas* handle) {
+        DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas == nullptr)
+            return 0.0;
+        auto lock = lock_visage_canvas(canvas);
+        return canvas->canvas.deltaTime();
+    }
+    int32_t VisageCanvas_frameCount(VisageCanvas* handle) {
+        DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas == nullptr)
+            return 0;
+        auto lock = lock_visage_canvas(canvas);
+        return static_cast<int32_t>(canvas->canvas.frameCount());
     }
 
     void VisageCanvas_setColor(VisageCanvas* canvas, VisageColor color) {
-        reinterpret_cast<visage::Canvas*>(canvas)->setColor(color_to_cpp(color));
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_set_color(canvas, color_to_cpp(color));
     }
     void VisageCanvas_setBrush(VisageCanvas* canvas, const VisageBrush* brush) {
-        reinterpret_cast<visage::Canvas*>(canvas)->setBrush(*reinterpret_cast<const visage::Brush*>(brush));
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_set_brush(canvas, *brush);
+    }
+    void VisageCanvas_setBrushId(VisageCanvas* canvas, int32_t id) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        if (const VisageBrush_t* brush = BrushPalette::instance().get(id))
+            canvas_set_brush(canvas, *brush);
     }
 
     void VisageCanvas_fill(VisageCanvas* canvas, float x, float y, float width, float height) {
-        reinterpret_cast<visage::Canvas*>(canvas)->fill(x, y, width, height);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandFill, 0, { x, y, width, height } });
     }
     void VisageCanvas_circle(VisageCanvas* canvas, float x, float y, float width) {
-        reinterpret_cast<visage::Canvas*>(canvas)->circle(x, y, width);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandCircle, 0, { x, y, width } });
     }
     void VisageCanvas_fadeCircle(VisageCanvas* canvas, float x, float y, float width, float pixel_width) {
-        reinterpret_cast<visage::Canvas*>(canvas)->fadeCircle(x, y, width, pixel_width);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandFadeCircle, 0, { x, y, width, pixel_width } });
     }
     void VisageCanvas_ring(VisageCanvas* canvas, float x, float y, float width, float thickness) {
-        reinterpret_cast<visage::Canvas*>(canvas)->ring(x, y, width, thickness);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRing, 0, { x, y, width, thickness } });
     }
     void VisageCanvas_squircle(VisageCanvas* canvas, float x, float y, float width, float power) {
-        reinterpret_cast<visage::Canvas*>(canvas)->squircle(x, y, width, power);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandSquircle, 0, { x, y, width, power } });
     }
     void VisageCanvas_squircleBorder(VisageCanvas* canvas, float x, float y, float width, float power, float thickness) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
         // TODO: uncomment this once this method is fixed in Visage
-        //reinterpret_cast<visage::Canvas*>(canvas)->squircleBorder(x, y, width, power, thickness);
+        //canvas->canvas.squircleBorder(x, y, width, power, thickness);
     }
     void VisageCanvas_superEllipse(VisageCanvas* canvas, float x, float y, float width, float height, float power) {
-        reinterpret_cast<visage::Canvas*>(canvas)->superEllipse(x, y, width, height, power);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandSuperEllipse, 0, { x, y, width, height, power } });
     }
     void VisageCanvas_roundedArc(VisageCanvas* canvas, float x, float y, float width, float thickness, float center_radians, float radians) {
-        reinterpret_cast<visage::Canvas*>(canvas)->roundedArc(x, y, width, thickness, center_radians, radians);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandArc, VISAGE_SHAPE_COMMAND_ROUNDED, { x, y, width, thickness, center_radians, radians } });
     }
     void VisageCanvas_flatArc(VisageCanvas* canvas, float x, float y, float width, float thickness, float center_radians, float radians) {
-        reinterpret_cast<visage::Canvas*>(canvas)->flatArc(x, y, width, thickness, center_radians, radians);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandArc, 0, { x, y, width, thickness, center_radians, radians } });
     }
     void VisageCanvas_arc(VisageCanvas* canvas, float x, float y, float width, float thickness, float center_radians, float radians, bool rounded) {
-        reinterpret_cast<visage::Canvas*>(canvas)->arc(x, y, width, thickness, center_radians, radians, rounded);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        uint32_t flags = rounded ? VISAGE_SHAPE_COMMAND_ROUNDED : 0;
+        canvas_draw(canvas, { VisageShapeCommandArc, flags, { x, y, width, thickness, center_radians, radians } });
     }
     void VisageCanvas_roundedArcShadow(VisageCanvas* canvas, float x, float y, float width, float thickness, float center_radians, float radians, float shadow_width) {
-        reinterpret_cast<visage::Canvas*>(canvas)->roundedArcShadow(x, y, width, thickness, center_radians, radians, shadow_width);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandArcShadow, VISAGE_SHAPE_COMMAND_ROUNDED, { x, y, width, thickness, center_radians, radians, shadow_width } });
     }
     void VisageCanvas_flatArcShadow(VisageCanvas* canvas, float x, float y, float width, float thickness, float center_radians, float radians, float shadow_width) {
-        reinterpret_cast<visage::Canvas*>(canvas)->flatArcShadow(x, y, width, thickness, center_radians, radians, shadow_width);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandArcShadow, 0, { x, y, width, thickness, center_radians, radians, shadow_width } });
     }
     void VisageCanvas_segment(VisageCanvas* canvas, float a_x, float a_y, float b_x, float b_y, float thickness, bool rounded) {
-        reinterpret_cast<visage::Canvas*>(canvas)->segment(a_x, a_y, b_x, b_y, thickness, rounded);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        uint32_t flags = rounded ? VISAGE_SHAPE_COMMAND_ROUNDED : 0;
+        canvas_draw(canvas, { VisageShapeCommandSegment, flags, { a_x, a_y, b_x, b_y, thickness } });
     }
     void VisageCanvas_quadratic(VisageCanvas* canvas, float a_x, float a_y, float b_x, float b_y, float c_x, float c_y, float thickness) {
-        reinterpret_cast<visage::Canvas*>(canvas)->quadratic(a_x, a_y, b_x, b_y, c_x, c_y, thickness);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandQuadratic, 0, { a_x, a_y, b_x, b_y, c_x, c_y, thickness } });
     }
     void VisageCanvas_rectangle(VisageCanvas* canvas, float x, float y, float width, float height) {
-        reinterpret_cast<visage::Canvas*>(canvas)->rectangle(x, y, width, height);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRectangle, 0, { x, y, width, height } });
     }
     void VisageCanvas_rectangleBorder(VisageCanvas* canvas, float x, float y, float width, float height, float thickness) {
-        reinterpret_cast<visage::Canvas*>(canvas)->rectangleBorder(x, y, width, height, thickness);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRectangleBorder, 0, { x, y, width, height, thickness } });
     }
     void VisageCanvas_roundedRectangle(VisageCanvas* canvas, float x, float y, float width, float height, float rounding) {
-        reinterpret_cast<visage::Canvas*>(canvas)->roundedRectangle(x, y, width, height, rounding);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRoundedRectangle, 0, { x, y, width, height, rounding } });
+    }
+    void VisageCanvas_circles(VisageCanvas* canvas, const float* x, const float* y, const float* width, const uint32_t* argb, int32_t count) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw_instances(canvas, argb, count, [&](int32_t i) {
+            return VisageShapeCommand { VisageShapeCommandCircle, 0, { x[i], y[i], width[i] } };
+        });
+    }
+    void VisageCanvas_rectangles(VisageCanvas* canvas, const float* x, const float* y, const float* width, const float* height, const uint32_t* argb, int32_t count) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw_instances(canvas, argb, count, [&](int32_t i) {
+            return VisageShapeCommand { VisageShapeCommandRectangle, 0, { x[i], y[i], width[i], height[i] } };
+        });
+    }
+    void VisageCanvas_roundedRectangles(VisageCanvas* canvas, const float* x, const float* y, const float* width, const float* height, float rounding, const uint32_t* argb, int32_t count) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw_instances(canvas, argb, count, [&](int32_t i) {
+            return VisageShapeCommand { VisageShapeCommandRoundedRectangle, 0, { x[i], y[i], width[i], height[i], rounding } };
+        });
     }
     void VisageCanvas_diamond(VisageCanvas* canvas, float x, float y, float width, float rounding) {
-        reinterpret_cast<visage::Canvas*>(canvas)->diamond(x, y, width, rounding);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandDiamond, 0, { x, y, width, rounding } });
     }
     void VisageCanvas_leftRoundedRectangle(VisageCanvas* canvas, float x, float y, float width, float height, float rounding) {
-        reinterpret_cast<visage::Canvas*>(canvas)->leftRoundedRectangle(x, y, width, height, rounding);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandLeftRoundedRectangle, 0, { x, y, width, height, rounding } });
     }
     void VisageCanvas_rightRoundedRectangle(VisageCanvas* canvas, float x, float y, float width, float height, float rounding) {
-        reinterpret_cast<visage::Canvas*>(canvas)->rightRoundedRectangle(x, y, width, height, rounding);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRightRoundedRectangle, 0, { x, y, width, height, rounding } });
     }
     void VisageCanvas_topRoundedRectangle(VisageCanvas* canvas, float x, float y, float width, float height, float rounding) {
-        reinterpret_cast<visage::Canvas*>(canvas)->topRoundedRectangle(x, y, width, height, rounding);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandTopRoundedRectangle, 0, { x, y, width, height, rounding } });
     }
     void VisageCanvas_bottomRoundedRectangle(VisageCanvas* canvas, float x, float y, float width, float height, float rounding) {
-        reinterpret_cast<visage::Canvas*>(canvas)->bottomRoundedRectangle(x, y, width, height, rounding);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandBottomRoundedRectangle, 0, { x, y, width, height, rounding } });
     }
     void VisageCanvas_rectangleShadow(VisageCanvas* canvas, float x, float y, float width, float height, float blur_radius) {
-        reinterpret_cast<visage::Canvas*>(canvas)->rectangleShadow(x, y, width, height, blur_radius);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRectangleShadow, 0, { x, y, width, height, blur_radius } });
     }
     void VisageCanvas_roundedRectangleShadow(VisageCanvas* canvas, float x, float y, float width, float height, float rounding, float blur_radius) {
-        reinterpret_cast<visage::Canvas*>(canvas)->roundedRectangleShadow(x, y, width, height, rounding, blur_radius);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRoundedRectangleShadow, 0, { x, y, width, height, rounding, blur_radius } });
     }
     void VisageCanvas_roundedRectangleBorder(VisageCanvas* canvas, float x, float y, float width, float height, float rounding, float thickness) {
-        reinterpret_cast<visage::Canvas*>(canvas)->roundedRectangleBorder(x, y, width, height, rounding, thickness);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRoundedRectangleBorder, 0, { x, y, width, height, rounding, thickness } });
     }
     void VisageCanvas_triangle(VisageCanvas* canvas, float a_x, float a_y, float b_x, float b_y, float c_x, float c_y) {
-        reinterpret_cast<visage::Canvas*>(canvas)->triangle(a_x, a_y, b_x, b_y, c_x, c_y);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandTriangle, 0, { a_x, a_y, b_x, b_y, c_x, c_y } });
     }
     void VisageCanvas_triangleBorder(VisageCanvas* canvas, float a_x, float a_y, float b_x, float b_y, float c_x, float c_y, float thickness) {
-        reinterpret_cast<visage::Canvas*>(canvas)->triangleBorder(a_x, a_y, b_x, b_y, c_x, c_y, thickness);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandTriangleBorder, 0, { a_x, a_y, b_x, b_y, c_x, c_y, thickness } });
     }
     void VisageCanvas_roundedTriangleBorder(VisageCanvas* canvas, float a_x, float a_y, float b_x, float b_y, float c_x, float c_y, float rounding, float thickness) {
-        reinterpret_cast<visage::Canvas*>(canvas)->roundedTriangleBorder(a_x, a_y, b_x, b_y, c_x, c_y, rounding, thickness);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRoundedTriangleBorder, 0, { a_x, a_y, b_x, b_y, c_x, c_y, rounding, thickness } });
     }
     void VisageCanvas_roundedTriangle(VisageCanvas* canvas, float a_x, float a_y, float b_x, float b_y, float c_x, float c_y, float rounding) {
-        reinterpret_cast<visage::Canvas*>(canvas)->roundedTriangle(a_x, a_y, b_x, b_y, c_x, c_y, rounding);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRoundedTriangle, 0, { a_x, a_y, b_x, b_y, c_x, c_y, rounding } });
     }
     void VisageCanvas_triangleLeft(VisageCanvas* canvas, float triangle_x, float triangle_y, float triangle_width) {
-        reinterpret_cast<visage::Canvas*>(canvas)->triangleLeft(triangle_x, triangle_y, triangle_width);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandDirectionalTriangle, Left, { triangle_x, triangle_y, triangle_width } });
     }
     void VisageCanvas_triangleRight(VisageCanvas* canvas, float triangle_x, float triangle_y, float triangle_width) {
-        reinterpret_cast<visage::Canvas*>(canvas)->triangleRight(triangle_x, triangle_y, triangle_width);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandDirectionalTriangle, Right, { triangle_x, triangle_y, triangle_width } });
     }
     void VisageCanvas_triangleUp(VisageCanvas* canvas, float triangle_x, float triangle_y, float triangle_width) {
-        reinterpret_cast<visage::Canvas*>(canvas)->triangleUp(triangle_x, triangle_y, triangle_width);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandDirectionalTriangle, Up, { triangle_x, triangle_y, triangle_width } });
     }
     void VisageCanvas_triangleDown(VisageCanvas* canvas, float triangle_x, float triangle_y, float triangle_width) {
-        reinterpret_cast<visage::Canvas*>(canvas)->triangleDown(triangle_x, triangle_y, triangle_width);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandDirectionalTriangle, Down, { triangle_x, triangle_y, triangle_width } });
     }
 
     void VisageCanvas_line(VisageCanvas* canvas, VisageLine* line, float x, float y, float width, float height, float line_width) {
-        reinterpret_cast<visage::Canvas*>(canvas)->line(reinterpret_cast<visage::Line*>(line), x, y, width, height, line_width);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_line(canvas, reinterpret_cast<visage::Line*>(line), x, y, width, height, line_width);
+    }
+    void VisageCanvas_lineFill(VisageCanvas* handle, VisageLine* line, float x, float y, float width, float height, float fill_position) {
+        FrameCounters::RecordTimer timer(record_counters(handle));
+        auto line_cpp = reinterpret_cast<visage::Line*>(line);
+
+        if (handle->recording) {
+            handle->recording->addLineFill(*line_cpp, x, y, width, height, fill_position);
+            return;
+        }
+
+        DrawingCanvas* canvas = drawing_canvas_of(handle);
+        if (canvas_hashing(canvas)) {
+            float values[] = { x, y, width, height, fill_position };
+            canvas_hash(canvas, line_hash(*line_cpp));
+            canvas_hash_bytes(canvas, values, sizeof(values));
+        }
+        canvas->counters.line(true);
+        if (canvas->capture)
+            canvas->capture->addLineFill(*line_cpp, x, y, width, height, fill_position);
+        if (canvas->frame)
+            canvas->frame->addLineFill(*line_cpp, x, y, width, height, fill_position);
+        else
+            canvas->canvas.lineFill(line_cpp, x, y, width, height, fill_position);
+    }
+    void VisageCanvas_lineFeed(VisageCanvas* canvas, VisageLineFeed* feed, float x, float y, float width, float height, float line_width) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        visage::Line* line = reinterpret_cast<LineFeed*>(feed)->consume(width, height);
+        canvas_line(canvas, line, x, y, width, height, line_width);
+    }
+    void VisageCanvas_lineSeries(VisageCanvas* canvas, VisageLineSeries* series, float x, float y, float width, float height, float line_width) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        auto series_cpp = reinterpret_cast<LineSeries*>(series);
+        if (series_cpp->numPoints() == 0)
+            return;
+
+        VisageCanvas_saveState(canvas);
+        std::vector<visage::Line>& lines = series_cpp->lines();
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (const VisageBrush_t* brush = series_cpp->brush(static_cast<int>(i)))
+                canvas_set_brush(canvas, *brush);
+            canvas_line(canvas, &lines[i], x, y, width, height, line_width);
+        }
+        VisageCanvas_restoreState(canvas);
+    }
+    void VisageCanvas_linePyramid(VisageCanvas* canvas, VisageLinePyramid* pyramid, int32_t start, int32_t count, float x, float y, float width, float height, float line_width) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        auto pyramid_cpp = reinterpret_cast<LinePyramid*>(pyramid);
+        visage::Line* line = pyramid_cpp->layout(static_cast<int>(start), static_cast<int>(count), width, height, canvas_dpi_scale(canvas));
+        if (line == nullptr)
+            return;
+
+        // Recorded draws copy the line already.
+        DrawingCanvas* drawing = canvas->recording ? nullptr : drawing_canvas_of(canvas);
+        if (drawing && drawing->frame == nullptr) {
+            drawing->frame_lines.push_back(*line);
+            line = &drawing->frame_lines.back();
+        }
+        canvas_line(canvas, line, x, y, width, height, line_width);
+    }
+
+    void VisageCanvas_image(VisageCanvas* canvas, VisageImage* image, float x, float y) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        auto image_cpp = reinterpret_cast<ImageSurface*>(image);
+        float width = static_cast<float>(image_cpp->width());
+        float height = static_cast<float>(image_cpp->height());
+        if (canvas_recording_display_list(canvas))
+            return;
+
+        // Recording contexts keep the tiles alive in their commands.
+        DrawingCanvas* drawing = canvas->recording ? nullptr : drawing_canvas_of(canvas);
+        // Tiles are drawn shifted left by the scroll offset, and the ones pushed off the left edge
+        // again one image width to the right, clamped to the image.
+        int scroll = image_cpp->scrollOffset();
+        canvas_frame_command(canvas, { VisageShapeCommandSaveState, 0, {} });
+        canvas_frame_command(canvas, { VisageShapeCommandTrimClampBounds, 0, { x, y, width, height } });
+        for (int row = 0; row < image_cpp->rows(); ++row) {
+            for (int column = 0; column < image_cpp->columns(); ++column) {
+                int tile_width = image_cpp->tileWidth(column);
+                int tile_height = image_cpp->tileHeight(row);
+                int tile_x = column * ImageSurface::kTileSize - scroll;
+                float tile_y = y + row * ImageSurface::kTileSize;
+                const std::shared_ptr<const uint8_t>& pixels = image_cpp->tilePixels(column, row);
+                if (drawing)
+                    drawing->frame_pixels.tiles.push_back(pixels);
+
+                for (int wrap_x : { tile_x, tile_x + image_cpp->width() }) {
+                    if (wrap_x + tile_width > 0 && wrap_x < image_cpp->width())
+                        canvas_draw_pixels(canvas, { pixels, pixels.get(), tile_width, tile_height }, x + wrap_x, tile_y,
+                                           static_cast<float>(tile_width), static_cast<float>(tile_height));
+                }
+            }
+        }
+        canvas_frame_command(canvas, { VisageShapeCommandRestoreState, 0, {} });
+    }
+
+    void VisageCanvas_svg(VisageCanvas* canvas, VisageSvg* svg, float x, float y, float width, float height) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        const VisageSvg* svgs[] = { svg };
+        VisageCanvas_svgs(canvas, svgs, &x, &y, &width, &height, 1);
+    }
+    void VisageCanvas_svgs(VisageCanvas* canvas, const VisageSvg* const* svgs, const float* x, const float* y, const float* width, const float* height, int32_t count) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        if (canvas_recording_display_list(canvas) || count <= 0)
+            return;
+
+        DrawingCanvas* drawing = canvas->recording ? nullptr : drawing_canvas_of(canvas);
+        std::vector<SvgCache::Key> keys;
+        float dpi_scale = canvas_dpi_scale(canvas);
+        for (int32_t i = 0; i < count; ++i)
+            keys.push_back(SvgCache::key(svgs[i], width[i], height[i], dpi_scale));
+
+        std::vector<std::shared_ptr<const SvgRaster>> rasters = SvgCache::instance().resolve(svgs, keys.data(), keys.size());
+        for (int32_t i = 0; i < count; ++i) {
+            const SvgRaster& raster = *rasters[i];
+            if (drawing && canvas_hashing(drawing))
+                canvas_hash(drawing, keys[i].svg);
+            canvas_draw_pixels(canvas, { rasters[i], raster.pixels.get(), raster.width, raster.height }, x[i], y[i], width[i], height[i]);
+            if (drawing)
+                drawing->frame_pixels.svgs.push_back(std::move(rasters[i]));
+        }
     }
-    void VisageCanvas_lineFill(VisageCanvas* canvas, VisageLine* line, float x, float y, float width, float height, float fill_position) {
-        reinterpret_cast<visage::Canvas*>(canvas)->lineFill(reinterpret_cast<visage::Line*>(line), x, y, width, height, fill_position);
+
+    void VisageCanvas_beginLayer(VisageCanvas* canvas, VisageLayer* layer) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        LayerCache::instance().invalidate(layer);
+        layer->drawn = true;
+        canvas->recording = &layer->content;
+    }
+    void VisageCanvas_drawLayer(VisageCanvas* canvas, VisageLayer* layer, float x, float y) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        if (canvas_recording_display_list(canvas) || !layer->drawn)
+            return;
+
+        // Recording contexts are hashed, counted and captured by their parent.
+        DrawingCanvas* drawing = canvas->recording ? nullptr : drawing_canvas_of(canvas);
+        if (drawing && drawing->capture)
+            drawing->capture->append(layer->content, x, y);
+
+        canvas_frame_command(canvas, { VisageShapeCommandSaveState, 0, {} });
+        canvas_frame_command(canvas, { VisageShapeCommandTrimClampBounds, 0, { x, y, layer->width, layer->height } });
+        if (!LayerCache::instance().rasterizes(layer)) {
+            if (drawing && canvas_hashing(drawing))
+                canvas_hash(drawing, layer->content.hash());
+            canvas_frame_list(canvas, layer->content, x, y);
+            if (drawing)
+                drawing->counters.list(layer->content);
+            canvas_frame_command(canvas, { VisageShapeCommandRestoreState, 0, {} });
+            return;
+        }
+
+        float dpi_scale = canvas_dpi_scale(canvas);
+        std::shared_ptr<LayerRaster> raster = LayerCache::instance().resolve(layer, dpi_scale > 0.0f ? dpi_scale : 1.0f);
+        ImageSurface& surface = raster->surface;
+        if (drawing && canvas_hashing(drawing))
+            canvas_hash(drawing, raster->generation);
+        float tile_size = ImageSurface::kTileSize / raster->scale;
+
+        for (int row = 0; row < surface.rows(); ++row) {
+            for (int column = 0; column < surface.columns(); ++column) {
+                int tile_width = surface.tileWidth(column);
+                int tile_height = surface.tileHeight(row);
+                const std::shared_ptr<const uint8_t>& pixels = surface.tilePixels(column, row);
+                canvas_draw_pixels(canvas, { pixels, pixels.get(), tile_width, tile_height }, x + column * tile_size,
+                                   y + row * tile_size, tile_width / raster->scale, tile_height / raster->scale);
+            }
+        }
+        if (layer->text.numCommands()) {
+            canvas_frame_list(canvas, layer->text, x, y);
+            if (drawing)
+                drawing->counters.list(layer->text);
+        }
+        canvas_frame_command(canvas, { VisageShapeCommandRestoreState, 0, {} });
+        if (drawing)
+            drawing->frame_pixels.layers.push_back(std::move(raster));
+    }
+
+    void VisageCanvas_text(VisageCanvas* handle, VisageText* text, float x, float y, float width, float height, int32_t direction) {
+        FrameCounters::RecordTimer timer(record_counters(handle));
+        auto text_cpp = &text->text;
+
+        if (handle->recording) {
+            handle->recording->addText(*text_cpp, x, y, width, height, direction);
+            return;
+        }
+
+        DrawingCanvas* canvas = drawing_canvas_of(handle);
+        if (canvas_hashing(canvas)) {
+            float values[] = { x, y, width, height, static_cast<float>(direction) };
+            canvas_hash(canvas, text_hash(*text_cpp));
+            canvas_hash_bytes(canvas, values, sizeof(values));
+        }
+        canvas->counters.text(*text_cpp, text->font.entry.get());
+        if (canvas->capture)
+            canvas->capture->addText(*text_cpp, x, y, width, height, direction);
+        if (canvas->frame)
+            canvas->frame->addText(*text_cpp, x, y, width, height, direction);
+        else
+            canvas->canvas.text(text_cpp, x, y, width, height, direction_to_cpp(direction));
+    }
+
+    void VisageCanvas_drawBatch(VisageCanvas* canvas, const VisageShapeCommand* commands, int32_t num_commands, const VisageBrush* const* brushes, int32_t num_brushes) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        for (int32_t i = 0; i < num_commands; ++i) {
+            const VisageShapeCommand& command = commands[i];
+
+            if (command.type == VisageShapeCommandSetColor) {
+                canvas_set_color(canvas, command_color_to_cpp(command));
+            } else if (command.type == VisageShapeCommandSetBrush) {
+                if (command.flags < static_cast<uint32_t>(num_brushes) && brushes[command.flags] != nullptr) {
+                    canvas_set_brush(canvas, *brushes[command.flags]);
+                }
+            } else if (command.type < VisageNumShapeCommandTypes) {
+                canvas_draw(canvas, command);
+            }
+        }
+    }
+
+    void VisageCanvas_beginRecording(VisageCanvas* canvas, VisageDisplayList* list) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas->recording = reinterpret_cast<CommandList*>(list);
     }
+    void VisageCanvas_endRecording(VisageCanvas* canvas) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        RecordingContext* context = as_recording_context(canvas);
+        canvas->recording = context ? &context->commands : nullptr;
+    }
+    void VisageCanvas_drawDisplayList(VisageCanvas* canvas, const VisageDisplayList* list, float x, float y) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw_list(canvas, *reinterpret_cast<const CommandList*>(list), x, y);
+    }
+
+    void VisageCanvas_setCommandCapture(VisageCanvas* handle, bool capture) {
+        DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas == nullptr)
+            return;
+
+        if (!capture)
+            canvas->capture.reset();
+        else if (!canvas->capture)
+            canvas->capture = std::make_unique<CommandList>();
+    }
+    bool VisageCanvas_saveCommands(const VisageCanvas* handle, const char* path) {
+        const DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas == nullptr || !canvas->capture)
+            return false;
 
-    void VisageCanvas_text(VisageCanvas* canvas, VisageText* text, float x, float y, float width, float height, int32_t direction) {
-        reinterpret_cast<visage::Canvas*>(canvas)->text(reinterpret_cast<visage::Text*>(text), x, y, width, height, direction_to_cpp(direction));
+        std::vector<char> stream = canvas->capture->toStream(canvas->width, canvas->height, canvas->canvas.dpiScale());
+        std::FILE* file = std::fopen(path, "wb");
+        if (file == nullptr)
+            return false;
+
+        bool written = std::fwrite(stream.data(), 1, stream.size(), file) == stream.size();
+        return std::fclose(file) == 0 && written;
+    }
+    bool VisageCanvas_replayMapped(VisageCanvas* handle, const void* data, size_t size) {
+        // Recording contexts are replayed after `data` may be gone, so they get copies.
+        if (handle->recording && handle->is_context) {
+            StreamStorage storage;
+            return replay_command_stream(ListStreamTarget { handle->recording }, data, size, &storage);
+        }
+
+        // So does a frame submitted asynchronously.
+        DrawingCanvas* canvas = drawing_canvas_of(handle);
+        bool replayed = canvas->frame ? replay_command_stream(ListStreamTarget { canvas->frame }, data, size, &canvas->stream_storage)
+                                      : replay_command_stream(CanvasStreamTarget { &canvas->canvas }, data, size, &canvas->stream_storage);
+        if (!replayed)
+            return false;
+
+        if (canvas_hashing(canvas))
+            canvas_hash_bytes(canvas, data, size);
+        return true;
     }
 
     void VisageCanvas_saveState(VisageCanvas* canvas) {
-        reinterpret_cast<visage::Canvas*>(canvas)->saveState();
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandSaveState, 0, {} });
     }
     void VisageCanvas_restoreState(VisageCanvas* canvas) {
-        reinterpret_cast<visage::Canvas*>(canvas)->restoreState();
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandRestoreState, 0, {} });
     }
 
     void VisageCanvas_setPosition(VisageCanvas* canvas, float x, float y) {
-        reinterpret_cast<visage::Canvas*>(canvas)->setPosition(x, y);
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandSetPosition, 0, { x, y } });
+    }
+
+    void VisageCanvas_setClampBounds(VisageCanvas* canvas, float x, float y, float width, float height) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandSetClampBounds, 0, { x, y, width, height } });
+    }
+    void VisageCanvas_trimClampBounds(VisageCanvas* canvas, float x, float y, float width, float height) {
+        FrameCounters::RecordTimer timer(record_counters(canvas));
+        canvas_draw(canvas, { VisageShapeCommandTrimClampBounds, 0, { x, y, width, height } });
+    }
+
+    void VisageCanvas_invalidateRect(VisageCanvas* handle, float x, float y, float width, float height) {
+        if (DrawingCanvas* canvas = as_drawing_canvas(handle))
+            canvas->dirty.invalidate({ x, y, width, height });
+    }
+    bool VisageCanvas_isRectDirty(const VisageCanvas* handle, float x, float y, float width, float height) {
+        const DrawingCanvas* canvas = as_drawing_canvas(handle);
+        return canvas == nullptr || canvas_rect_dirty(canvas, { x, y, width, height });
+    }
+    int32_t VisageCanvas_dirtyRects(const VisageCanvas* handle, float* rects, int32_t max_rects) {
+        const DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas == nullptr)
+            return 0;
+
+        const std::vector<Bounds>& dirty_rects = canvas->dirty.rects();
+        size_t count = std::min(dirty_rects.size(), static_cast<size_t>(std::max(max_rects, 0)));
+
+        for (size_t i = 0; i < count; ++i) {
+            rects[4 * i] = dirty_rects[i].x;
+            rects[4 * i + 1] = dirty_rects[i].y;
+            rects[4 * i + 2] = dirty_rects[i].width;
+            rects[4 * i + 3] = dirty_rects[i].height;
+        }
+        return static_cast<int32_t>(dirty_rects.size());
+    }
+
+    // -- Display List ---------------------------------------------------------------------------------
+
+    VisageDisplayList* VisageDisplayList_new() {
+        auto list = new CommandList;
+        return reinterpret_cast<VisageDisplayList*>(list);
+    }
+    void VisageDisplayList_delete(VisageDisplayList* list) {
+        delete reinterpret_cast<CommandList*>(list);
+    }
+
+    void VisageDisplayList_clear(VisageDisplayList* list) {
+        reinterpret_cast<CommandList*>(list)->clear();
+    }
+    int32_t VisageDisplayList_numCommands(const VisageDisplayList* list) {
+        return static_cast<int32_t>(reinterpret_cast<const CommandList*>(list)->numCommands());
+    }
+
+    // -- Command Stream -------------------------------------------------------------------------------
+
+    bool VisageCommandStream_dimensions(const void* data, size_t size, int32_t* width, int32_t* height, float* dpi_scale) {
+        const StreamHeader* header = stream_header(data, size);
+        if (header == nullptr)
+            return false;
+
+        *width = header->width;
+        *height = header->height;
+        *dpi_scale = header->dpi_scale;
+        return true;
+    }
+
+    // -- Software Raster ------------------------------------------------------------------------------
+
+    VisageSoftwareRaster* VisageSoftwareRaster_new(int32_t width, int32_t height) {
+        auto raster = new SoftwareRaster(width, height);
+        return reinterpret_cast<VisageSoftwareRaster*>(raster);
+    }
+    void VisageSoftwareRaster_delete(VisageSoftwareRaster* raster) {
+        delete reinterpret_cast<SoftwareRaster*>(raster);
+    }
+
+    int32_t VisageSoftwareRaster_width(const VisageSoftwareRaster* raster) {
+        return reinterpret_cast<const SoftwareRaster*>(raster)->width();
+    }
+    int32_t VisageSoftwareRaster_height(const VisageSoftwareRaster* raster) {
+        return reinterpret_cast<const SoftwareRaster*>(raster)->height();
+    }
+    void VisageSoftwareRaster_setScale(VisageSoftwareRaster* raster, float scale) {
+        reinterpret_cast<SoftwareRaster*>(raster)->setScale(scale);
+    }
+    void VisageSoftwareRaster_clear(VisageSoftwareRaster* raster, uint32_t argb) {
+        reinterpret_cast<SoftwareRaster*>(raster)->clear(argb);
     }
-}
\ No newline at end of file
+
+    void VisageSoftwareRaster_drawDisplayList(VisageSoftwareRaster* raster, const VisageDisplayList* list, float x, float y) {
+        reinterpret_cast<SoftwareRaster*>(raster)->draw(*reinterpret_cast<const CommandList*>(list), x, y);
+    }
+    bool VisageSoftwareRaster_drawCapture(VisageSoftwareRaster* raster, const VisageCanvas* handle) {
+        const DrawingCanvas* canvas = as_drawing_canvas(handle);
+        if (canvas == nullptr || !canvas->capture)
+            return false;
+
+        reinterpret_cast<SoftwareRaster*>(raster)->draw(*canvas->capture, 0.0f, 0.0f);
+        return true;
+    }
+
+    const uint32_t* VisageSoftwareRaster_pixels(VisageSoftwareRaster* raster) {
+        return reinterpret_cast<SoftwareRaster*>(raster)->pixels();
+    }
+    void VisageSoftwareRaster_getStats(const VisageSoftwareRaster* raster, VisageSoftwareRasterStats* stats) {
+        *stats = reinterpret_cast<const SoftwareRaster*>(raster)->stats();
+    }
+}
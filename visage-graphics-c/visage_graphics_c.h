@@ -2,10 +2,12 @@
 #define VISAGE_C_WRAPPER_H
 
 #ifdef __cplusplus
+#include <cstddef>
 #include <cstdint>
 extern "C" {
 #else
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #define char32_t uint_least32_t
 #endif
@@ -103,12 +105,19 @@ typedef struct VisageGradient_t VisageGradient;
 VisageGradient* VisageGradient_new();
 VisageGradient* VisageGradient_copy(const VisageGradient* gradient);
 VisageGradient* VisageGradient_fromSampleFunction(int32_t resolution, void (*sample_function)(float, VisageColor*));
+// Creates a gradient with one stop per 0xAARRGGBB color, the layout most palettes are stored in.
+VisageGradient* VisageGradient_fromPackedARGB(const uint32_t* argb, int32_t count);
 void VisageGradient_delete(VisageGradient* gradient);
 
 int32_t VisageGradient_getResolution(const VisageGradient* gradient);
 void VisageGradient_setResolution(VisageGradient* gradient, int32_t resolution);
 void VisageGradient_getColor(const VisageGradient* gradient, int32_t index, VisageColor* returnValue);
+// Copies up to `max_colors` colors into `colors` and returns the resolution, so passing a null
+// `colors` with `max_colors` 0 returns the size to allocate.
+int32_t VisageGradient_getColors(const VisageGradient* gradient, VisageColor* colors, int32_t max_colors);
 void VisageGradient_setColor(VisageGradient* gradient, int32_t index, VisageColor color);
+// Sets the resolution to `count` and the colors to `colors` in one call.
+void VisageGradient_setColors(VisageGradient* gradient, const VisageColor* colors, int32_t count);
 void VisageGradient_interpolateWith(VisageGradient* gradient, const VisageGradient* other, float t);
 void VisageGradient_sample(const VisageGradient* gradient, float t, VisageColor* returnValue);
 void VisageGradient_multiplyAlpha(VisageGradient* gradient, float mult);
@@ -133,6 +142,28 @@ void VisageBrush_linearFromTwo(VisageBrush* brush, VisageColor from_color, Visag
 void VisageBrush_interpolateWith(VisageBrush* brush, const VisageBrush* other, float t);
 void VisageBrush_multiplyAlpha(VisageBrush* brush, float t);
 
+// -- Brush Palette --------------------------------------------------------------------------------
+
+typedef struct VisageBrushPaletteStats {
+    // Distinct brushes registered.
+    int32_t brushes;
+    // Registrations not yet released.
+    int32_t references;
+    // Distinct gradients among them, each taking one row of the renderer's gradient atlas.
+    int32_t gradients;
+    // Total resolution of those gradients.
+    int32_t gradient_stops;
+} VisageBrushPaletteStats;
+
+// Registers a copy of `brush` and returns its id, or 0 if the palette is full. Registering a brush
+// identical to one already registered returns the same id and adds a reference to it. Later
+// changes to `brush` don't affect the registered copy. Drawing with an id takes no lock.
+int32_t VisageBrushPalette_register(const VisageBrush* brush);
+// Drops one reference to `id`; the brush is removed and its id reused once none are left. The last
+// reference must only be dropped once no thread is drawing with the id anymore.
+void VisageBrushPalette_release(int32_t id);
+void VisageBrushPalette_getStats(VisageBrushPaletteStats* stats);
+
 // -- Line -----------------------------------------------------------------------------------------
 
 struct VisageLine_t;
@@ -161,6 +192,230 @@ float* VisageLine_yValues(VisageLine* line);
 // Changing the number of points may invalidate this pointer.
 float* VisageLine_values(VisageLine* line);
 
+typedef enum VisageLineChannel {
+    VisageLineChannelX,
+    VisageLineChannelY,
+    VisageLineChannelValues,
+} VisageLineChannel;
+
+typedef enum VisageSampleType {
+    VisageSampleTypeFloat32,
+    VisageSampleTypeFloat64,
+    VisageSampleTypeInt16,
+    VisageSampleTypeInt32,
+} VisageSampleType;
+
+// Fills one channel of `line` from `count` samples of `type` that are `stride` bytes apart, storing
+// `sample * scale + offset`. This reads one side of interleaved data directly, e.g. the y of
+// packed double xy pairs is `data + sizeof(double)` with a stride of `2 * sizeof(double)`, and
+// int16 PCM is normalized with a scale of `1.0f / 32768.0f`. Writes at most as many points as the
+// line has and returns how many were written.
+int32_t VisageLine_setFromStrided(VisageLine* line, int32_t channel, const void* data, int32_t type, int32_t stride, int32_t count, float scale, float offset);
+
+// -- Line Series ----------------------------------------------------------------------------------
+
+// A group of lines sharing one set of x values, such as the channels of a scope or the bands of
+// an analyzer, drawn with one call. The x values are stored once and the y values of every series
+// in one block, and drawing reads them in place. visage has no multi-series line, so the group is
+// still drawn as one line per series, the same as calling `VisageCanvas_line` for each.
+struct VisageLineSeries_t;
+typedef struct VisageLineSeries_t VisageLineSeries;
+
+VisageLineSeries* VisageLineSeries_new(int32_t num_series, int32_t points);
+void VisageLineSeries_delete(VisageLineSeries* series);
+
+int32_t VisageLineSeries_getNumSeries(const VisageLineSeries* series);
+int32_t VisageLineSeries_getNumPoints(const VisageLineSeries* series);
+// Resizes every series and resets all values to 0.
+void VisageLineSeries_setNumPoints(VisageLineSeries* series, int32_t points);
+// The value accessors below return null if there are no points. The pointers stay valid, and can
+// be written through at any time between draws, until the number of points changes.
+// Returns a pointer to the x values shared by every series, or null if there are no series.
+float* VisageLineSeries_xValues(VisageLineSeries* series);
+// Returns a pointer to the y values of every series, `points` values per series one after another,
+// or null if there are no series.
+float* VisageLineSeries_yValues(VisageLineSeries* series);
+// Returns a pointer to the y values of the series at `index`, or null if it is out of range. This
+// is `VisageLineSeries_yValues` offset by `index * points`.
+float* VisageLineSeries_seriesValues(VisageLineSeries* series, int32_t index);
+// Sets the brush the series at `index` is drawn with. A null brush draws it with the canvas's
+// current brush, which is the default.
+void VisageLineSeries_setBrush(VisageLineSeries* series, int32_t index, const VisageBrush* brush);
+
+// -- Line Feed ------------------------------------------------------------------------------------
+
+// A lock-free single producer, single consumer ring of samples attached to a line, for feeding
+// meters and scopes from an audio callback. One thread pushes samples and one thread draws; pushing
+// never locks, allocates or waits. Drawing lays the newest `window` samples out across the line and
+// releases everything older.
+struct VisageLineFeed_t;
+typedef struct VisageLineFeed_t VisageLineFeed;
+
+typedef struct VisageLineFeedStats {
+    uint64_t pushed;
+    // Samples pushed while the ring was full, which were discarded.
+    uint64_t dropped;
+    // Pushes that dropped at least one sample.
+    uint64_t overruns;
+    // Samples pushed since the last time the feed was drawn.
+    uint64_t pending;
+    int32_t capacity;
+    int32_t window;
+} VisageLineFeedStats;
+
+// Creates a feed drawing `window` points. `capacity` is rounded up to a power of two at least twice
+// the window; the producer can push `capacity - window` samples between two draws before dropping.
+VisageLineFeed* VisageLineFeed_new(int32_t window, int32_t capacity);
+void VisageLineFeed_delete(VisageLineFeed* feed);
+
+// Producer side, safe to call from a real-time thread. Returns how many samples were written.
+int32_t VisageLineFeed_push(VisageLineFeed* feed, const float* samples, int32_t count);
+
+// The rest is consumer side and must all be called from the drawing thread.
+// Sets the sample values mapped to the bottom and top of the line. Defaults to -1 and 1.
+void VisageLineFeed_setValueRange(VisageLineFeed* feed, float min_value, float max_value);
+// The line the feed writes into, owned by the feed, for setting value scales.
+VisageLine* VisageLineFeed_line(VisageLineFeed* feed);
+// Lays the newest window out across `width` x `height` and returns the feed's line, for drawing
+// it some other way such as with `VisageCanvas_lineFill`.
+VisageLine* VisageLineFeed_consume(VisageLineFeed* feed, float width, float height);
+void VisageLineFeed_getStats(const VisageLineFeed* feed, VisageLineFeedStats* stats);
+
+// -- Line Pyramid ---------------------------------------------------------------------------------
+
+// A copy of a long series of samples with a min/max pyramid over it, for drawing millions of
+// points as a line. Drawing reduces the samples to two points per pixel column using the coarsest
+// level that still resolves a column, so its cost depends on the drawn width, not the sample count.
+struct VisageLinePyramid_t;
+typedef struct VisageLinePyramid_t VisageLinePyramid;
+
+VisageLinePyramid* VisageLinePyramid_new();
+void VisageLinePyramid_delete(VisageLinePyramid* pyramid);
+
+// Copies `num_samples` samples and rebuilds the whole pyramid.
+void VisageLinePyramid_setSamples(VisageLinePyramid* pyramid, const float* samples, int32_t num_samples);
+// Overwrites `count` samples starting at `start` and only refreshes the pyramid blocks covering
+// them. The range is clipped to the current sample count; use `setSamples` to resize.
+void VisageLinePyramid_updateSamples(VisageLinePyramid* pyramid, int32_t start, const float* samples, int32_t count);
+int32_t VisageLinePyramid_numSamples(const VisageLinePyramid* pyramid);
+// Sets the sample values mapped to the bottom and top of the drawn line. Defaults to -1 and 1.
+void VisageLinePyramid_setValueRange(VisageLinePyramid* pyramid, float min_value, float max_value);
+// Lays `count` samples from `start` out across `width` x `height` and returns the pyramid's line,
+// for drawing it some other way, or null if there is nothing to lay out. Every column of
+// `width * dpi_scale` gets two points, its minimum and maximum, unless there are at most twice as
+// many samples as columns, in which case every sample is a point. The line is owned by the pyramid
+// and overwritten by the next layout.
+VisageLine* VisageLinePyramid_layout(VisageLinePyramid* pyramid, int32_t start, int32_t count, float width, float height, float dpi_scale);
+
+// -- Image ----------------------------------------------------------------------------------------
+
+// Raw pixels owned by the caller and drawn without being copied up front. The caller writes into
+// its pixels and reports the changed area with `VisageImage_updateRect` or `VisageImage_updateColumn`;
+// only the parts touched are converted and uploaded on the next draw. The pixels must stay valid
+// for as long as the image is drawn.
+struct VisageImage_t;
+typedef struct VisageImage_t VisageImage;
+
+typedef enum VisageImageFormat {
+    // One 0xAARRGGBB uint32_t per pixel.
+    VisageImageFormatARGB8,
+    // Four floats per pixel in `VisageColor` channel order, clamped to [0, 1].
+    VisageImageFormatFloat,
+} VisageImageFormat;
+
+typedef struct VisageImageStats {
+    // Square tiles the image is uploaded in.
+    int32_t tiles;
+    // Tiles converted and uploaded so far.
+    uint64_t tile_uploads;
+    // Pixels converted so far, only the changed part of each uploaded tile.
+    uint64_t uploaded_pixels;
+} VisageImageStats;
+
+// `row_stride` is in bytes, 0 meaning rows are packed.
+VisageImage* VisageImage_new(const void* pixels, int32_t format, int32_t width, int32_t height, int32_t row_stride);
+void VisageImage_delete(VisageImage* image);
+
+// Points the image at other pixels of the same format and size, which updates all of it.
+void VisageImage_setPixels(VisageImage* image, const void* pixels, int32_t row_stride);
+void VisageImage_updateRect(VisageImage* image, int32_t x, int32_t y, int32_t width, int32_t height);
+void VisageImage_updateColumn(VisageImage* image, int32_t x);
+// Draws the image rotated left by `offset` columns, wrapping around, so a scrolling view can write
+// each new column over the oldest one instead of shifting its pixels.
+void VisageImage_setScrollOffset(VisageImage* image, int32_t offset);
+int32_t VisageImage_getScrollOffset(const VisageImage* image);
+void VisageImage_getStats(const VisageImage* image, VisageImageStats* stats);
+
+// -- Svg ------------------------------------------------------------------------------------------
+
+// A parsed SVG document. Drawing rasterizes it at the drawn size times the canvas's dpi scale and
+// keeps the result in a shared cache, so the same icon at a size and scale drawn before is not
+// rasterized again.
+struct VisageSvg_t;
+typedef struct VisageSvg_t VisageSvg;
+
+typedef struct VisageSvgCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    // Bytes of rasterized pixels held, and the budget past which the least recently used go.
+    uint64_t bytes;
+    uint64_t capacity;
+    int32_t entries;
+} VisageSvgCacheStats;
+
+// Parses a copy of `data`. Returns null if it isn't a valid SVG.
+VisageSvg* VisageSvg_new(const char* data, int32_t data_size);
+VisageSvg* VisageSvg_fromFile(const char* path);
+// Deletes the svg and drops its cached rasters.
+void VisageSvg_delete(VisageSvg* svg);
+void VisageSvg_getDimensions(const VisageSvg* svg, float* width, float* height);
+
+// Defaults to 64 MiB.
+void VisageSvgCache_setCapacity(size_t bytes);
+void VisageSvgCache_clear();
+void VisageSvgCache_getStats(VisageSvgCacheStats* stats);
+// Rasterizes every svg at its width and height times `dpi_scale` that isn't cached yet, in
+// parallel, so a dpi change or a toolbar appearing doesn't rasterize on the drawing path.
+void VisageSvgCache_prewarm(const VisageSvg* const* svgs, const float* widths, const float* heights, int32_t count, float dpi_scale);
+
+// -- Layer ----------------------------------------------------------------------------------------
+
+// A cached layer for content that rarely changes, like backgrounds, grids and axis labels. What is
+// drawn into it is kept and rasterized on the CPU the first time the layer is composited at a dpi
+// scale; later composites only draw its pixels until it is invalidated and drawn again. Shapes,
+// lines and brushes are rasterized, text is drawn over the pixels on every composite. A layer that
+// draws anything after text is never rasterized; its commands are replayed on every composite
+// instead.
+struct VisageLayer_t;
+typedef struct VisageLayer_t VisageLayer;
+
+typedef struct VisageLayerCacheStats {
+    int32_t layers;
+    // Layers whose pixels are currently held.
+    int32_t resident;
+    // Bytes of layer pixels held, and the budget past which the least recently composited go.
+    uint64_t bytes;
+    uint64_t budget;
+    uint64_t rasterizations;
+    uint64_t evictions;
+    uint64_t composites;
+} VisageLayerCacheStats;
+
+// The layer covers `width` x `height` from its origin; anything drawn outside is cut off.
+VisageLayer* VisageLayer_new(float width, float height);
+void VisageLayer_delete(VisageLayer* layer);
+
+// Drops what was drawn into the layer. It isn't composited until it is drawn again.
+void VisageLayer_invalidate(VisageLayer* layer);
+// Returns true if the layer has been drawn since it was created or invalidated.
+bool VisageLayer_isValid(const VisageLayer* layer);
+
+// Defaults to 128 MiB. Evicted layers keep what was drawn into them and are rasterized again the
+// next time they are composited; a layer being composited is never evicted.
+void VisageLayerCache_setBudget(size_t bytes);
+void VisageLayerCache_getStats(VisageLayerCacheStats* stats);
+
 // -- Font -----------------------------------------------------------------------------------------
 
 struct VisageFont_t;
@@ -174,17 +429,81 @@ void VisageFont_delete(VisageFont* font);
 float VisageFont_getDpiScale(const VisageFont* font);
 int32_t VisageFont_widthOverflowIndex(const VisageFont* font, const char32_t* string, int32_t string_length, float width, bool round, int32_t character_override);
 int32_t VisageFont_lineBreaks(const VisageFont* font, const char32_t* string, int32_t string_length, float width, int* line_breaks, int32_t line_breaks_length);
+// Writes the index each wrapped line starts at into `line_breaks` without allocating. Returns the
+// number of breaks, which is the required capacity if it is larger than `line_breaks_capacity`.
+int32_t VisageFont_lineBreaksInto(const VisageFont* font, const char32_t* string, int32_t string_length, float width, int32_t* line_breaks, int32_t line_breaks_capacity);
+// Breaks `num_strings` paragraphs, each at its own width. Breaks are written back to back into
+// `line_breaks` and `break_counts` receives the number of breaks per paragraph. Returns the total
+// number of breaks; if it exceeds `line_breaks_capacity` the output is truncated but the counts
+// are complete.
+int32_t VisageFont_lineBreaksBatch(const VisageFont* font, const char32_t* const* strings, const int32_t* string_lengths, const float* widths, int32_t num_strings, int32_t* line_breaks, int32_t line_breaks_capacity, int32_t* break_counts);
 float VisageFont_stringWidth(const VisageFont* font, const char32_t* string, int32_t string_length, int32_t character_override);
+// Measures `num_strings` strings into `widths`.
+void VisageFont_stringWidths(const VisageFont* font, const char32_t* const* strings, const int32_t* string_lengths, int32_t num_strings, int32_t character_override, float* widths);
 float VisageFont_lineHeight(const VisageFont* font);
 float VisageFont_capitalHeight(const VisageFont* font);
 float VisageFont_lowerDipHeight(const VisageFont* font);
 float VisageFont_size(const VisageFont* font);
 const char* VisageFont_fontData(const VisageFont* font, int32_t* data_size);
 
+typedef struct VisageMeasureCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    int32_t entries;
+    int32_t capacity;
+} VisageMeasureCacheStats;
+
+// Remembers up to `capacity` results of `VisageFont_stringWidth`, `VisageFont_stringWidths` and
+// `VisageFont_widthOverflowIndex`, evicting the least recently used. A capacity of 0 disables and
+// frees the cache. All handles to the same interned font share its cache. Not thread safe.
+void VisageFont_setMeasureCacheCapacity(VisageFont* font, int32_t capacity);
+// Drops all cached measurements and resets the counters.
+void VisageFont_clearMeasureCache(VisageFont* font);
+void VisageFont_getMeasureCacheStats(const VisageFont* font, VisageMeasureCacheStats* stats);
+
 VisageFont* VisageFont_LatoRegular(float size, float dpi_scale);
 VisageFont* VisageFont_DroidSansMono(float size, float dpi_scale);
 VisageFont* VisageFont_TwemojiMozilla(float size, float dpi_scale);
 
+#define VISAGE_GLYPH_PRESET_LATIN1 0x1
+#define VISAGE_GLYPH_PRESET_DIGITS 0x2
+#define VISAGE_GLYPH_PRESET_UI_SYMBOLS 0x4
+
+// Rasterizes glyphs into the font's atlas ahead of time so the first frame using them doesn't
+// stall. The atlas is uploaded in one batch the next time the font is drawn. `presets` is a mask
+// of `VISAGE_GLYPH_PRESET_*` values.
+void VisageFont_prewarm(const VisageFont* font, const char32_t* codepoints, int32_t count);
+void VisageFont_prewarmPreset(const VisageFont* font, uint32_t presets);
+// Prewarms several fonts in parallel on worker threads and returns when all are done. None of the
+// fonts may be drawn or measured on other threads in the meantime.
+void VisageFont_prewarmFonts(const VisageFont* const* fonts, int32_t num_fonts, const char32_t* codepoints, int32_t count, uint32_t presets);
+
+typedef struct VisageFontRegistryStats {
+    // Distinct fonts alive.
+    int32_t fonts;
+    // Handles and texts referencing them.
+    int32_t references;
+    // Glyph atlases visage keeps for them, one per font data and pixel size.
+    int32_t atlases;
+} VisageFontRegistryStats;
+
+// Fonts are interned by data pointer, size and dpi scale: creating, copying or rescaling a font
+// that already exists returns a new handle to the shared font, and the font is released with its
+// last handle.
+void VisageFontRegistry_getStats(VisageFontRegistryStats* stats);
+
+// -- Glyph Cache ----------------------------------------------------------------------------------
+
+// Enables remembering which glyphs each font uses in `directory`, one memory mapped file per font
+// data hash, size and dpi scale. NULL disables it. The directory must exist.
+void VisageGlyphCache_setDirectory(const char* directory);
+// Rasterizes the glyphs a previous run saved for `fonts` on worker threads, before they are first
+// drawn. Returns the number of fonts that had a cache file. None of the fonts may be used on other
+// threads in the meantime.
+int32_t VisageGlyphCache_prewarm(const VisageFont* const* fonts, int32_t num_fonts);
+// Writes the glyphs used by every live font into the cache directory.
+bool VisageGlyphCache_save();
+
 // -- Text -----------------------------------------------------------------------------------------
 
 enum VisageJustification {
@@ -208,6 +527,9 @@ void VisageText_delete(VisageText* text);
 
 void VisageText_setText(VisageText* text, const char* s);
 void VisageText_setTextWithLength(VisageText* text, const char* s, int32_t length);
+// Only updates the text if the UTF-8 content differs from the last UTF-8 text set.
+// Returns true if the text was updated.
+bool VisageText_setTextIfChanged(VisageText* text, const char* s, int32_t length);
 void VisageText_setTextU32(VisageText* text, const char32_t* s);
 void VisageText_setTextU32WithLength(VisageText* text, const char32_t* s, int32_t length);
 // `string_length` returns the number of characters in the string, not including any null-termination.
@@ -234,9 +556,65 @@ enum VisageDirection {
   Down,
 };
 
+// The parameters each command reads from `VisageShapeCommand::values` are listed next to it, in the
+// same order as the matching `VisageCanvas_*` function.
+typedef enum VisageShapeCommandType {
+    VisageShapeCommandSetColor,                 // blue, green, red, alpha, hdr
+    VisageShapeCommandSetBrush,                 // `flags` is an index into the batch's brush table
+    VisageShapeCommandFill,                     // x, y, width, height
+    VisageShapeCommandCircle,                   // x, y, width
+    VisageShapeCommandFadeCircle,               // x, y, width, pixel_width
+    VisageShapeCommandRing,                     // x, y, width, thickness
+    VisageShapeCommandSquircle,                 // x, y, width, power
+    VisageShapeCommandSuperEllipse,             // x, y, width, height, power
+    VisageShapeCommandArc,                      // x, y, width, thickness, center_radians, radians
+    VisageShapeCommandArcShadow,                // x, y, width, thickness, center_radians, radians, shadow_width
+    VisageShapeCommandSegment,                  // a_x, a_y, b_x, b_y, thickness
+    VisageShapeCommandQuadratic,                // a_x, a_y, b_x, b_y, c_x, c_y, thickness
+    VisageShapeCommandRectangle,                // x, y, width, height
+    VisageShapeCommandRectangleBorder,          // x, y, width, height, thickness
+    VisageShapeCommandRoundedRectangle,         // x, y, width, height, rounding
+    VisageShapeCommandLeftRoundedRectangle,     // x, y, width, height, rounding
+    VisageShapeCommandRightRoundedRectangle,    // x, y, width, height, rounding
+    VisageShapeCommandTopRoundedRectangle,      // x, y, width, height, rounding
+    VisageShapeCommandBottomRoundedRectangle,   // x, y, width, height, rounding
+    VisageShapeCommandRectangleShadow,          // x, y, width, height, blur_radius
+    VisageShapeCommandRoundedRectangleShadow,   // x, y, width, height, rounding, blur_radius
+    VisageShapeCommandRoundedRectangleBorder,   // x, y, width, height, rounding, thickness
+    VisageShapeCommandDiamond,                  // x, y, width, rounding
+    VisageShapeCommandTriangle,                 // a_x, a_y, b_x, b_y, c_x, c_y
+    VisageShapeCommandTriangleBorder,           // a_x, a_y, b_x, b_y, c_x, c_y, thickness
+    VisageShapeCommandRoundedTriangle,          // a_x, a_y, b_x, b_y, c_x, c_y, rounding
+    VisageShapeCommandRoundedTriangleBorder,    // a_x, a_y, b_x, b_y, c_x, c_y, rounding, thickness
+    VisageShapeCommandDirectionalTriangle,      // x, y, width; `flags` is a `VisageDirection`
+    VisageShapeCommandSetPosition,              // x, y
+    VisageShapeCommandSaveState,
+    VisageShapeCommandRestoreState,
+    VisageShapeCommandSetClampBounds,           // x, y, width, height
+    VisageShapeCommandTrimClampBounds,          // x, y, width, height
+    VisageNumShapeCommandTypes,
+} VisageShapeCommandType;
+
+// Set in `VisageShapeCommand::flags` on arc, arc shadow and segment commands to draw rounded ends.
+#define VISAGE_SHAPE_COMMAND_ROUNDED 0x1
+
+// One fixed-size record of a packed shape command stream. See `VisageShapeCommandType` for the
+// meaning of `flags` and `values` per command.
+typedef struct VisageShapeCommand {
+    uint32_t type;
+    uint32_t flags;
+    float values[8];
+} VisageShapeCommand;
+
 struct VisageCanvas_t;
 typedef struct VisageCanvas_t VisageCanvas;
 
+// A recorded sequence of canvas draw calls that can be replayed many times. Colors are converted and
+// brushes, text and lines are copied at record time, so later changes to those objects do not
+// affect the recording.
+struct VisageDisplayList_t;
+typedef struct VisageDisplayList_t VisageDisplayList;
+
 VisageCanvas* VisageCanvas_new();
 void VisageCanvas_destroy(VisageCanvas* canvas);
 
@@ -246,7 +624,8 @@ void VisageCanvas_setDpiScale(VisageCanvas* canvas, float scale);
 void VisageCanvas_setNativePixelScale(VisageCanvas* canvas);
 void VisageCanvas_setLogicalPixelScale(VisageCanvas* canvas);
 void VisageCanvas_clearDrawnShapes(VisageCanvas* canvas);
-void VisageCanvas_submit(VisageCanvas* canvas, int32_t submit_pass);
+// Returns false without submitting if idle frame elision found nothing changed.
+bool VisageCanvas_submit(VisageCanvas* canvas, int32_t submit_pass);
 void VisageCanvas_updateTime(VisageCanvas* canvas, double time);
 void VisageCanvas_setWindowless(VisageCanvas* canvas, int32_t width, int32_t height);
 void VisageCanvas_removeFromWindow(VisageCanvas* canvas);
@@ -257,8 +636,79 @@ double VisageCanvas_time(VisageCanvas* canvas);
 double VisageCanvas_deltaTime(VisageCanvas* canvas);
 int32_t VisageCanvas_frameCount(VisageCanvas* canvas);
 
+// Asynchronous submit. While it is on, draw calls are recorded into a frame that
+// `VisageCanvas_submitAsync` hands to the render thread, which replays and submits it while the next
+// frame is drawn. `VisageCanvas_submit` then does the same without returning the fence. Switch it
+// between frames; turning it off waits for submitted frames and drops anything drawn since. One
+// render thread serves every canvas, and it, synchronous submits and font measuring and prewarming
+// take turns with one lock, since visage's renderer and glyph atlases aren't thread safe. Frames
+// keep the image, svg and layer pixels they draw until they are submitted, and copy mapped command
+// streams. Canvases start out asynchronous when built with VISAGE_ENABLE_BACKGROUND_GRAPHICS_THREAD.
+void VisageCanvas_setAsyncSubmit(VisageCanvas* canvas, bool enabled);
+bool VisageCanvas_isAsyncSubmit(const VisageCanvas* canvas);
+// Most frames that may be queued or being submitted at once, 1 by default. Submitting another one
+// blocks until the oldest is done.
+void VisageCanvas_setFramesInFlight(VisageCanvas* canvas, int32_t frames);
+// Submits the frame and returns a fence that completes once the render thread has submitted it.
+// Without asynchronous submit the frame is submitted right away and its fence is already complete.
+uint64_t VisageCanvas_submitAsync(VisageCanvas* canvas, int32_t submit_pass);
+bool VisageCanvas_isFenceComplete(VisageCanvas* canvas, uint64_t fence);
+void VisageCanvas_waitForFence(VisageCanvas* canvas, uint64_t fence);
+// Waits until every submitted frame is done.
+void VisageCanvas_waitForIdle(VisageCanvas* canvas);
+
+// Idle frame elision. While enabled, the canvas hashes what is drawn on it since
+// `VisageCanvas_clearDrawnShapes`, including line points, text and which pixels images, svgs and
+// layers show. Hashing costs time on every draw call, proportional to the points of lines drawn. A
+// frame that hashes the same as the last submitted one, at the same size and dpi scale, isn't
+// submitted: `VisageCanvas_submit` returns false and `VisageCanvas_submitAsync` returns the last
+// frame's fence. Off by default; nothing is hashed while it is off.
+void VisageCanvas_setIdleFrameElision(VisageCanvas* canvas, bool enabled);
+// Set while shaders drawn read the canvas time, which then also has to be unchanged to skip a frame.
+void VisageCanvas_setTimeDependent(VisageCanvas* canvas, bool time_dependent);
+// Submits the next frame even if it looks unchanged, for changes the hash can't see.
+void VisageCanvas_requestRedraw(VisageCanvas* canvas);
+
+// What the frame drawn since the last `VisageCanvas_clearDrawnShapes` costs. Counts cover draw
+// calls, including display lists and recording contexts, but not mapped command streams. Upload
+// bytes are estimates of what visage's atlases have to take in for this frame: gradients, glyphs
+// and image pixels that weren't used in the previous frame. Counting is compiled out, leaving every
+// field zero, when VISAGE_GRAPHICS_C_FRAME_STATS is turned off.
+typedef struct VisageFrameStats {
+    // Calls per VisageShapeCommandType, state changes included.
+    uint32_t commands[VisageNumShapeCommandTypes];
+    uint32_t lines;
+    uint32_t line_fills;
+    uint32_t texts;
+    // Pixel rectangles drawn by images, svgs and layers.
+    uint32_t images;
+    // Runs of consecutive draws of the same kind, which visage can draw in one batch.
+    uint32_t batches;
+    // Shapes, lines, text and pixel rectangles handed to visage.
+    uint32_t draw_calls;
+    uint32_t text_glyphs;
+    uint64_t gradient_upload_bytes;
+    uint64_t glyph_upload_bytes;
+    uint64_t image_upload_bytes;
+    // Time spent inside this canvas's draw calls since the clear, including converting image tiles
+    // and rasterizing svgs and layers. Time between draw calls and in recording contexts isn't.
+    double frame_seconds;
+    // The rest is set at submit and kept until the next submit. Submitting is the time visage took,
+    // on the render thread while submit is asynchronous.
+    double submit_seconds;
+    // Bytes this library held for the frame at submit: recorded and captured commands, recording
+    // contexts and the rasters kept alive for it. Visage's own buffers aren't included.
+    uint64_t peak_frame_bytes;
+    // Set if idle frame elision skipped submitting the frame.
+    bool elided;
+} VisageFrameStats;
+
+void VisageCanvas_getFrameStats(const VisageCanvas* canvas, VisageFrameStats* stats);
+
 void VisageCanvas_setColor(VisageCanvas* canvas, VisageColor color);
 void VisageCanvas_setBrush(VisageCanvas* canvas, const VisageBrush* brush);
+// Sets the brush to the palette brush `id` without copying it first. Unknown ids are ignored.
+void VisageCanvas_setBrushId(VisageCanvas* canvas, int32_t id);
 
 void VisageCanvas_fill(VisageCanvas* canvas, float x, float y, float width, float height);
 void VisageCanvas_circle(VisageCanvas* canvas, float x, float y, float width);
@@ -267,6 +717,9 @@ void VisageCanvas_ring(VisageCanvas* canvas, float x, float y, float width, floa
 void VisageCanvas_squircle(VisageCanvas* canvas, float x, float y, float width, float power);
 void VisageCanvas_squircleBorder(VisageCanvas* canvas, float x, float y, float width, float power, float thickness);
 void VisageCanvas_superEllipse(VisageCanvas* canvas, float x, float y, float width, float height, float power);
+// Arcs are drawn around the circle `width` across at `x`, `y`, `thickness` thick inside its edge.
+// `center_radians` is measured clockwise from straight up and the arc covers `radians` on either
+// side of it.
 void VisageCanvas_roundedArc(VisageCanvas* canvas, float x, float y, float width, float thickness, float center_radians, float radians);
 void VisageCanvas_flatArc(VisageCanvas* canvas, float x, float y, float width, float thickness, float center_radians, float radians);
 void VisageCanvas_arc(VisageCanvas* canvas, float x, float y, float width, float thickness, float center_radians, float radians, bool rounded);
@@ -277,6 +730,14 @@ void VisageCanvas_quadratic(VisageCanvas* canvas, float a_x, float a_y, float b_
 void VisageCanvas_rectangle(VisageCanvas* canvas, float x, float y, float width, float height);
 void VisageCanvas_rectangleBorder(VisageCanvas* canvas, float x, float y, float width, float height, float thickness);
 void VisageCanvas_roundedRectangle(VisageCanvas* canvas, float x, float y, float width, float height, float rounding);
+
+// Instanced forms of the shapes above for drawing many at once. Each parameter is an array with
+// one value per instance. `argb` holds optional 0xAARRGGBB colors per instance; when it is null
+// every instance uses the current color or brush, otherwise the color is restored afterwards.
+void VisageCanvas_circles(VisageCanvas* canvas, const float* x, const float* y, const float* width, const uint32_t* argb, int32_t count);
+void VisageCanvas_rectangles(VisageCanvas* canvas, const float* x, const float* y, const float* width, const float* height, const uint32_t* argb, int32_t count);
+void VisageCanvas_roundedRectangles(VisageCanvas* canvas, const float* x, const float* y, const float* width, const float* height, float rounding, const uint32_t* argb, int32_t count);
+
 void VisageCanvas_diamond(VisageCanvas* canvas, float x, float y, float width, float rounding);
 void VisageCanvas_leftRoundedRectangle(VisageCanvas* canvas, float x, float y, float width, float height, float rounding);
 void VisageCanvas_rightRoundedRectangle(VisageCanvas* canvas, float x, float y, float width, float height, float rounding);
@@ -296,16 +757,150 @@ void VisageCanvas_triangleDown(VisageCanvas* canvas, float triangle_x, float tri
 
 void VisageCanvas_line(VisageCanvas* canvas, VisageLine* line, float x, float y, float width, float height, float line_width);
 void VisageCanvas_lineFill(VisageCanvas* canvas, VisageLine* line, float x, float y, float width, float height, float fill_position);
+// Draws every series of `series` with one `VisageCanvas_line` call per series, each with its own
+// brush. The canvas's brush is left as it was.
+void VisageCanvas_lineSeries(VisageCanvas* canvas, VisageLineSeries* series, float x, float y, float width, float height, float line_width);
+// Consumes the newest window of `feed` and draws it like `VisageCanvas_line`.
+void VisageCanvas_lineFeed(VisageCanvas* canvas, VisageLineFeed* feed, float x, float y, float width, float height, float line_width);
+// Draws `count` samples of `pyramid` from `start` as a line stretched across `width`, laid out like
+// `VisageLinePyramid_layout`. Each draw keeps its own copy of the points until the next clear, so a
+// pyramid can be drawn several times in a frame.
+void VisageCanvas_linePyramid(VisageCanvas* canvas, VisageLinePyramid* pyramid, int32_t start, int32_t count, float x, float y, float width, float height, float line_width);
+
+// Draws `image` at its pixel size. Images aren't recorded into display lists or captured command
+// streams and are skipped while recording one. Recording contexts keep them until their parent
+// submits.
+void VisageCanvas_image(VisageCanvas* canvas, VisageImage* image, float x, float y);
+
+// Draws `svg` scaled to fit `width` x `height` and centered. Like images, svgs are skipped while
+// recording a display list and aren't captured.
+void VisageCanvas_svg(VisageCanvas* canvas, VisageSvg* svg, float x, float y, float width, float height);
+// Draws many svgs at once, one per index of the arrays. Rasters missing from the cache are made in
+// parallel before any of them is drawn.
+void VisageCanvas_svgs(VisageCanvas* canvas, const VisageSvg* const* svgs, const float* x, const float* y, const float* width, const float* height, int32_t count);
+
+// Invalidates `layer` and, until `VisageCanvas_endRecording` is called, records draw, color, brush,
+// position and state calls on `canvas` into it instead of drawing them.
+void VisageCanvas_beginLayer(VisageCanvas* canvas, VisageLayer* layer);
+// Composites `layer` with its origin at `x`, `y`, rasterizing it first if it has no pixels at the
+// canvas's dpi scale. Like images, layers are skipped while recording a display list. Command
+// capture records what was drawn into the layer.
+void VisageCanvas_drawLayer(VisageCanvas* canvas, VisageLayer* layer, float x, float y);
 
 void VisageCanvas_text(VisageCanvas* canvas, VisageText* text, float x, float y, float width, float height, int32_t direction);
 
+// Replays a packed stream of shape commands in order, as if each `VisageCanvas_*` function had been
+// called individually. `brushes` is the table `VisageShapeCommandSetBrush` commands index into and
+// may be null if the stream has none. Commands with an unknown type or brush index are skipped.
+void VisageCanvas_drawBatch(VisageCanvas* canvas, const VisageShapeCommand* commands, int32_t num_commands, const VisageBrush* const* brushes, int32_t num_brushes);
+
+// Until `VisageCanvas_endRecording` is called, draw, color, brush, position and state calls on
+// `canvas` are appended to `list` instead of being drawn. `list` must outlive the recording.
+void VisageCanvas_beginRecording(VisageCanvas* canvas, VisageDisplayList* list);
+void VisageCanvas_endRecording(VisageCanvas* canvas);
+// Replays `list` offset by `x` and `y`. The canvas state is restored afterwards.
+void VisageCanvas_drawDisplayList(VisageCanvas* canvas, const VisageDisplayList* list, float x, float y);
+
+// Creates a canvas that only records, so a panel can be drawn on another thread while other panels
+// are drawn elsewhere. Every draw, state and recording call works on it, including images, svgs,
+// layers and command streams, each context having its own position, clamp bounds and state. When
+// `parent` submits, what the contexts recorded is drawn into it, clamped to their bounds, in order
+// of `order` and then of creation, and the contexts are cleared for the next frame. Recording has to
+// be done by then. Create, place and destroy contexts on the thread that owns `parent`; destroy them
+// with `VisageCanvas_destroy`. A context made from another context is drawn into that context's
+// parent. Window, dimension, dpi, submit, fence, time, capture and dirty rect calls do nothing on a
+// context and return false, zero or an empty result; `VisageCanvas_isRectDirty` returns true and
+// `VisageCanvas_dpiScale` returns the parent's scale.
+VisageCanvas* VisageCanvas_newRecordingContext(VisageCanvas* parent, int32_t order);
+// Places what the context records at `x`, `y` in its parent, clamped to `width` x `height`. Empty
+// bounds don't clamp.
+void VisageCanvas_setRecordingBounds(VisageCanvas* context, float x, float y, float width, float height);
+
+// While enabled, everything drawn on `canvas` since the last `VisageCanvas_clearDrawnShapes` is kept
+// so it can be written out with `VisageCanvas_saveCommands`.
+void VisageCanvas_setCommandCapture(VisageCanvas* canvas, bool capture);
+// Writes the captured commands to `path` as a command stream. Returns false if capture isn't enabled
+// or the file couldn't be written.
+bool VisageCanvas_saveCommands(const VisageCanvas* canvas, const char* path);
+// Draws a command stream, usually a memory mapped file written by `VisageCanvas_saveCommands`.
+// `data` must be 8 byte aligned and stay valid until the next `VisageCanvas_clearDrawnShapes`.
+// Returns false without drawing anything if the stream is malformed.
+bool VisageCanvas_replayMapped(VisageCanvas* canvas, const void* data, size_t size);
+
 void VisageCanvas_saveState(VisageCanvas* canvas);
 void VisageCanvas_restoreState(VisageCanvas* canvas);
 
 void VisageCanvas_setPosition(VisageCanvas* canvas, float x, float y);
 
-//void VisageCanvas_setClampBounds(VisageCanvas* canvas, float x, float y, float width, float height);
-//void VisageCanvas_trimClampBounds(VisageCanvas* canvas, int32_t x, int32_t y, int32_t width, int32_t height);
+// Limits drawing to the given rectangle, relative to the current position. Trimming intersects the
+// rectangle with the current clamp bounds. Both are part of the saved state.
+void VisageCanvas_setClampBounds(VisageCanvas* canvas, float x, float y, float width, float height);
+void VisageCanvas_trimClampBounds(VisageCanvas* canvas, float x, float y, float width, float height);
+
+// Marks a rectangle, in window coordinates, as needing a redraw. The dirty set is only a hint for
+// the caller: every draw call is still drawn, since visage composites the whole frame and anything
+// left out would disappear from the window. The dirty set is emptied after `VisageCanvas_submit`.
+void VisageCanvas_invalidateRect(VisageCanvas* canvas, float x, float y, float width, float height);
+// Returns true if a rectangle, relative to the current position, touches the dirty set, or if
+// nothing has been invalidated. Useful to skip recomputing widgets that haven't changed; they still
+// have to be drawn, for example from a cached display list.
+bool VisageCanvas_isRectDirty(const VisageCanvas* canvas, float x, float y, float width, float height);
+// Copies up to `max_rects` merged dirty rectangles as x, y, width, height into `rects` and returns
+// the total number of rectangles.
+int32_t VisageCanvas_dirtyRects(const VisageCanvas* canvas, float* rects, int32_t max_rects);
+
+// -- Display List ---------------------------------------------------------------------------------
+
+VisageDisplayList* VisageDisplayList_new();
+void VisageDisplayList_delete(VisageDisplayList* list);
+
+void VisageDisplayList_clear(VisageDisplayList* list);
+int32_t VisageDisplayList_numCommands(const VisageDisplayList* list);
+
+// -- Command Stream -------------------------------------------------------------------------------
+
+// Reads the canvas size a command stream was captured at. Returns false if `data` isn't a command stream.
+bool VisageCommandStream_dimensions(const void* data, size_t size, int32_t* width, int32_t* height, float* dpi_scale);
+
+// -- Software Raster ------------------------------------------------------------------------------
+
+// A CPU framebuffer that display lists and captured canvas commands can be drawn into without a
+// GPU, for tests, thumbnails and previews. The target is split into square tiles that are shaded
+// in parallel. Shapes, lines and brushes are drawn; text is skipped and counted in the stats.
+struct VisageSoftwareRaster_t;
+typedef struct VisageSoftwareRaster_t VisageSoftwareRaster;
+
+typedef struct VisageSoftwareRasterStats {
+    // Square tiles the target is split into.
+    int32_t tiles;
+    // Numbers from the last draw call.
+    int32_t shapes;
+    int32_t skipped;
+    // Shapes summed over every tile they were shaded in.
+    int64_t tile_shapes;
+    double seconds;
+} VisageSoftwareRasterStats;
+
+// The target starts out transparent.
+VisageSoftwareRaster* VisageSoftwareRaster_new(int32_t width, int32_t height);
+void VisageSoftwareRaster_delete(VisageSoftwareRaster* raster);
+
+int32_t VisageSoftwareRaster_width(const VisageSoftwareRaster* raster);
+int32_t VisageSoftwareRaster_height(const VisageSoftwareRaster* raster);
+// Multiplies every coordinate and size drawn, like a canvas's dpi scale. Defaults to 1.
+void VisageSoftwareRaster_setScale(VisageSoftwareRaster* raster, float scale);
+void VisageSoftwareRaster_clear(VisageSoftwareRaster* raster, uint32_t argb);
+
+// Draws `list` offset by `x` and `y` over what is already in the target.
+void VisageSoftwareRaster_drawDisplayList(VisageSoftwareRaster* raster, const VisageDisplayList* list, float x, float y);
+// Draws what `canvas` captured since its last `VisageCanvas_clearDrawnShapes`. Returns false if
+// command capture isn't enabled on `canvas`.
+bool VisageSoftwareRaster_drawCapture(VisageSoftwareRaster* raster, const VisageCanvas* canvas);
+
+// Returns `width * height` 0xAARRGGBB pixels, row by row. The pointer stays valid until the next
+// draw, clear or delete.
+const uint32_t* VisageSoftwareRaster_pixels(VisageSoftwareRaster* raster);
+void VisageSoftwareRaster_getStats(const VisageSoftwareRaster* raster, VisageSoftwareRasterStats* stats);
 
 #ifdef __cplusplus
 }
@@ -20,7 +20,7 @@ struct App {
 
 struct WindowState {
     canvas: Canvas,
-    font: Font,
+    text: Text,
     window: Window,
 }
 
@@ -43,11 +43,14 @@ impl ApplicationHandler for App {
 
             window.request_redraw();
 
-            let font = Font::new_lato_regular(16.0, 1.0);
+            let font = Font::new_lato_regular(16.0, dpi_scale);
+            let mut text = Text::new(&font);
+            text.set_text(utf32str!("Hello World!"));
+            text.set_justification(Justification::LEFT);
 
             self.state = Some(WindowState {
                 window,
-                font,
+                text,
                 canvas,
             });
         }
@@ -85,12 +88,9 @@ impl ApplicationHandler for App {
 
                 state.canvas.set_color(Color::WHITE);
 
-                let mut text = Text::new(&state.font);
-                text.set_text(utf32str!("Hello World!"));
-                text.set_justification(Justification::LEFT);
                 state
                     .canvas
-                    .text(&text, 20.0, 20.0, 100.0, 30.0, Direction::default());
+                    .text(&state.text, 20.0, 20.0, 100.0, 30.0, Direction::default());
 
                 // Notify that you're about to draw.
                 state.window.pre_present_notify();
@@ -120,7 +120,8 @@ impl ApplicationHandler for App {
                 };
 
                 state.canvas.set_dpi_scale(scale_factor as f32);
-                state.font = state.font.with_dpi_scale(scale_factor as f32);
+                let font = state.text.font().with_dpi_scale(scale_factor as f32);
+                state.text.set_font(&font);
 
                 state.window.request_redraw();
             }
@@ -0,0 +1,471 @@
+use std::marker::PhantomData;
+
+use visage_graphics_sys::{VisageBrush, VisageShapeCommand, VisageShapeCommandType};
+
+use crate::{brush::Brush, color::Color, text::Direction};
+
+/// A packed stream of shape commands drawn with a single call to `Canvas::draw_batch`.
+/// Filling the batch does not cross the FFI boundary.
+pub struct ShapeBatch<'a> {
+    commands: Vec<VisageShapeCommand>,
+    brushes: Vec<*const VisageBrush>,
+    _brushes: PhantomData<&'a Brush>,
+}
+
+impl<'a> ShapeBatch<'a> {
+    pub fn new() -> Self {
+        Self {
+            commands: Vec::new(),
+            brushes: Vec::new(),
+            _brushes: PhantomData,
+        }
+    }
+
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self {
+            commands: Vec::with_capacity(capacity),
+            brushes: Vec::new(),
+            _brushes: PhantomData,
+        }
+    }
+
+    pub fn clear(&mut self) {
+        self.commands.clear();
+        self.brushes.clear();
+    }
+
+    pub fn len(&self) -> usize {
+        self.commands.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.commands.is_empty()
+    }
+
+    pub fn commands(&self) -> &[VisageShapeCommand] {
+        &self.commands
+    }
+
+    pub(crate) fn brushes(&self) -> &[*const VisageBrush] {
+        &self.brushes
+    }
+
+    fn push(&mut self, command_type: VisageShapeCommandType, flags: u32, params: &[f32]) {
+        let mut values = [0.0; 8];
+        values[..params.len()].copy_from_slice(params);
+
+        self.commands.push(VisageShapeCommand {
+            type_: command_type as u32,
+            flags,
+            values,
+        });
+    }
+
+    pub fn set_color(&mut self, color: impl Into<Color>) {
+        let color = color.into().raw();
+        let [b, g, r, a] = color.values;
+
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandSetColor,
+            0,
+            &[b, g, r, a, color.hdr],
+        );
+    }
+
+    pub fn set_brush(&mut self, brush: &'a Brush) {
+        let ptr = brush.raw().as_ptr() as *const VisageBrush;
+
+        let index = match self.brushes.iter().rposition(|&b| b == ptr) {
+            Some(index) => index,
+            None => {
+                self.brushes.push(ptr);
+                self.brushes.len() - 1
+            }
+        };
+
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandSetBrush,
+            index as u32,
+            &[],
+        );
+    }
+
+    pub fn fill(&mut self, x: f32, y: f32, width: f32, height: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandFill,
+            0,
+            &[x, y, width, height],
+        );
+    }
+
+    pub fn circle(&mut self, x: f32, y: f32, width: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandCircle,
+            0,
+            &[x, y, width],
+        );
+    }
+
+    pub fn fade_circle(&mut self, x: f32, y: f32, width: f32, pixel_width: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandFadeCircle,
+            0,
+            &[x, y, width, pixel_width],
+        );
+    }
+
+    pub fn ring(&mut self, x: f32, y: f32, width: f32, thickness: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRing,
+            0,
+            &[x, y, width, thickness],
+        );
+    }
+
+    pub fn squircle(&mut self, x: f32, y: f32, width: f32, power: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandSquircle,
+            0,
+            &[x, y, width, power],
+        );
+    }
+
+    pub fn super_ellipse(&mut self, x: f32, y: f32, width: f32, height: f32, power: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandSuperEllipse,
+            0,
+            &[x, y, width, height, power],
+        );
+    }
+
+    pub fn arc(
+        &mut self,
+        x: f32,
+        y: f32,
+        width: f32,
+        thickness: f32,
+        center_radians: f32,
+        radians: f32,
+        rounded: bool,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandArc,
+            rounded_flag(rounded),
+            &[x, y, width, thickness, center_radians, radians],
+        );
+    }
+
+    pub fn arc_shadow(
+        &mut self,
+        x: f32,
+        y: f32,
+        width: f32,
+        thickness: f32,
+        center_radians: f32,
+        radians: f32,
+        shadow_width: f32,
+        rounded: bool,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandArcShadow,
+            rounded_flag(rounded),
+            &[
+                x,
+                y,
+                width,
+                thickness,
+                center_radians,
+                radians,
+                shadow_width,
+            ],
+        );
+    }
+
+    pub fn segment(
+        &mut self,
+        a_x: f32,
+        a_y: f32,
+        b_x: f32,
+        b_y: f32,
+        thickness: f32,
+        rounded: bool,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandSegment,
+            rounded_flag(rounded),
+            &[a_x, a_y, b_x, b_y, thickness],
+        );
+    }
+
+    pub fn quadratic(
+        &mut self,
+        a_x: f32,
+        a_y: f32,
+        b_x: f32,
+        b_y: f32,
+        c_x: f32,
+        c_y: f32,
+        thickness: f32,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandQuadratic,
+            0,
+            &[a_x, a_y, b_x, b_y, c_x, c_y, thickness],
+        );
+    }
+
+    pub fn rectangle(&mut self, x: f32, y: f32, width: f32, height: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRectangle,
+            0,
+            &[x, y, width, height],
+        );
+    }
+
+    pub fn rectangle_border(&mut self, x: f32, y: f32, width: f32, height: f32, thickness: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRectangleBorder,
+            0,
+            &[x, y, width, height, thickness],
+        );
+    }
+
+    pub fn rounded_rectangle(&mut self, x: f32, y: f32, width: f32, height: f32, rounding: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRoundedRectangle,
+            0,
+            &[x, y, width, height, rounding],
+        );
+    }
+
+    pub fn left_rounded_rectangle(
+        &mut self,
+        x: f32,
+        y: f32,
+        width: f32,
+        height: f32,
+        rounding: f32,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandLeftRoundedRectangle,
+            0,
+            &[x, y, width, height, rounding],
+        );
+    }
+
+    pub fn right_rounded_rectangle(
+        &mut self,
+        x: f32,
+        y: f32,
+        width: f32,
+        height: f32,
+        rounding: f32,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRightRoundedRectangle,
+            0,
+            &[x, y, width, height, rounding],
+        );
+    }
+
+    pub fn top_rounded_rectangle(
+        &mut self,
+        x: f32,
+        y: f32,
+        width: f32,
+        height: f32,
+        rounding: f32,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandTopRoundedRectangle,
+            0,
+            &[x, y, width, height, rounding],
+        );
+    }
+
+    pub fn bottom_rounded_rectangle(
+        &mut self,
+        x: f32,
+        y: f32,
+        width: f32,
+        height: f32,
+        rounding: f32,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandBottomRoundedRectangle,
+            0,
+            &[x, y, width, height, rounding],
+        );
+    }
+
+    pub fn rectangle_shadow(&mut self, x: f32, y: f32, width: f32, height: f32, blur_radius: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRectangleShadow,
+            0,
+            &[x, y, width, height, blur_radius],
+        );
+    }
+
+    pub fn rounded_rectangle_shadow(
+        &mut self,
+        x: f32,
+        y: f32,
+        width: f32,
+        height: f32,
+        rounding: f32,
+        blur_radius: f32,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRoundedRectangleShadow,
+            0,
+            &[x, y, width, height, rounding, blur_radius],
+        );
+    }
+
+    pub fn rounded_rectangle_border(
+        &mut self,
+        x: f32,
+        y: f32,
+        width: f32,
+        height: f32,
+        rounding: f32,
+        thickness: f32,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRoundedRectangleBorder,
+            0,
+            &[x, y, width, height, rounding, thickness],
+        );
+    }
+
+    pub fn diamond(&mut self, x: f32, y: f32, width: f32, rounding: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandDiamond,
+            0,
+            &[x, y, width, rounding],
+        );
+    }
+
+    pub fn triangle(&mut self, a_x: f32, a_y: f32, b_x: f32, b_y: f32, c_x: f32, c_y: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandTriangle,
+            0,
+            &[a_x, a_y, b_x, b_y, c_x, c_y],
+        );
+    }
+
+    pub fn triangle_border(
+        &mut self,
+        a_x: f32,
+        a_y: f32,
+        b_x: f32,
+        b_y: f32,
+        c_x: f32,
+        c_y: f32,
+        thickness: f32,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandTriangleBorder,
+            0,
+            &[a_x, a_y, b_x, b_y, c_x, c_y, thickness],
+        );
+    }
+
+    pub fn rounded_triangle(
+        &mut self,
+        a_x: f32,
+        a_y: f32,
+        b_x: f32,
+        b_y: f32,
+        c_x: f32,
+        c_y: f32,
+        rounding: f32,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRoundedTriangle,
+            0,
+            &[a_x, a_y, b_x, b_y, c_x, c_y, rounding],
+        );
+    }
+
+    pub fn rounded_triangle_border(
+        &mut self,
+        a_x: f32,
+        a_y: f32,
+        b_x: f32,
+        b_y: f32,
+        c_x: f32,
+        c_y: f32,
+        rounding: f32,
+        thickness: f32,
+    ) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRoundedTriangleBorder,
+            0,
+            &[a_x, a_y, b_x, b_y, c_x, c_y, rounding, thickness],
+        );
+    }
+
+    pub fn directional_triangle(&mut self, x: f32, y: f32, width: f32, direction: Direction) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandDirectionalTriangle,
+            direction as u32,
+            &[x, y, width],
+        );
+    }
+
+    pub fn set_position(&mut self, x: f32, y: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandSetPosition,
+            0,
+            &[x, y],
+        );
+    }
+
+    pub fn save_state(&mut self) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandSaveState,
+            0,
+            &[],
+        );
+    }
+
+    pub fn restore_state(&mut self) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandRestoreState,
+            0,
+            &[],
+        );
+    }
+
+    pub fn set_clamp_bounds(&mut self, x: f32, y: f32, width: f32, height: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandSetClampBounds,
+            0,
+            &[x, y, width, height],
+        );
+    }
+
+    pub fn trim_clamp_bounds(&mut self, x: f32, y: f32, width: f32, height: f32) {
+        self.push(
+            visage_graphics_sys::VisageShapeCommandType_VisageShapeCommandTrimClampBounds,
+            0,
+            &[x, y, width, height],
+        );
+    }
+}
+
+impl Default for ShapeBatch<'_> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+#[inline]
+fn rounded_flag(rounded: bool) -> u32 {
+    if rounded {
+        visage_graphics_sys::VISAGE_SHAPE_COMMAND_ROUNDED
+    } else {
+        0
+    }
+}
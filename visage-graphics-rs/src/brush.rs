@@ -104,11 +104,64 @@ impl Brush {
         }
     }
 
+    /// Registers a copy of this brush in the shared palette. Identical brushes share one entry.
+    pub fn register(&self) -> BrushId {
+        BrushId(unsafe { visage_graphics_sys::VisageBrushPalette_register(self.ptr.as_ptr()) })
+    }
+
     pub fn raw(&self) -> NonNull<visage_graphics_sys::VisageBrush> {
         self.ptr
     }
 }
 
+/// A reference to a brush in the shared palette, set with `Canvas::set_brush_id`. The reference is
+/// released when this is dropped.
+#[derive(Debug, PartialEq, Eq, Hash)]
+pub struct BrushId(i32);
+
+impl BrushId {
+    pub fn raw(&self) -> i32 {
+        self.0
+    }
+}
+
+impl Drop for BrushId {
+    fn drop(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageBrushPalette_release(self.0);
+        }
+    }
+}
+
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct BrushPaletteStats {
+    pub brushes: usize,
+    pub references: usize,
+    /// Distinct gradients among the brushes, each taking one row of the gradient atlas.
+    pub gradients: usize,
+    pub gradient_stops: usize,
+}
+
+pub fn palette_stats() -> BrushPaletteStats {
+    let mut stats = visage_graphics_sys::VisageBrushPaletteStats {
+        brushes: 0,
+        references: 0,
+        gradients: 0,
+        gradient_stops: 0,
+    };
+
+    unsafe {
+        visage_graphics_sys::VisageBrushPalette_getStats(&mut stats);
+    }
+
+    BrushPaletteStats {
+        brushes: stats.brushes as usize,
+        references: stats.references as usize,
+        gradients: stats.gradients as usize,
+        gradient_stops: stats.gradient_stops as usize,
+    }
+}
+
 impl Default for Brush {
     fn default() -> Self {
         Self::new()
@@ -1,11 +1,80 @@
-use std::ptr::NonNull;
+use std::{
+    ffi::CString,
+    ops::{Deref, DerefMut},
+    path::Path,
+    ptr::NonNull,
+};
 
 use crate::{
-    brush::Brush,
+    batch::ShapeBatch,
+    brush::{Brush, BrushId},
     color::Color,
+    display_list::DisplayList,
+    image::{Image, ImagePixel},
+    layer::Layer,
+    line::Line,
+    line_feed::LineFeed,
+    line_pyramid::LinePyramid,
+    line_series::LineSeries,
+    software_raster::SoftwareRaster,
+    svg::Svg,
     text::{Direction, Text},
 };
 
+/// Number of shape command types counted in `FrameStats::commands`.
+pub const NUM_COMMAND_TYPES: usize =
+    visage_graphics_sys::VisageShapeCommandType_VisageNumShapeCommandTypes as usize;
+
+/// What the frame drawn since the last `clear_drawn_shapes` costs. Upload bytes are estimates of
+/// what visage's atlases take in for the frame. Everything is zero if the library was built without
+/// frame stats.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct FrameStats {
+    /// Calls per `VisageShapeCommandType`, state changes included.
+    pub commands: [u32; NUM_COMMAND_TYPES],
+    pub lines: u32,
+    pub line_fills: u32,
+    pub texts: u32,
+    /// Pixel rectangles drawn by images, svgs and layers.
+    pub images: u32,
+    /// Runs of consecutive draws of the same kind, which visage can draw in one batch.
+    pub batches: u32,
+    /// Shapes, lines, text and pixel rectangles handed to visage.
+    pub draw_calls: u32,
+    pub text_glyphs: u32,
+    pub gradient_upload_bytes: u64,
+    pub glyph_upload_bytes: u64,
+    pub image_upload_bytes: u64,
+    /// Time spent inside the canvas's draw calls since the clear.
+    pub frame_seconds: f64,
+    pub submit_seconds: f64,
+    pub peak_frame_bytes: u64,
+    /// Set if idle frame elision skipped submitting the frame.
+    pub elided: bool,
+}
+
+impl Default for FrameStats {
+    fn default() -> Self {
+        Self {
+            commands: [0; NUM_COMMAND_TYPES],
+            lines: 0,
+            line_fills: 0,
+            texts: 0,
+            images: 0,
+            batches: 0,
+            draw_calls: 0,
+            text_glyphs: 0,
+            gradient_upload_bytes: 0,
+            glyph_upload_bytes: 0,
+            image_upload_bytes: 0,
+            frame_seconds: 0.0,
+            submit_seconds: 0.0,
+            peak_frame_bytes: 0,
+            elided: false,
+        }
+    }
+}
+
 pub struct Canvas {
     ptr: NonNull<visage_graphics_sys::VisageCanvas>,
 }
@@ -98,9 +167,111 @@ impl Canvas {
         }
     }
 
-    pub fn submit(&mut self, submit_pass: i32) {
+    /// Returns false without submitting if idle frame elision found nothing changed.
+    pub fn submit(&mut self, submit_pass: i32) -> bool {
+        unsafe { visage_graphics_sys::VisageCanvas_submit(self.ptr.as_ptr(), submit_pass) }
+    }
+
+    /// Records draw calls into frames that the render thread replays and submits, so `submit`
+    /// returns without waiting for the driver. One render thread serves every canvas.
+    pub fn set_async_submit(&mut self, enabled: bool) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_setAsyncSubmit(self.ptr.as_ptr(), enabled);
+        }
+    }
+
+    pub fn is_async_submit(&self) -> bool {
+        unsafe { visage_graphics_sys::VisageCanvas_isAsyncSubmit(self.ptr.as_ptr()) }
+    }
+
+    pub fn set_frames_in_flight(&mut self, frames: u32) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_setFramesInFlight(self.ptr.as_ptr(), frames as i32);
+        }
+    }
+
+    /// Submits the frame and returns a fence that completes once it has been submitted.
+    pub fn submit_async(&mut self, submit_pass: i32) -> u64 {
+        unsafe { visage_graphics_sys::VisageCanvas_submitAsync(self.ptr.as_ptr(), submit_pass) }
+    }
+
+    pub fn is_fence_complete(&mut self, fence: u64) -> bool {
+        unsafe { visage_graphics_sys::VisageCanvas_isFenceComplete(self.ptr.as_ptr(), fence) }
+    }
+
+    pub fn wait_for_fence(&mut self, fence: u64) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_waitForFence(self.ptr.as_ptr(), fence);
+        }
+    }
+
+    pub fn wait_for_idle(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_waitForIdle(self.ptr.as_ptr());
+        }
+    }
+
+    /// Skips submitting frames that hash the same as the last submitted one at the same size and
+    /// dpi scale. Off by default, since hashing costs time on every draw call.
+    pub fn set_idle_frame_elision(&mut self, enabled: bool) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_setIdleFrameElision(self.ptr.as_ptr(), enabled);
+        }
+    }
+
+    /// Set while shaders drawn read the canvas time, so frames only skip if it is unchanged too.
+    pub fn set_time_dependent(&mut self, time_dependent: bool) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_setTimeDependent(self.ptr.as_ptr(), time_dependent);
+        }
+    }
+
+    pub fn frame_stats(&self) -> FrameStats {
+        let mut stats = visage_graphics_sys::VisageFrameStats {
+            commands: [0; NUM_COMMAND_TYPES],
+            lines: 0,
+            line_fills: 0,
+            texts: 0,
+            images: 0,
+            batches: 0,
+            draw_calls: 0,
+            text_glyphs: 0,
+            gradient_upload_bytes: 0,
+            glyph_upload_bytes: 0,
+            image_upload_bytes: 0,
+            frame_seconds: 0.0,
+            submit_seconds: 0.0,
+            peak_frame_bytes: 0,
+            elided: false,
+        };
+
+        unsafe {
+            visage_graphics_sys::VisageCanvas_getFrameStats(self.ptr.as_ptr(), &mut stats);
+        }
+
+        FrameStats {
+            commands: stats.commands,
+            lines: stats.lines,
+            line_fills: stats.line_fills,
+            texts: stats.texts,
+            images: stats.images,
+            batches: stats.batches,
+            draw_calls: stats.draw_calls,
+            text_glyphs: stats.text_glyphs,
+            gradient_upload_bytes: stats.gradient_upload_bytes,
+            glyph_upload_bytes: stats.glyph_upload_bytes,
+            image_upload_bytes: stats.image_upload_bytes,
+            frame_seconds: stats.frame_seconds,
+            submit_seconds: stats.submit_seconds,
+            peak_frame_bytes: stats.peak_frame_bytes,
+            elided: stats.elided,
+        }
+    }
+
+    /// Submits the next frame even if it looks unchanged.
+    pub fn request_redraw(&mut self) {
         unsafe {
-            visage_graphics_sys::VisageCanvas_submit(self.ptr.as_ptr(), submit_pass);
+            visage_graphics_sys::VisageCanvas_requestRedraw(self.ptr.as_ptr());
         }
     }
 
@@ -162,6 +333,12 @@ impl Canvas {
         }
     }
 
+    pub fn set_brush_id(&mut self, id: &BrushId) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_setBrushId(self.ptr.as_ptr(), id.raw());
+        }
+    }
+
     pub fn fill(&mut self, x: f32, y: f32, width: f32, height: f32) {
         unsafe {
             visage_graphics_sys::VisageCanvas_fill(self.ptr.as_ptr(), x, y, width, height);
@@ -217,6 +394,9 @@ impl Canvas {
             );
         }
     }
+    /// Arcs are drawn around the circle `width` across at `x`, `y`, `thickness` thick inside its
+    /// edge. `center_radians` is measured clockwise from straight up and the arc covers `radians`
+    /// on either side of it.
     pub fn rounded_arc(
         &mut self,
         x: f32,
@@ -389,6 +569,71 @@ impl Canvas {
             );
         }
     }
+
+    /// Draws one circle per index of the slices, colored from `argb` (`0xAARRGGBB`) if given.
+    /// Only as many circles as the shortest slice are drawn.
+    pub fn circles(&mut self, x: &[f32], y: &[f32], width: &[f32], argb: Option<&[u32]>) {
+        let count = instance_count(&[x.len(), y.len(), width.len()], argb);
+        unsafe {
+            visage_graphics_sys::VisageCanvas_circles(
+                self.ptr.as_ptr(),
+                x.as_ptr(),
+                y.as_ptr(),
+                width.as_ptr(),
+                argb.map_or(std::ptr::null(), |argb| argb.as_ptr()),
+                count as i32,
+            );
+        }
+    }
+
+    /// Draws one rectangle per index of the slices, like `circles`.
+    pub fn rectangles(
+        &mut self,
+        x: &[f32],
+        y: &[f32],
+        width: &[f32],
+        height: &[f32],
+        argb: Option<&[u32]>,
+    ) {
+        let count = instance_count(&[x.len(), y.len(), width.len(), height.len()], argb);
+        unsafe {
+            visage_graphics_sys::VisageCanvas_rectangles(
+                self.ptr.as_ptr(),
+                x.as_ptr(),
+                y.as_ptr(),
+                width.as_ptr(),
+                height.as_ptr(),
+                argb.map_or(std::ptr::null(), |argb| argb.as_ptr()),
+                count as i32,
+            );
+        }
+    }
+
+    /// Draws one rounded rectangle per index of the slices, like `circles`.
+    pub fn rounded_rectangles(
+        &mut self,
+        x: &[f32],
+        y: &[f32],
+        width: &[f32],
+        height: &[f32],
+        rounding: f32,
+        argb: Option<&[u32]>,
+    ) {
+        let count = instance_count(&[x.len(), y.len(), width.len(), height.len()], argb);
+        unsafe {
+            visage_graphics_sys::VisageCanvas_roundedRectangles(
+                self.ptr.as_ptr(),
+                x.as_ptr(),
+                y.as_ptr(),
+                width.as_ptr(),
+                height.as_ptr(),
+                rounding,
+                argb.map_or(std::ptr::null(), |argb| argb.as_ptr()),
+                count as i32,
+            );
+        }
+    }
+
     pub fn diamond(&mut self, x: f32, y: f32, width: f32, rounding: f32) {
         unsafe {
             visage_graphics_sys::VisageCanvas_diamond(self.ptr.as_ptr(), x, y, width, rounding);
@@ -629,6 +874,163 @@ impl Canvas {
         }
     }
 
+    pub fn line(&mut self, line: &Line, x: f32, y: f32, width: f32, height: f32, line_width: f32) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_line(
+                self.ptr.as_ptr(),
+                line.raw().as_ptr(),
+                x,
+                y,
+                width,
+                height,
+                line_width,
+            );
+        }
+    }
+
+    pub fn line_fill(
+        &mut self,
+        line: &Line,
+        x: f32,
+        y: f32,
+        width: f32,
+        height: f32,
+        fill_position: f32,
+    ) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_lineFill(
+                self.ptr.as_ptr(),
+                line.raw().as_ptr(),
+                x,
+                y,
+                width,
+                height,
+                fill_position,
+            );
+        }
+    }
+
+    /// Draws every series of `series` as one line per series, each with its own brush, leaving the
+    /// canvas's brush as it was.
+    pub fn line_series(
+        &mut self,
+        series: &mut LineSeries,
+        x: f32,
+        y: f32,
+        width: f32,
+        height: f32,
+        line_width: f32,
+    ) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_lineSeries(
+                self.ptr.as_ptr(),
+                series.raw().as_ptr(),
+                x,
+                y,
+                width,
+                height,
+                line_width,
+            );
+        }
+    }
+
+    /// Draws the newest window of samples pushed into `feed`.
+    pub fn line_feed(
+        &mut self,
+        feed: &mut LineFeed,
+        x: f32,
+        y: f32,
+        width: f32,
+        height: f32,
+        line_width: f32,
+    ) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_lineFeed(
+                self.ptr.as_ptr(),
+                feed.raw().as_ptr(),
+                x,
+                y,
+                width,
+                height,
+                line_width,
+            );
+        }
+    }
+
+    /// Draws `count` samples of `pyramid` from `start` stretched across `width`. Each draw keeps
+    /// its own copy of the points, so a pyramid can be drawn several times in a frame.
+    pub fn line_pyramid(
+        &mut self,
+        pyramid: &mut LinePyramid,
+        start: usize,
+        count: usize,
+        x: f32,
+        y: f32,
+        width: f32,
+        height: f32,
+        line_width: f32,
+    ) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_linePyramid(
+                self.ptr.as_ptr(),
+                pyramid.raw().as_ptr(),
+                start as i32,
+                count as i32,
+                x,
+                y,
+                width,
+                height,
+                line_width,
+            );
+        }
+    }
+
+    /// Draws `image` at its pixel size. Images are skipped while recording a display list.
+    pub fn image<P: ImagePixel>(&mut self, image: &mut Image<P>, x: f32, y: f32) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_image(self.ptr.as_ptr(), image.raw().as_ptr(), x, y);
+        }
+    }
+
+    /// Draws `svg` scaled to fit and centered, rasterizing it only if this size and dpi scale
+    /// isn't cached.
+    pub fn svg(&mut self, svg: &Svg, x: f32, y: f32, width: f32, height: f32) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_svg(
+                self.ptr.as_ptr(),
+                svg.raw().as_ptr(),
+                x,
+                y,
+                width,
+                height,
+            );
+        }
+    }
+
+    /// Draws one svg per index of the slices, rasterizing the missing ones in parallel first.
+    pub fn svgs(&mut self, svgs: &[&Svg], x: &[f32], y: &[f32], width: &[f32], height: &[f32]) {
+        let count = instance_count(
+            &[svgs.len(), x.len(), y.len(), width.len(), height.len()],
+            None,
+        );
+        let svgs: Vec<_> = svgs
+            .iter()
+            .map(|svg| svg.raw().as_ptr() as *const _)
+            .collect();
+
+        unsafe {
+            visage_graphics_sys::VisageCanvas_svgs(
+                self.ptr.as_ptr(),
+                svgs.as_ptr(),
+                x.as_ptr(),
+                y.as_ptr(),
+                width.as_ptr(),
+                height.as_ptr(),
+                count as i32,
+            );
+        }
+    }
+
     pub fn text(
         &mut self,
         text: &Text,
@@ -651,6 +1053,138 @@ impl Canvas {
         }
     }
 
+    pub fn draw_batch(&mut self, batch: &ShapeBatch) {
+        let commands = batch.commands();
+        let brushes = batch.brushes();
+
+        unsafe {
+            visage_graphics_sys::VisageCanvas_drawBatch(
+                self.ptr.as_ptr(),
+                commands.as_ptr(),
+                commands.len() as i32,
+                brushes.as_ptr(),
+                brushes.len() as i32,
+            );
+        }
+    }
+
+    /// Appends every draw call made on the canvas inside `f` to `list` instead of drawing it.
+    pub fn record<R>(&mut self, list: &mut DisplayList, f: impl FnOnce(&mut Self) -> R) -> R {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_beginRecording(
+                self.ptr.as_ptr(),
+                list.raw().as_ptr(),
+            );
+        }
+
+        let result = f(self);
+
+        unsafe {
+            visage_graphics_sys::VisageCanvas_endRecording(self.ptr.as_ptr());
+        }
+
+        result
+    }
+
+    /// Invalidates `layer` and draws every draw call made on the canvas inside `f` into it.
+    pub fn draw_into_layer<R>(&mut self, layer: &mut Layer, f: impl FnOnce(&mut Self) -> R) -> R {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_beginLayer(self.ptr.as_ptr(), layer.raw().as_ptr());
+        }
+
+        let result = f(self);
+
+        unsafe {
+            visage_graphics_sys::VisageCanvas_endRecording(self.ptr.as_ptr());
+        }
+
+        result
+    }
+
+    /// Composites `layer` at `x`, `y`, rasterizing it only if it has no pixels at this dpi scale.
+    pub fn draw_layer(&mut self, layer: &Layer, x: f32, y: f32) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_drawLayer(
+                self.ptr.as_ptr(),
+                layer.raw().as_ptr(),
+                x,
+                y,
+            );
+        }
+    }
+
+    pub fn draw_display_list(&mut self, list: &DisplayList, x: f32, y: f32) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_drawDisplayList(
+                self.ptr.as_ptr(),
+                list.raw().as_ptr(),
+                x,
+                y,
+            );
+        }
+    }
+
+    /// Keeps everything drawn since the last `clear_drawn_shapes` so it can be written with
+    /// `save_commands`.
+    pub fn set_command_capture(&mut self, capture: bool) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_setCommandCapture(self.ptr.as_ptr(), capture);
+        }
+    }
+
+    pub fn save_commands(&self, path: impl AsRef<Path>) -> bool {
+        let Ok(path) = CString::new(path.as_ref().to_string_lossy().as_bytes()) else {
+            return false;
+        };
+
+        unsafe { visage_graphics_sys::VisageCanvas_saveCommands(self.ptr.as_ptr(), path.as_ptr()) }
+    }
+
+    /// Creates a canvas that only records, to draw a panel on another thread. What it records is
+    /// drawn into this canvas when it submits, in order of `order` and then of creation.
+    ///
+    /// # Safety
+    /// Recording into the context has to be finished whenever this canvas submits, and the context
+    /// has to be dropped on the thread that owns this canvas.
+    pub unsafe fn recording_context(&mut self, order: i32) -> RecordingContext {
+        let ptr = unsafe {
+            NonNull::new(visage_graphics_sys::VisageCanvas_newRecordingContext(
+                self.ptr.as_ptr(),
+                order,
+            ))
+            .unwrap()
+        };
+
+        RecordingContext {
+            canvas: Canvas { ptr },
+        }
+    }
+
+    /// Draws what was captured since the last `clear_drawn_shapes` into `raster`. Returns false if
+    /// command capture isn't enabled.
+    pub fn rasterize_capture(&self, raster: &mut SoftwareRaster) -> bool {
+        unsafe {
+            visage_graphics_sys::VisageSoftwareRaster_drawCapture(
+                raster.raw().as_ptr(),
+                self.ptr.as_ptr(),
+            )
+        }
+    }
+
+    /// Draws a command stream written by `save_commands`.
+    ///
+    /// # Safety
+    /// `data` must be 8 byte aligned and stay alive until the next `clear_drawn_shapes`.
+    pub unsafe fn replay_mapped(&mut self, data: &[u8]) -> bool {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_replayMapped(
+                self.ptr.as_ptr(),
+                data.as_ptr().cast(),
+                data.len(),
+            )
+        }
+    }
+
     pub fn save_state(&mut self) {
         unsafe {
             visage_graphics_sys::VisageCanvas_saveState(self.ptr.as_ptr());
@@ -668,4 +1202,109 @@ impl Canvas {
             visage_graphics_sys::VisageCanvas_setPosition(self.ptr.as_ptr(), x, y);
         }
     }
+
+    pub fn set_clamp_bounds(&mut self, x: f32, y: f32, width: f32, height: f32) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_setClampBounds(
+                self.ptr.as_ptr(),
+                x,
+                y,
+                width,
+                height,
+            );
+        }
+    }
+
+    pub fn trim_clamp_bounds(&mut self, x: f32, y: f32, width: f32, height: f32) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_trimClampBounds(
+                self.ptr.as_ptr(),
+                x,
+                y,
+                width,
+                height,
+            );
+        }
+    }
+
+    /// Marks a rectangle in window coordinates for redraw until the next `submit`. This is only a
+    /// hint, queried with `is_rect_dirty`; every draw call is still drawn.
+    pub fn invalidate_rect(&mut self, x: f32, y: f32, width: f32, height: f32) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_invalidateRect(
+                self.ptr.as_ptr(),
+                x,
+                y,
+                width,
+                height,
+            );
+        }
+    }
+
+    pub fn is_rect_dirty(&self, x: f32, y: f32, width: f32, height: f32) -> bool {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_isRectDirty(self.ptr.as_ptr(), x, y, width, height)
+        }
+    }
+
+    /// The merged dirty rectangles as `[x, y, width, height]`.
+    pub fn dirty_rects(&self) -> Vec<[f32; 4]> {
+        unsafe {
+            let count = visage_graphics_sys::VisageCanvas_dirtyRects(
+                self.ptr.as_ptr(),
+                std::ptr::null_mut(),
+                0,
+            );
+            let mut rects = vec![[0.0; 4]; count as usize];
+            visage_graphics_sys::VisageCanvas_dirtyRects(
+                self.ptr.as_ptr(),
+                rects.as_mut_ptr().cast(),
+                count,
+            );
+            rects
+        }
+    }
+}
+
+/// A canvas that only records and is drawn into its parent when the parent submits. Contexts can
+/// be moved to other threads to record in parallel. Window, submit, time, capture and dirty rect
+/// calls do nothing on a context.
+pub struct RecordingContext {
+    canvas: Canvas,
+}
+
+unsafe impl Send for RecordingContext {}
+
+impl RecordingContext {
+    /// Places what the context records in its parent, clamped to the bounds unless they're empty.
+    pub fn set_bounds(&mut self, x: f32, y: f32, width: f32, height: f32) {
+        unsafe {
+            visage_graphics_sys::VisageCanvas_setRecordingBounds(
+                self.canvas.ptr.as_ptr(),
+                x,
+                y,
+                width,
+                height,
+            );
+        }
+    }
+}
+
+impl Deref for RecordingContext {
+    type Target = Canvas;
+
+    fn deref(&self) -> &Canvas {
+        &self.canvas
+    }
+}
+
+impl DerefMut for RecordingContext {
+    fn deref_mut(&mut self) -> &mut Canvas {
+        &mut self.canvas
+    }
+}
+
+fn instance_count(lengths: &[usize], argb: Option<&[u32]>) -> usize {
+    let count = lengths.iter().copied().min().unwrap_or(0);
+    argb.map_or(count, |argb| count.min(argb.len()))
 }
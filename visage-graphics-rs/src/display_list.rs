@@ -0,0 +1,46 @@
+use std::ptr::NonNull;
+
+/// Draw calls recorded with `Canvas::record` that can be replayed with `Canvas::draw_display_list`.
+pub struct DisplayList {
+    ptr: NonNull<visage_graphics_sys::VisageDisplayList>,
+}
+
+impl DisplayList {
+    pub fn new() -> Self {
+        let ptr = unsafe { NonNull::new(visage_graphics_sys::VisageDisplayList_new()).unwrap() };
+
+        Self { ptr }
+    }
+
+    pub fn clear(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageDisplayList_clear(self.ptr.as_ptr());
+        }
+    }
+
+    pub fn num_commands(&self) -> usize {
+        unsafe { visage_graphics_sys::VisageDisplayList_numCommands(self.ptr.as_ptr()) as usize }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.num_commands() == 0
+    }
+
+    pub fn raw(&self) -> NonNull<visage_graphics_sys::VisageDisplayList> {
+        self.ptr
+    }
+}
+
+impl Default for DisplayList {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for DisplayList {
+    fn drop(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageDisplayList_delete(self.ptr.as_ptr());
+        }
+    }
+}
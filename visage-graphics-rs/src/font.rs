@@ -1,3 +1,5 @@
+use std::ffi::CString;
+use std::path::Path;
 use std::ptr::NonNull;
 use std::rc::Rc;
 
@@ -98,33 +100,74 @@ impl Font {
         }
     }
 
-    pub fn line_breaks<const MAX_LINE_BREAKS: usize>(
-        &self,
-        str: &Utf32Str,
-        width: f32,
-    ) -> Vec<i32> {
-        let mut breaks: Vec<i32> = Vec::with_capacity(MAX_LINE_BREAKS);
-
-        unsafe {
-            let len = visage_graphics_sys::VisageFont_lineBreaks(
+    /// Writes the index each wrapped line starts at into `breaks` and returns the number of breaks,
+    /// which can be larger than `breaks.len()`. Doesn't allocate.
+    pub fn line_breaks_into(&self, str: &Utf32Str, width: f32, breaks: &mut [i32]) -> usize {
+        let len = unsafe {
+            visage_graphics_sys::VisageFont_lineBreaksInto(
                 self.inner.ptr.as_ptr(),
                 str.as_ptr(),
                 str.len() as i32,
                 width,
                 breaks.as_mut_ptr(),
-                MAX_LINE_BREAKS as i32,
-            );
-
-            assert!(len >= 0);
+                breaks.len().min(i32::MAX as usize) as i32,
+            )
+        };
 
-            if len as usize > MAX_LINE_BREAKS {
-                todo!();
-            }
+        assert!(len >= 0);
+        len as usize
+    }
 
-            breaks.set_len((len as usize).min(MAX_LINE_BREAKS));
+    /// Like `line_breaks_into` with a stack buffer of `MAX_LINE_BREAKS`, falling back to the heap
+    /// only for text that breaks more often.
+    pub fn line_breaks<const MAX_LINE_BREAKS: usize>(
+        &self,
+        str: &Utf32Str,
+        width: f32,
+    ) -> LineBreaks<MAX_LINE_BREAKS> {
+        let mut breaks = [0; MAX_LINE_BREAKS];
+        let len = self.line_breaks_into(str, width, &mut breaks);
+
+        if len <= MAX_LINE_BREAKS {
+            LineBreaks::Inline(breaks, len)
+        } else {
+            let mut breaks = vec![0; len];
+            let len = self.line_breaks_into(str, width, &mut breaks);
+            breaks.truncate(len);
+            LineBreaks::Heap(breaks)
         }
+    }
+
+    /// Breaks each of `strs` at the matching entry of `widths`. Breaks are written back to back into
+    /// `breaks`, `counts` receives the number per string. Returns the total number of breaks.
+    pub fn line_breaks_batch(
+        &self,
+        strs: &[&Utf32Str],
+        widths: &[f32],
+        breaks: &mut [i32],
+        counts: &mut [i32],
+    ) -> usize {
+        assert!(widths.len() >= strs.len());
+        assert!(counts.len() >= strs.len());
+
+        let strings: Vec<*const u32> = strs.iter().map(|s| s.as_ptr()).collect();
+        let lengths: Vec<i32> = strs.iter().map(|s| s.len() as i32).collect();
+
+        let len = unsafe {
+            visage_graphics_sys::VisageFont_lineBreaksBatch(
+                self.inner.ptr.as_ptr(),
+                strings.as_ptr(),
+                lengths.as_ptr(),
+                widths.as_ptr(),
+                strs.len() as i32,
+                breaks.as_mut_ptr(),
+                breaks.len().min(i32::MAX as usize) as i32,
+                counts.as_mut_ptr(),
+            )
+        };
 
-        breaks
+        assert!(len >= 0);
+        len as usize
     }
 
     pub fn string_width(&self, str: &Utf32Str, character_override: i32) -> f32 {
@@ -138,6 +181,101 @@ impl Font {
         }
     }
 
+    /// Measures every string in `strs` into `widths`, which must be at least as long.
+    pub fn string_widths(&self, strs: &[&Utf32Str], character_override: i32, widths: &mut [f32]) {
+        assert!(widths.len() >= strs.len());
+
+        let strings: Vec<*const u32> = strs.iter().map(|s| s.as_ptr()).collect();
+        let lengths: Vec<i32> = strs.iter().map(|s| s.len() as i32).collect();
+
+        unsafe {
+            visage_graphics_sys::VisageFont_stringWidths(
+                self.inner.ptr.as_ptr(),
+                strings.as_ptr(),
+                lengths.as_ptr(),
+                strs.len() as i32,
+                character_override,
+                widths.as_mut_ptr(),
+            );
+        }
+    }
+
+    /// Caches up to `capacity` string measurements, shared with clones of this font.
+    /// A capacity of 0 disables the cache.
+    pub fn set_measure_cache_capacity(&self, capacity: usize) {
+        unsafe {
+            visage_graphics_sys::VisageFont_setMeasureCacheCapacity(
+                self.inner.ptr.as_ptr(),
+                capacity.min(i32::MAX as usize) as i32,
+            );
+        }
+    }
+
+    pub fn clear_measure_cache(&self) {
+        unsafe {
+            visage_graphics_sys::VisageFont_clearMeasureCache(self.inner.ptr.as_ptr());
+        }
+    }
+
+    pub fn measure_cache_stats(&self) -> MeasureCacheStats {
+        let mut stats = visage_graphics_sys::VisageMeasureCacheStats {
+            hits: 0,
+            misses: 0,
+            entries: 0,
+            capacity: 0,
+        };
+
+        unsafe {
+            visage_graphics_sys::VisageFont_getMeasureCacheStats(
+                self.inner.ptr.as_ptr(),
+                &mut stats,
+            );
+        }
+
+        MeasureCacheStats {
+            hits: stats.hits,
+            misses: stats.misses,
+            entries: stats.entries as usize,
+            capacity: stats.capacity as usize,
+        }
+    }
+
+    /// Rasterizes `codepoints` and the glyphs in `presets` into the font's atlas ahead of time.
+    pub fn prewarm(&self, codepoints: &Utf32Str, presets: GlyphPresets) {
+        unsafe {
+            visage_graphics_sys::VisageFont_prewarm(
+                self.inner.ptr.as_ptr(),
+                codepoints.as_ptr(),
+                codepoints.len() as i32,
+            );
+
+            if !presets.is_empty() {
+                visage_graphics_sys::VisageFont_prewarmPreset(
+                    self.inner.ptr.as_ptr(),
+                    presets.bits(),
+                );
+            }
+        }
+    }
+
+    /// Prewarms several fonts in parallel on worker threads.
+    pub fn prewarm_all(fonts: &[&Font], codepoints: &Utf32Str, presets: GlyphPresets) {
+        let ptrs: Vec<*const visage_graphics_sys::VisageFont> = fonts
+            .iter()
+            .map(|font| font.inner.ptr.as_ptr() as *const _)
+            .collect();
+
+        unsafe {
+            visage_graphics_sys::VisageFont_prewarmFonts(
+                ptrs.as_ptr(),
+                ptrs.len() as i32,
+                codepoints.as_ptr(),
+                codepoints.len() as i32,
+                presets.bits(),
+            );
+        }
+    }
+
     pub fn line_height(&self) -> f32 {
         unsafe { visage_graphics_sys::VisageFont_lineHeight(self.inner.ptr.as_ptr()) }
     }
@@ -172,6 +310,94 @@ impl Font {
     }
 }
 
+bitflags::bitflags! {
+    #[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+    pub struct GlyphPresets: u32 {
+        const LATIN1 = visage_graphics_sys::VISAGE_GLYPH_PRESET_LATIN1;
+        const DIGITS = visage_graphics_sys::VISAGE_GLYPH_PRESET_DIGITS;
+        const UI_SYMBOLS = visage_graphics_sys::VISAGE_GLYPH_PRESET_UI_SYMBOLS;
+    }
+}
+
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct FontRegistryStats {
+    pub fonts: usize,
+    pub references: usize,
+    pub atlases: usize,
+}
+
+/// Fonts are interned by data, size and dpi scale, so identical fonts share glyph data and atlases.
+pub fn registry_stats() -> FontRegistryStats {
+    let mut stats = visage_graphics_sys::VisageFontRegistryStats {
+        fonts: 0,
+        references: 0,
+        atlases: 0,
+    };
+
+    unsafe {
+        visage_graphics_sys::VisageFontRegistry_getStats(&mut stats);
+    }
+
+    FontRegistryStats {
+        fonts: stats.fonts as usize,
+        references: stats.references as usize,
+        atlases: stats.atlases as usize,
+    }
+}
+
+/// Remembers the glyphs each font uses in `directory` so later runs can rasterize them up front
+/// with `prewarm_glyph_cache`. `None` disables it.
+pub fn set_glyph_cache_directory(directory: Option<&Path>) {
+    let directory = directory.and_then(|d| CString::new(d.to_string_lossy().as_bytes()).ok());
+
+    unsafe {
+        visage_graphics_sys::VisageGlyphCache_setDirectory(
+            directory.as_ref().map_or(std::ptr::null(), |d| d.as_ptr()),
+        );
+    }
+}
+
+/// Rasterizes the glyphs saved by a previous run for `fonts` on worker threads. Returns how many
+/// fonts had a cache file.
+pub fn prewarm_glyph_cache(fonts: &[&Font]) -> usize {
+    let ptrs: Vec<*const visage_graphics_sys::VisageFont> = fonts
+        .iter()
+        .map(|font| font.inner.ptr.as_ptr() as *const _)
+        .collect();
+
+    unsafe {
+        visage_graphics_sys::VisageGlyphCache_prewarm(ptrs.as_ptr(), ptrs.len() as i32) as usize
+    }
+}
+
+pub fn save_glyph_cache() -> bool {
+    unsafe { visage_graphics_sys::VisageGlyphCache_save() }
+}
+
+pub enum LineBreaks<const N: usize> {
+    Inline([i32; N], usize),
+    Heap(Vec<i32>),
+}
+
+impl<const N: usize> std::ops::Deref for LineBreaks<N> {
+    type Target = [i32];
+
+    fn deref(&self) -> &[i32] {
+        match self {
+            LineBreaks::Inline(breaks, len) => &breaks[..*len],
+            LineBreaks::Heap(breaks) => breaks,
+        }
+    }
+}
+
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct MeasureCacheStats {
+    pub hits: u64,
+    pub misses: u64,
+    pub entries: usize,
+    pub capacity: usize,
+}
+
 impl PartialEq for Font {
     fn eq(&self, other: &Self) -> bool {
         Rc::ptr_eq(&self.inner, &other.inner)
@@ -19,14 +19,22 @@ impl Gradient {
 
     pub fn from_colors(colors: &[Color]) -> Self {
         let mut new_self = Self::new();
+        new_self.set_colors(colors);
+        new_self
+    }
 
-        new_self.set_resolution(colors.len());
-
-        for (i, color) in colors.iter().enumerate() {
-            new_self.set_color(i, *color).unwrap();
+    /// Creates a gradient with one stop per `0xAARRGGBB` color.
+    pub fn from_packed_argb(argb: &[u32]) -> Self {
+        unsafe {
+            Self {
+                ptr: NonNull::new(visage_graphics_sys::VisageGradient_fromPackedARGB(
+                    argb.as_ptr(),
+                    argb.len() as i32,
+                ))
+                .unwrap(),
+                resolution: argb.len(),
+            }
         }
-
-        new_self
     }
 
     pub fn set_resolution(&mut self, resolution: usize) {
@@ -81,6 +89,34 @@ impl Gradient {
         Ok(())
     }
 
+    /// Sets the resolution to `colors.len()` and every stop in one call.
+    pub fn set_colors(&mut self, colors: &[Color]) {
+        self.resolution = colors.len();
+
+        // `Color` is a transparent wrapper around `VisageColor`.
+        unsafe {
+            visage_graphics_sys::VisageGradient_setColors(
+                self.ptr.as_ptr(),
+                colors.as_ptr() as *const visage_graphics_sys::VisageColor,
+                colors.len() as i32,
+            );
+        }
+    }
+
+    pub fn colors(&self) -> Vec<Color> {
+        let mut colors = vec![Color::TRANSPARENT; self.resolution];
+
+        unsafe {
+            visage_graphics_sys::VisageGradient_getColors(
+                self.ptr.as_ptr(),
+                colors.as_mut_ptr() as *mut visage_graphics_sys::VisageColor,
+                colors.len() as i32,
+            );
+        }
+
+        colors
+    }
+
     pub fn interpolate_with(&mut self, other: &Self, t: f32) {
         debug_assert!(t >= 0.0 && t <= 1.0);
 
@@ -132,19 +168,6 @@ impl Clone for Gradient {
 
 impl PartialEq for Gradient {
     fn eq(&self, other: &Self) -> bool {
-        if self.resolution != other.resolution {
-            return false;
-        }
-
-        for i in 0..self.resolution {
-            let color_a = self.color(i).unwrap();
-            let color_b = self.color(i).unwrap();
-
-            if color_a != color_b {
-                return false;
-            }
-        }
-
-        true
+        self.resolution == other.resolution && self.colors() == other.colors()
     }
 }
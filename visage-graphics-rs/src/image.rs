@@ -0,0 +1,128 @@
+use std::ptr::NonNull;
+
+/// Pixel types an `Image` can hold.
+pub trait ImagePixel: Copy + Default {
+    const FORMAT: i32;
+}
+
+/// `0xAARRGGBB`.
+impl ImagePixel for u32 {
+    const FORMAT: i32 = visage_graphics_sys::VisageImageFormat_VisageImageFormatARGB8 as i32;
+}
+
+/// Blue, green, red and alpha in `[0, 1]`, the channel order of `Color`.
+impl ImagePixel for [f32; 4] {
+    const FORMAT: i32 = visage_graphics_sys::VisageImageFormat_VisageImageFormatFloat as i32;
+}
+
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct ImageStats {
+    pub tiles: usize,
+    pub tile_uploads: u64,
+    pub uploaded_pixels: u64,
+}
+
+/// Pixels drawn with `Canvas::image`. The pixels stay in this buffer and only the areas reported
+/// with `update_rect` or `update_column` are uploaded again on the next draw.
+pub struct Image<P: ImagePixel> {
+    ptr: NonNull<visage_graphics_sys::VisageImage>,
+    pixels: Vec<P>,
+    width: usize,
+    height: usize,
+}
+
+impl<P: ImagePixel> Image<P> {
+    pub fn new(width: usize, height: usize) -> Self {
+        let pixels = vec![P::default(); width * height];
+        let ptr = unsafe {
+            NonNull::new(visage_graphics_sys::VisageImage_new(
+                pixels.as_ptr() as *const _,
+                P::FORMAT,
+                width as i32,
+                height as i32,
+                0,
+            ))
+            .unwrap()
+        };
+
+        Self {
+            ptr,
+            pixels,
+            width,
+            height,
+        }
+    }
+
+    pub fn width(&self) -> usize {
+        self.width
+    }
+
+    pub fn height(&self) -> usize {
+        self.height
+    }
+
+    /// The pixels, row after row. Report what was changed with `update_rect` or `update_column`.
+    pub fn pixels_mut(&mut self) -> &mut [P] {
+        &mut self.pixels
+    }
+
+    pub fn update_rect(&mut self, x: usize, y: usize, width: usize, height: usize) {
+        unsafe {
+            visage_graphics_sys::VisageImage_updateRect(
+                self.ptr.as_ptr(),
+                x as i32,
+                y as i32,
+                width as i32,
+                height as i32,
+            );
+        }
+    }
+
+    pub fn update_column(&mut self, x: usize) {
+        unsafe {
+            visage_graphics_sys::VisageImage_updateColumn(self.ptr.as_ptr(), x as i32);
+        }
+    }
+
+    /// Draws the image rotated left by `offset` columns, so a scrolling view can overwrite its
+    /// oldest column instead of shifting every pixel.
+    pub fn set_scroll_offset(&mut self, offset: usize) {
+        unsafe {
+            visage_graphics_sys::VisageImage_setScrollOffset(self.ptr.as_ptr(), offset as i32);
+        }
+    }
+
+    pub fn scroll_offset(&self) -> usize {
+        unsafe { visage_graphics_sys::VisageImage_getScrollOffset(self.ptr.as_ptr()) as usize }
+    }
+
+    pub fn stats(&self) -> ImageStats {
+        let mut stats = visage_graphics_sys::VisageImageStats {
+            tiles: 0,
+            tile_uploads: 0,
+            uploaded_pixels: 0,
+        };
+
+        unsafe {
+            visage_graphics_sys::VisageImage_getStats(self.ptr.as_ptr(), &mut stats);
+        }
+
+        ImageStats {
+            tiles: stats.tiles as usize,
+            tile_uploads: stats.tile_uploads,
+            uploaded_pixels: stats.uploaded_pixels,
+        }
+    }
+
+    pub fn raw(&self) -> NonNull<visage_graphics_sys::VisageImage> {
+        self.ptr
+    }
+}
+
+impl<P: ImagePixel> Drop for Image<P> {
+    fn drop(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageImage_delete(self.ptr.as_ptr());
+        }
+    }
+}
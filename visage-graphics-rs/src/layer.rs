@@ -0,0 +1,87 @@
+use std::ptr::NonNull;
+
+/// A cached layer for content that rarely changes. Draw into it with `Canvas::draw_into_layer` and
+/// composite it with `Canvas::draw_layer`; it is rasterized once per dpi scale and then only its
+/// pixels are drawn until it is invalidated. Text is drawn over the pixels on every composite. A
+/// layer that draws anything after text is replayed on every composite instead of rasterized.
+pub struct Layer {
+    ptr: NonNull<visage_graphics_sys::VisageLayer>,
+}
+
+impl Layer {
+    pub fn new(width: f32, height: f32) -> Self {
+        let ptr =
+            unsafe { NonNull::new(visage_graphics_sys::VisageLayer_new(width, height)).unwrap() };
+
+        Self { ptr }
+    }
+
+    /// Drops what was drawn into the layer, which isn't composited until it is drawn again.
+    pub fn invalidate(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageLayer_invalidate(self.ptr.as_ptr());
+        }
+    }
+
+    /// True if the layer has been drawn since it was created or invalidated.
+    pub fn is_valid(&self) -> bool {
+        unsafe { visage_graphics_sys::VisageLayer_isValid(self.ptr.as_ptr()) }
+    }
+
+    pub fn raw(&self) -> NonNull<visage_graphics_sys::VisageLayer> {
+        self.ptr
+    }
+}
+
+impl Drop for Layer {
+    fn drop(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageLayer_delete(self.ptr.as_ptr());
+        }
+    }
+}
+
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct LayerCacheStats {
+    pub layers: usize,
+    pub resident: usize,
+    pub bytes: u64,
+    pub budget: u64,
+    pub rasterizations: u64,
+    pub evictions: u64,
+    pub composites: u64,
+}
+
+/// Sets the budget for layer pixels, 128 MiB by default. Evicted layers are rasterized again the
+/// next time they are composited.
+pub fn set_cache_budget(bytes: usize) {
+    unsafe {
+        visage_graphics_sys::VisageLayerCache_setBudget(bytes);
+    }
+}
+
+pub fn cache_stats() -> LayerCacheStats {
+    let mut stats = visage_graphics_sys::VisageLayerCacheStats {
+        layers: 0,
+        resident: 0,
+        bytes: 0,
+        budget: 0,
+        rasterizations: 0,
+        evictions: 0,
+        composites: 0,
+    };
+
+    unsafe {
+        visage_graphics_sys::VisageLayerCache_getStats(&mut stats);
+    }
+
+    LayerCacheStats {
+        layers: stats.layers as usize,
+        resident: stats.resident as usize,
+        bytes: stats.bytes,
+        budget: stats.budget,
+        rasterizations: stats.rasterizations,
+        evictions: stats.evictions,
+        composites: stats.composites,
+    }
+}
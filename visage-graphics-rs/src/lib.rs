@@ -1,6 +1,16 @@
+pub mod batch;
 pub mod brush;
 pub mod canvas;
 pub mod color;
+pub mod display_list;
 pub mod font;
 pub mod gradient;
+pub mod image;
+pub mod layer;
+pub mod line;
+pub mod line_feed;
+pub mod line_pyramid;
+pub mod line_series;
+pub mod software_raster;
+pub mod svg;
 pub mod text;
@@ -0,0 +1,162 @@
+use std::ptr::NonNull;
+
+/// Which of a line's per-point arrays to fill with `Line::set_from_strided`.
+#[repr(i32)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum LineChannel {
+    X = visage_graphics_sys::VisageLineChannel_VisageLineChannelX as i32,
+    Y = visage_graphics_sys::VisageLineChannel_VisageLineChannelY as i32,
+    Values = visage_graphics_sys::VisageLineChannel_VisageLineChannelValues as i32,
+}
+
+/// Sample types `Line::set_from_strided` converts from.
+pub trait Sample: Copy {
+    const TYPE: i32;
+}
+
+impl Sample for f32 {
+    const TYPE: i32 = visage_graphics_sys::VisageSampleType_VisageSampleTypeFloat32 as i32;
+}
+
+impl Sample for f64 {
+    const TYPE: i32 = visage_graphics_sys::VisageSampleType_VisageSampleTypeFloat64 as i32;
+}
+
+impl Sample for i16 {
+    const TYPE: i32 = visage_graphics_sys::VisageSampleType_VisageSampleTypeInt16 as i32;
+}
+
+impl Sample for i32 {
+    const TYPE: i32 = visage_graphics_sys::VisageSampleType_VisageSampleTypeInt32 as i32;
+}
+
+pub struct Line {
+    ptr: NonNull<visage_graphics_sys::VisageLine>,
+}
+
+impl Line {
+    pub fn new(points: usize) -> Self {
+        let ptr =
+            unsafe { NonNull::new(visage_graphics_sys::VisageLine_new(points as i32)).unwrap() };
+
+        Self { ptr }
+    }
+
+    pub fn num_points(&self) -> usize {
+        unsafe { visage_graphics_sys::VisageLine_getNumPoints(self.ptr.as_ptr()) as usize }
+    }
+
+    pub fn set_num_points(&mut self, points: usize) {
+        unsafe {
+            visage_graphics_sys::VisageLine_setNumPoints(self.ptr.as_ptr(), points as i32);
+        }
+    }
+
+    pub fn line_value_scale(&self) -> f32 {
+        unsafe { visage_graphics_sys::VisageLine_getLineValueScale(self.ptr.as_ptr()) }
+    }
+
+    pub fn set_line_value_scale(&mut self, line_value_scale: f32) {
+        unsafe {
+            visage_graphics_sys::VisageLine_setLineValueScale(self.ptr.as_ptr(), line_value_scale);
+        }
+    }
+
+    pub fn fill_value_scale(&self) -> f32 {
+        unsafe { visage_graphics_sys::VisageLine_getFillValueScale(self.ptr.as_ptr()) }
+    }
+
+    pub fn set_fill_value_scale(&mut self, fill_value_scale: f32) {
+        unsafe {
+            visage_graphics_sys::VisageLine_setFillValueScale(self.ptr.as_ptr(), fill_value_scale);
+        }
+    }
+
+    pub fn x_values_mut(&mut self) -> &mut [f32] {
+        let len = self.num_points();
+        unsafe {
+            slice_or_empty(
+                visage_graphics_sys::VisageLine_xValues(self.ptr.as_ptr()),
+                len,
+            )
+        }
+    }
+
+    pub fn y_values_mut(&mut self) -> &mut [f32] {
+        let len = self.num_points();
+        unsafe {
+            slice_or_empty(
+                visage_graphics_sys::VisageLine_yValues(self.ptr.as_ptr()),
+                len,
+            )
+        }
+    }
+
+    pub fn values_mut(&mut self) -> &mut [f32] {
+        let len = self.num_points();
+        unsafe {
+            slice_or_empty(
+                visage_graphics_sys::VisageLine_values(self.ptr.as_ptr()),
+                len,
+            )
+        }
+    }
+
+    /// Fills `channel` with every `stride`th sample of `data` as `sample * scale + offset`, so
+    /// `&xy[1..]` with a stride of 2 reads the y of interleaved pairs. Returns how many points were
+    /// written, which is at most the number of points in the line.
+    pub fn set_from_strided<T: Sample>(
+        &mut self,
+        channel: LineChannel,
+        data: &[T],
+        stride: usize,
+        scale: f32,
+        offset: f32,
+    ) -> usize {
+        let stride = stride.max(1);
+        let count = data.len().div_ceil(stride);
+
+        unsafe {
+            visage_graphics_sys::VisageLine_setFromStrided(
+                self.ptr.as_ptr(),
+                channel as i32,
+                data.as_ptr() as *const _,
+                T::TYPE,
+                (stride * std::mem::size_of::<T>()) as i32,
+                count as i32,
+                scale,
+                offset,
+            ) as usize
+        }
+    }
+
+    pub fn raw(&self) -> NonNull<visage_graphics_sys::VisageLine> {
+        self.ptr
+    }
+}
+
+pub(crate) unsafe fn slice_or_empty<'a>(ptr: *mut f32, len: usize) -> &'a mut [f32] {
+    if ptr.is_null() {
+        &mut []
+    } else {
+        unsafe { std::slice::from_raw_parts_mut(ptr, len) }
+    }
+}
+
+impl Clone for Line {
+    fn clone(&self) -> Self {
+        unsafe {
+            Self {
+                ptr: NonNull::new(visage_graphics_sys::VisageLine_copy(self.ptr.as_ptr())).unwrap(),
+            }
+        }
+    }
+}
+
+impl Drop for Line {
+    fn drop(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageLine_delete(self.ptr.as_ptr());
+        }
+    }
+}
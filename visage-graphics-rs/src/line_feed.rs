@@ -0,0 +1,115 @@
+use std::{ptr::NonNull, sync::Arc};
+
+struct FeedHandle {
+    ptr: NonNull<visage_graphics_sys::VisageLineFeed>,
+}
+
+// The feed is only ever touched through `LineFeedWriter` on the producer thread and `LineFeed` on
+// the drawing thread, which is the split the C side is built for.
+unsafe impl Send for FeedHandle {}
+unsafe impl Sync for FeedHandle {}
+
+impl Drop for FeedHandle {
+    fn drop(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageLineFeed_delete(self.ptr.as_ptr());
+        }
+    }
+}
+
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct LineFeedStats {
+    pub pushed: u64,
+    /// Samples pushed while the ring was full, which were discarded.
+    pub dropped: u64,
+    /// Pushes that dropped at least one sample.
+    pub overruns: u64,
+    /// Samples pushed since the feed was last drawn.
+    pub pending: u64,
+    pub capacity: usize,
+    pub window: usize,
+}
+
+/// The drawing side of a lock-free sample feed, drawn with `Canvas::line_feed`.
+pub struct LineFeed {
+    handle: Arc<FeedHandle>,
+}
+
+/// The producer side of a `LineFeed`. Pushing never locks, allocates or waits, so it can be moved
+/// to an audio thread.
+pub struct LineFeedWriter {
+    handle: Arc<FeedHandle>,
+}
+
+impl LineFeed {
+    /// Creates a feed drawing `window` points with room for at least `capacity` samples.
+    pub fn new(window: usize, capacity: usize) -> (LineFeedWriter, LineFeed) {
+        let ptr = unsafe {
+            NonNull::new(visage_graphics_sys::VisageLineFeed_new(
+                window as i32,
+                capacity as i32,
+            ))
+            .unwrap()
+        };
+        let handle = Arc::new(FeedHandle { ptr });
+
+        (
+            LineFeedWriter {
+                handle: handle.clone(),
+            },
+            LineFeed { handle },
+        )
+    }
+
+    /// Sets the sample values mapped to the bottom and top of the drawn line.
+    pub fn set_value_range(&mut self, min_value: f32, max_value: f32) {
+        unsafe {
+            visage_graphics_sys::VisageLineFeed_setValueRange(
+                self.handle.ptr.as_ptr(),
+                min_value,
+                max_value,
+            );
+        }
+    }
+
+    pub fn stats(&self) -> LineFeedStats {
+        let mut stats = visage_graphics_sys::VisageLineFeedStats {
+            pushed: 0,
+            dropped: 0,
+            overruns: 0,
+            pending: 0,
+            capacity: 0,
+            window: 0,
+        };
+
+        unsafe {
+            visage_graphics_sys::VisageLineFeed_getStats(self.handle.ptr.as_ptr(), &mut stats);
+        }
+
+        LineFeedStats {
+            pushed: stats.pushed,
+            dropped: stats.dropped,
+            overruns: stats.overruns,
+            pending: stats.pending,
+            capacity: stats.capacity as usize,
+            window: stats.window as usize,
+        }
+    }
+
+    pub fn raw(&self) -> NonNull<visage_graphics_sys::VisageLineFeed> {
+        self.handle.ptr
+    }
+}
+
+impl LineFeedWriter {
+    /// Pushes samples and returns how many fit; the rest are counted as dropped.
+    pub fn push(&mut self, samples: &[f32]) -> usize {
+        unsafe {
+            visage_graphics_sys::VisageLineFeed_push(
+                self.handle.ptr.as_ptr(),
+                samples.as_ptr(),
+                samples.len() as i32,
+            ) as usize
+        }
+    }
+}
@@ -0,0 +1,72 @@
+use std::ptr::NonNull;
+
+/// A long series of samples with a min/max pyramid over it, drawn with `Canvas::line_pyramid` at
+/// a cost that depends on the drawn width rather than the number of samples.
+pub struct LinePyramid {
+    ptr: NonNull<visage_graphics_sys::VisageLinePyramid>,
+}
+
+impl LinePyramid {
+    pub fn new() -> Self {
+        let ptr = unsafe { NonNull::new(visage_graphics_sys::VisageLinePyramid_new()).unwrap() };
+
+        Self { ptr }
+    }
+
+    /// Copies `samples` and rebuilds the whole pyramid.
+    pub fn set_samples(&mut self, samples: &[f32]) {
+        unsafe {
+            visage_graphics_sys::VisageLinePyramid_setSamples(
+                self.ptr.as_ptr(),
+                samples.as_ptr(),
+                samples.len() as i32,
+            );
+        }
+    }
+
+    /// Overwrites samples from `start`, refreshing only the part of the pyramid covering them.
+    /// Samples past the current end are ignored.
+    pub fn update_samples(&mut self, start: usize, samples: &[f32]) {
+        unsafe {
+            visage_graphics_sys::VisageLinePyramid_updateSamples(
+                self.ptr.as_ptr(),
+                start as i32,
+                samples.as_ptr(),
+                samples.len() as i32,
+            );
+        }
+    }
+
+    pub fn num_samples(&self) -> usize {
+        unsafe { visage_graphics_sys::VisageLinePyramid_numSamples(self.ptr.as_ptr()) as usize }
+    }
+
+    /// Sets the sample values mapped to the bottom and top of the drawn line.
+    pub fn set_value_range(&mut self, min_value: f32, max_value: f32) {
+        unsafe {
+            visage_graphics_sys::VisageLinePyramid_setValueRange(
+                self.ptr.as_ptr(),
+                min_value,
+                max_value,
+            );
+        }
+    }
+
+    pub fn raw(&self) -> NonNull<visage_graphics_sys::VisageLinePyramid> {
+        self.ptr
+    }
+}
+
+impl Default for LinePyramid {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for LinePyramid {
+    fn drop(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageLinePyramid_delete(self.ptr.as_ptr());
+        }
+    }
+}
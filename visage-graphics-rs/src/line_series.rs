@@ -0,0 +1,91 @@
+use std::ptr::NonNull;
+
+use crate::{brush::Brush, line::slice_or_empty};
+
+/// Several lines sharing one set of x values, drawn together with `Canvas::line_series`.
+pub struct LineSeries {
+    ptr: NonNull<visage_graphics_sys::VisageLineSeries>,
+}
+
+impl LineSeries {
+    pub fn new(num_series: usize, points: usize) -> Self {
+        let ptr = unsafe {
+            NonNull::new(visage_graphics_sys::VisageLineSeries_new(
+                num_series as i32,
+                points as i32,
+            ))
+            .unwrap()
+        };
+
+        Self { ptr }
+    }
+
+    pub fn num_series(&self) -> usize {
+        unsafe { visage_graphics_sys::VisageLineSeries_getNumSeries(self.ptr.as_ptr()) as usize }
+    }
+
+    pub fn num_points(&self) -> usize {
+        unsafe { visage_graphics_sys::VisageLineSeries_getNumPoints(self.ptr.as_ptr()) as usize }
+    }
+
+    /// Resizes every series and resets all values to 0.
+    pub fn set_num_points(&mut self, points: usize) {
+        unsafe {
+            visage_graphics_sys::VisageLineSeries_setNumPoints(self.ptr.as_ptr(), points as i32);
+        }
+    }
+
+    /// The x values shared by every series.
+    pub fn x_values_mut(&mut self) -> &mut [f32] {
+        let len = self.num_points();
+        unsafe {
+            slice_or_empty(
+                visage_graphics_sys::VisageLineSeries_xValues(self.ptr.as_ptr()),
+                len,
+            )
+        }
+    }
+
+    /// The y values of every series, one series after another.
+    pub fn y_values_mut(&mut self) -> &mut [f32] {
+        let len = self.num_points() * self.num_series();
+        unsafe {
+            slice_or_empty(
+                visage_graphics_sys::VisageLineSeries_yValues(self.ptr.as_ptr()),
+                len,
+            )
+        }
+    }
+
+    /// The y values of the series at `index`.
+    pub fn series_values_mut(&mut self, index: usize) -> &mut [f32] {
+        assert!(index < self.num_series());
+        let len = self.num_points();
+        unsafe {
+            slice_or_empty(
+                visage_graphics_sys::VisageLineSeries_seriesValues(self.ptr.as_ptr(), index as i32),
+                len,
+            )
+        }
+    }
+
+    /// Sets the brush the series at `index` is drawn with, or `None` to use the canvas's brush.
+    pub fn set_brush(&mut self, index: usize, brush: Option<&Brush>) {
+        let brush = brush.map_or(std::ptr::null(), |brush| brush.raw().as_ptr() as *const _);
+        unsafe {
+            visage_graphics_sys::VisageLineSeries_setBrush(self.ptr.as_ptr(), index as i32, brush);
+        }
+    }
+
+    pub fn raw(&self) -> NonNull<visage_graphics_sys::VisageLineSeries> {
+        self.ptr
+    }
+}
+
+impl Drop for LineSeries {
+    fn drop(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageLineSeries_delete(self.ptr.as_ptr());
+        }
+    }
+}
@@ -0,0 +1,109 @@
+use std::ptr::NonNull;
+
+use crate::display_list::DisplayList;
+
+#[derive(Debug, Default, Clone, Copy, PartialEq)]
+pub struct SoftwareRasterStats {
+    pub tiles: usize,
+    pub shapes: usize,
+    pub skipped: usize,
+    pub tile_shapes: u64,
+    pub seconds: f64,
+}
+
+/// A CPU framebuffer that display lists and captured canvas commands can be drawn into without a
+/// GPU. Text is skipped.
+pub struct SoftwareRaster {
+    ptr: NonNull<visage_graphics_sys::VisageSoftwareRaster>,
+}
+
+impl SoftwareRaster {
+    pub fn new(width: usize, height: usize) -> Self {
+        let ptr = unsafe {
+            NonNull::new(visage_graphics_sys::VisageSoftwareRaster_new(
+                width as i32,
+                height as i32,
+            ))
+            .unwrap()
+        };
+
+        Self { ptr }
+    }
+
+    pub fn width(&self) -> usize {
+        unsafe { visage_graphics_sys::VisageSoftwareRaster_width(self.ptr.as_ptr()) as usize }
+    }
+
+    pub fn height(&self) -> usize {
+        unsafe { visage_graphics_sys::VisageSoftwareRaster_height(self.ptr.as_ptr()) as usize }
+    }
+
+    pub fn set_scale(&mut self, scale: f32) {
+        unsafe {
+            visage_graphics_sys::VisageSoftwareRaster_setScale(self.ptr.as_ptr(), scale);
+        }
+    }
+
+    pub fn clear(&mut self, argb: u32) {
+        unsafe {
+            visage_graphics_sys::VisageSoftwareRaster_clear(self.ptr.as_ptr(), argb);
+        }
+    }
+
+    pub fn draw_display_list(&mut self, list: &DisplayList, x: f32, y: f32) {
+        unsafe {
+            visage_graphics_sys::VisageSoftwareRaster_drawDisplayList(
+                self.ptr.as_ptr(),
+                list.raw().as_ptr(),
+                x,
+                y,
+            );
+        }
+    }
+
+    /// 0xAARRGGBB pixels, row by row.
+    pub fn pixels(&mut self) -> &[u32] {
+        let len = self.width() * self.height();
+        unsafe {
+            let pixels = visage_graphics_sys::VisageSoftwareRaster_pixels(self.ptr.as_ptr());
+            if pixels.is_null() || len == 0 {
+                return &[];
+            }
+            std::slice::from_raw_parts(pixels, len)
+        }
+    }
+
+    pub fn stats(&self) -> SoftwareRasterStats {
+        let mut stats = visage_graphics_sys::VisageSoftwareRasterStats {
+            tiles: 0,
+            shapes: 0,
+            skipped: 0,
+            tile_shapes: 0,
+            seconds: 0.0,
+        };
+
+        unsafe {
+            visage_graphics_sys::VisageSoftwareRaster_getStats(self.ptr.as_ptr(), &mut stats);
+        }
+
+        SoftwareRasterStats {
+            tiles: stats.tiles as usize,
+            shapes: stats.shapes as usize,
+            skipped: stats.skipped as usize,
+            tile_shapes: stats.tile_shapes as u64,
+            seconds: stats.seconds,
+        }
+    }
+
+    pub fn raw(&self) -> NonNull<visage_graphics_sys::VisageSoftwareRaster> {
+        self.ptr
+    }
+}
+
+impl Drop for SoftwareRaster {
+    fn drop(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageSoftwareRaster_delete(self.ptr.as_ptr());
+        }
+    }
+}
@@ -0,0 +1,118 @@
+use std::{ffi::CString, path::Path, ptr::NonNull};
+
+/// A parsed SVG document drawn with `Canvas::svg`. Rasterized results are kept in a shared cache
+/// keyed by the svg and its pixel size.
+pub struct Svg {
+    ptr: NonNull<visage_graphics_sys::VisageSvg>,
+}
+
+impl Svg {
+    /// Parses `data`, returning `None` if it isn't a valid SVG.
+    pub fn new(data: &[u8]) -> Option<Self> {
+        let ptr = unsafe {
+            visage_graphics_sys::VisageSvg_new(data.as_ptr() as *const _, data.len() as i32)
+        };
+
+        NonNull::new(ptr).map(|ptr| Self { ptr })
+    }
+
+    pub fn from_file(path: impl AsRef<Path>) -> Option<Self> {
+        let path = CString::new(path.as_ref().to_string_lossy().as_bytes()).ok()?;
+        let ptr = unsafe { visage_graphics_sys::VisageSvg_fromFile(path.as_ptr()) };
+
+        NonNull::new(ptr).map(|ptr| Self { ptr })
+    }
+
+    /// The document's own width and height.
+    pub fn dimensions(&self) -> (f32, f32) {
+        let mut width = 0.0;
+        let mut height = 0.0;
+        unsafe {
+            visage_graphics_sys::VisageSvg_getDimensions(
+                self.ptr.as_ptr(),
+                &mut width,
+                &mut height,
+            );
+        }
+        (width, height)
+    }
+
+    pub fn raw(&self) -> NonNull<visage_graphics_sys::VisageSvg> {
+        self.ptr
+    }
+}
+
+impl Drop for Svg {
+    fn drop(&mut self) {
+        unsafe {
+            visage_graphics_sys::VisageSvg_delete(self.ptr.as_ptr());
+        }
+    }
+}
+
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct SvgCacheStats {
+    pub hits: u64,
+    pub misses: u64,
+    pub evictions: u64,
+    pub bytes: u64,
+    pub capacity: u64,
+    pub entries: usize,
+}
+
+/// Sets the budget for rasterized svg pixels, 64 MiB by default.
+pub fn set_cache_capacity(bytes: usize) {
+    unsafe {
+        visage_graphics_sys::VisageSvgCache_setCapacity(bytes);
+    }
+}
+
+pub fn clear_cache() {
+    unsafe {
+        visage_graphics_sys::VisageSvgCache_clear();
+    }
+}
+
+pub fn cache_stats() -> SvgCacheStats {
+    let mut stats = visage_graphics_sys::VisageSvgCacheStats {
+        hits: 0,
+        misses: 0,
+        evictions: 0,
+        bytes: 0,
+        capacity: 0,
+        entries: 0,
+    };
+
+    unsafe {
+        visage_graphics_sys::VisageSvgCache_getStats(&mut stats);
+    }
+
+    SvgCacheStats {
+        hits: stats.hits,
+        misses: stats.misses,
+        evictions: stats.evictions,
+        bytes: stats.bytes,
+        capacity: stats.capacity,
+        entries: stats.entries as usize,
+    }
+}
+
+/// Rasterizes each `(svg, width, height)` at `dpi_scale` that isn't cached yet, in parallel.
+pub fn prewarm(icons: &[(&Svg, f32, f32)], dpi_scale: f32) {
+    let svgs: Vec<_> = icons
+        .iter()
+        .map(|(svg, _, _)| svg.raw().as_ptr() as *const _)
+        .collect();
+    let widths: Vec<f32> = icons.iter().map(|icon| icon.1).collect();
+    let heights: Vec<f32> = icons.iter().map(|icon| icon.2).collect();
+
+    unsafe {
+        visage_graphics_sys::VisageSvgCache_prewarm(
+            svgs.as_ptr(),
+            widths.as_ptr(),
+            heights.as_ptr(),
+            icons.len() as i32,
+            dpi_scale,
+        );
+    }
+}
@@ -56,6 +56,28 @@ impl Text {
         }
     }
 
+    pub fn set_text_str(&mut self, s: &str) {
+        unsafe {
+            visage_graphics_sys::VisageText_setTextWithLength(
+                self.ptr.as_ptr(),
+                s.as_ptr().cast(),
+                s.len() as i32,
+            );
+        }
+    }
+
+    /// Skips the update if `s` is the same as the last `&str` set. Returns true if the text
+    /// was updated.
+    pub fn set_text_if_changed(&mut self, s: &str) -> bool {
+        unsafe {
+            visage_graphics_sys::VisageText_setTextIfChanged(
+                self.ptr.as_ptr(),
+                s.as_ptr().cast(),
+                s.len() as i32,
+            )
+        }
+    }
+
     pub fn text(&self) -> &Utf32Str {
         unsafe {
             let mut string_length = 0;
@@ -72,6 +94,10 @@ impl Text {
         }
     }
 
+    pub fn font(&self) -> &Font {
+        &self.font
+    }
+
     pub fn set_font(&mut self, font: &Font) {
         if &self.font == font {
             return;